@@ -89,7 +89,7 @@ html_a11y_hyper_link_get_start_index (AtkHyperlink *link)
 {
 	HTMLA11YHyperLink *hl = HTML_A11Y_HYPER_LINK (link);
 	HTMLText *text = HTML_TEXT (HTML_A11Y_HTML (hl->a11y.object));
-	Link *a = (Link *) g_slist_nth_data (text->links, hl->num);
+	Link *a = html_text_get_nth_link (text, hl->num);
 	return a ? a->start_offset : -1;
 }
 
@@ -97,7 +97,7 @@ static gint
 html_a11y_hyper_link_get_end_index (AtkHyperlink *link)
 {
 	HTMLA11YHyperLink *hl = HTML_A11Y_HYPER_LINK (link);
-	Link *a = (Link *) g_slist_nth_data (HTML_TEXT (HTML_A11Y_HTML (hl->a11y.object))->links, hl->num);
+	Link *a = html_text_get_nth_link (HTML_TEXT (HTML_A11Y_HTML (hl->a11y.object)), hl->num);
 	return a ? a->end_offset : -1;
 }
 
@@ -131,7 +131,7 @@ html_a11y_hyper_link_new (HTMLA11Y *a11y,
 
 	hl->a11y.object = a11y;
 	hl->num = link_index;
-	hl->offset = ((Link *) g_slist_nth_data (HTML_TEXT (HTML_A11Y_HTML (a11y))->links, link_index))->start_offset;
+	hl->offset = html_text_get_nth_link (HTML_TEXT (HTML_A11Y_HTML (a11y)), link_index)->start_offset;
 	g_object_add_weak_pointer (G_OBJECT (hl->a11y.object), &hl->a11y.weakref);
 
 	return ATK_HYPERLINK (hl);
@@ -83,6 +83,10 @@ struct _GtkHTMLPrivate {
 
 	GtkAdjustment *hadjustment;
 	GtkAdjustment *vadjustment;
+
+	HTMLPrintPreview *page_images;
+	GtkHTMLPageImageFunc page_image_func;
+	gpointer page_image_data;
 };
 
 void  gtk_html_private_calc_scrollbars  (GtkHTML                *html,
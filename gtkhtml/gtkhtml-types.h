@@ -44,6 +44,7 @@ typedef struct _GtkHTMLEditorAPI GtkHTMLEditorAPI;
 typedef struct _GtkHTMLEmbedded GtkHTMLEmbedded;
 typedef struct _GtkHTMLEmbeddedClass GtkHTMLEmbeddedClass;
 typedef struct _GtkHTMLEmbeddedPrivate GtkHTMLEmbeddedPrivate;
+typedef struct _GtkHTMLFrameTiming GtkHTMLFrameTiming;
 typedef struct _GtkHTMLPrivate GtkHTMLPrivate;
 typedef struct _GtkHTMLStream GtkHTMLStream;
 
@@ -76,5 +77,6 @@ typedef void    (*GtkHTMLPrintDrawFunc)   (GtkHTML *html,
 
 typedef void (*GtkHTMLPrintCallback) (GtkHTML *html, GtkPrintContext *print_context,
 				      gdouble x, gdouble y, gdouble width, gdouble height, gpointer user_data);
+typedef void (*GtkHTMLPageImageFunc) (GtkHTML *html, gint page_nr, cairo_surface_t *image, gpointer user_data);
 
 #endif
@@ -26,6 +26,7 @@
 #include <gdk/gdkkeysyms.h>
 #include <glib/gi18n-lib.h>
 #include <string.h>
+#include <cairo-pdf.h>
 
 #include "../a11y/object.h"
 
@@ -164,6 +165,7 @@ enum {
 	CURSOR_CHANGED,
 	OBJECT_INSERTED,
 	OBJECT_DELETE,
+	FRAME_TIMING,
 	/* now only last signal */
 	LAST_SIGNAL
 };
@@ -412,7 +414,7 @@ idle_handler (gpointer data)
 
 	also_update_cursor = any_has_cursor_moved (html) || !any_has_skip_update_cursor (html);
 
-	if (html->engine->thaw_idle_id == 0 && !html_engine_frozen (html->engine))
+	if (!html->engine->thaw_pending && !html_engine_frozen (html->engine))
 		html_engine_flush_draw_queue (engine);
 
 	if (also_update_cursor)
@@ -446,7 +448,7 @@ gtk_html_adjust_cursor_position (GtkHTML *html)
 	e = html->engine;
 
 	if (html->priv->scroll_timeout_id == 0  &&
-	    html->engine->thaw_idle_id == 0  &&
+	    !html->engine->thaw_pending  &&
 	    !html_engine_frozen (html->engine))
 		html_engine_make_cursor_visible (e);
 
@@ -615,6 +617,7 @@ vertical_scroll_cb (GtkAdjustment *adjustment,
 		return;
 
 	html->engine->y_offset = (gint) gtk_adjustment_get_value (adjustment);
+	html_image_factory_schedule_loads (html->engine->image_factory);
 	scroll_update_mouse (GTK_WIDGET (data));
 }
 
@@ -628,6 +631,7 @@ horizontal_scroll_cb (GtkAdjustment *adjustment,
 		return;
 
 	html->engine->x_offset = (gint) gtk_adjustment_get_value (adjustment);
+	html_image_factory_schedule_loads (html->engine->image_factory);
 	scroll_update_mouse (GTK_WIDGET (data));
 }
 
@@ -865,6 +869,8 @@ dispose (GObject *object)
 	g_free (html->priv->caret_first_focus_anchor);
 	html->priv->caret_first_focus_anchor = NULL;
 
+	gtk_html_cancel_page_images (html);
+
 	if (html->engine) {
 		g_object_unref (html->engine);
 		html->engine = NULL;
@@ -1223,11 +1229,45 @@ unrealize (GtkWidget *widget)
 		GTK_WIDGET_CLASS (gtk_html_parent_class)->unrealize (widget);
 }
 
+static void
+emit_frame_timing (GtkHTML *html,
+                   cairo_t *cr,
+                   gint64 paint_time)
+{
+	GtkHTMLFrameTiming timing;
+	cairo_rectangle_list_t *rects;
+	gint i;
+
+	timing.layout_ms = html->engine->frame_layout_time / 1000.0;
+	timing.paint_ms = paint_time / 1000.0;
+	timing.dirty_area = 0;
+
+	rects = cairo_copy_clip_rectangle_list (cr);
+	if (rects->status == CAIRO_STATUS_SUCCESS)
+		for (i = 0; i < rects->num_rectangles; i++)
+			timing.dirty_area += (guint64) (rects->rectangles[i].width * rects->rectangles[i].height);
+	cairo_rectangle_list_destroy (rects);
+
+	html->engine->frame_layout_time = 0;
+
+	g_signal_emit (html, signals[FRAME_TIMING], 0, &timing);
+}
+
 static gboolean
 draw (GtkWidget *widget,
       cairo_t *cr)
 {
-	html_engine_draw_cb (GTK_HTML (widget)->engine, cr);
+	GtkHTML *html = GTK_HTML (widget);
+
+	if (g_signal_has_handler_pending (html, signals[FRAME_TIMING], 0, FALSE)) {
+		gint64 start = g_get_monotonic_time ();
+
+		html_engine_draw_cb (html->engine, cr);
+		emit_frame_timing (html, cr, g_get_monotonic_time () - start);
+	} else {
+		html->engine->frame_layout_time = 0;
+		html_engine_draw_cb (html->engine, cr);
+	}
 
 	if (GTK_WIDGET_CLASS (gtk_html_parent_class)->draw)
 		GTK_WIDGET_CLASS (gtk_html_parent_class)->draw (widget, cr);
@@ -1886,6 +1926,24 @@ motion_notify_event (GtkWidget *widget,
 	return TRUE;
 }
 
+static void
+map (GtkWidget *widget)
+{
+	GTK_WIDGET_CLASS (gtk_html_parent_class)->map (widget);
+
+	/* run the pending layout from the frame clock */
+	html_engine_reschedule_frame (GTK_HTML (widget)->engine);
+}
+
+static void
+unmap (GtkWidget *widget)
+{
+	GTK_WIDGET_CLASS (gtk_html_parent_class)->unmap (widget);
+
+	/* the frame clock of an unmapped widget may not tick */
+	html_engine_reschedule_frame (GTK_HTML (widget)->engine);
+}
+
 static gboolean
 toplevel_unmap (GtkWidget *widget,
                 GdkEvent *event,
@@ -3171,6 +3229,17 @@ gtk_html_class_init (GtkHTMLClass *klass)
 			      html_g_cclosure_marshal_VOID__INT_INT,
 			      G_TYPE_NONE, 2,
 			      G_TYPE_INT, G_TYPE_INT);
+
+	/* emitted after each paint with a GtkHTMLFrameTiming */
+	signals[FRAME_TIMING] =
+		g_signal_new ("frame_timing",
+			      G_TYPE_FROM_CLASS (object_class),
+			      G_SIGNAL_RUN_LAST,
+			      0,
+			      NULL, NULL,
+			      g_cclosure_marshal_VOID__POINTER,
+			      G_TYPE_NONE, 1,
+			      G_TYPE_POINTER);
 	object_class->dispose = dispose;
 
 #ifdef USE_PROPS
@@ -3248,6 +3317,8 @@ gtk_html_class_init (GtkHTMLClass *klass)
 
 	widget_class->realize = realize;
 	widget_class->unrealize = unrealize;
+	widget_class->map = map;
+	widget_class->unmap = unmap;
 	widget_class->style_updated = style_updated;
 	widget_class->key_press_event = key_press_event;
 	widget_class->key_release_event = key_release_event;
@@ -3981,6 +4052,33 @@ gtk_html_export (GtkHTML *html,
 	}
 }
 
+/**
+ * gtk_html_save_to_stream:
+ *
+ * @html: the GtkHTML widget
+ * @stream: the stream to write the document to
+ * @cancellable: optional #GCancellable object, %NULL to ignore
+ * @error: location to store the error occurring, or %NULL to ignore
+ *
+ * Saves the current document as HTML into @stream. The output is collected
+ * into large blocks before it is written, so this is preferable to
+ * gtk_html_save() for big documents.
+ *
+ * Returns: TRUE if the document was saved, FALSE otherwise.
+ **/
+gboolean
+gtk_html_save_to_stream (GtkHTML *html,
+                         GOutputStream *stream,
+                         GCancellable *cancellable,
+                         GError **error)
+{
+	g_return_val_if_fail (html != NULL, FALSE);
+	g_return_val_if_fail (GTK_IS_HTML (html), FALSE);
+	g_return_val_if_fail (G_IS_OUTPUT_STREAM (stream), FALSE);
+
+	return html_engine_save_to_stream (html->engine, stream, 0, cancellable, error);
+}
+
 
 
 static void
@@ -4299,6 +4397,67 @@ gtk_html_get_animate (const GtkHTML *html)
 	return html_image_factory_get_animate (html->engine->image_factory);
 }
 
+/**
+ * gtk_html_set_lazy_image_loading:
+ * @html: a #GtkHTML
+ * @lazy: whether to load images lazily
+ * @max_requests: maximum number of images loaded at once, 0 for no limit
+ *
+ * In the lazy image loading mode the images are not requested as soon as
+ * they are parsed, but the ones nearest to the visible part of the document
+ * first, and no more than @max_requests of them at once. Images wait for
+ * their data at the size given by their width and height attributes.
+ **/
+void
+gtk_html_set_lazy_image_loading (GtkHTML *html,
+                                 gboolean lazy,
+                                 guint max_requests)
+{
+	g_return_if_fail (GTK_IS_HTML (html));
+	g_return_if_fail (HTML_IS_ENGINE (html->engine));
+
+	html_image_factory_set_lazy_load (html->engine->image_factory, lazy, max_requests);
+}
+
+gboolean
+gtk_html_get_lazy_image_loading (const GtkHTML *html)
+{
+	g_return_val_if_fail (GTK_IS_HTML (html), FALSE);
+	g_return_val_if_fail (HTML_IS_ENGINE (html->engine), FALSE);
+
+	return html_image_factory_get_lazy_load (html->engine->image_factory);
+}
+
+/**
+ * gtk_html_set_shared_images:
+ * @html: a #GtkHTML
+ * @shared: whether to share decoded images with other widgets
+ *
+ * Lets @html use the decoded images cache of the process, see
+ * html_image_cache_set_max_size(). Images of URLs already in the cache are
+ * taken from it and #GtkHTML::url-requested is not emitted for them, so
+ * only enable it for widgets which load their images the same way and do
+ * not block any remote content. The cache is not used by default.
+ **/
+void
+gtk_html_set_shared_images (GtkHTML *html,
+                            gboolean shared)
+{
+	g_return_if_fail (GTK_IS_HTML (html));
+	g_return_if_fail (HTML_IS_ENGINE (html->engine));
+
+	html_image_factory_set_shared (html->engine->image_factory, shared);
+}
+
+gboolean
+gtk_html_get_shared_images (const GtkHTML *html)
+{
+	g_return_val_if_fail (GTK_IS_HTML (html), FALSE);
+	g_return_val_if_fail (HTML_IS_ENGINE (html->engine), FALSE);
+
+	return html_image_factory_get_shared (html->engine->image_factory);
+}
+
 void
 gtk_html_load_empty (GtkHTML *html)
 {
@@ -4656,12 +4815,21 @@ clipboard_paste_received_cb (GtkClipboard *clipboard,
 						encoded);
 				g_free (encoded);
 				gtk_html_insert_html (GTK_HTML (widget), utf8);
+
+				if (HTML_IS_TEXT (e->cursor->object))
+					html_text_magic_link (HTML_TEXT (e->cursor->object), e, 1);
 			} else {
-				html_engine_paste_text (e, utf8, g_utf8_strlen (utf8, -1));
-			}
+				HTMLCursor *begin;
+				glong len = g_utf8_strlen (utf8, -1);
 
-			if (HTML_IS_TEXT (e->cursor->object))
-				html_text_magic_link (HTML_TEXT (e->cursor->object), e, 1);
+				html_engine_paste_text (e, utf8, len);
+
+				/* link everything pasted, not just its last paragraph */
+				begin = html_cursor_dup (e->cursor);
+				html_cursor_jump_to_position_no_spell (begin, e, MAX ((glong) e->cursor->position - len, 0));
+				html_engine_magic_links_range (e, begin, e->cursor);
+				html_cursor_destroy (begin);
+			}
 		}
 
 		if (utf8)
@@ -4818,6 +4986,42 @@ gtk_html_redo (GtkHTML *html)
 	gtk_html_update_styles (html);
 }
 
+/**
+ * gtk_html_begin_batch_edit:
+ * @html: the GtkHTML widget to operate on.
+ *
+ * Starts a batch of programmatic edits. Until the matching
+ * gtk_html_commit_batch_edit() the document is not laid out again, the
+ * edits are recorded as a single undo step and inline spell checking is
+ * postponed. Batches may be nested.
+ **/
+void
+gtk_html_begin_batch_edit (GtkHTML *html)
+{
+	g_return_if_fail (html != NULL);
+	g_return_if_fail (GTK_IS_HTML (html));
+
+	html_engine_begin_batch (html->engine);
+}
+
+/**
+ * gtk_html_commit_batch_edit:
+ * @html: the GtkHTML widget to operate on.
+ *
+ * Ends a batch started by gtk_html_begin_batch_edit(). When the outermost
+ * batch is committed the edited text is spell checked and the document is
+ * laid out and redrawn once.
+ **/
+void
+gtk_html_commit_batch_edit (GtkHTML *html)
+{
+	g_return_if_fail (html != NULL);
+	g_return_if_fail (GTK_IS_HTML (html));
+
+	html_engine_commit_batch (html->engine);
+	gtk_html_update_styles (html);
+}
+
 /* misc utils */
 /* if engine_type == false - default behaviour*/
 void
@@ -6550,6 +6754,275 @@ gtk_html_print_operation_run (GtkHTML *html,
 		draw_header, draw_footer, user_data, error);
 }
 
+typedef struct {
+	GtkWidget *html;
+	HTMLPrintJob *job;
+	cairo_surface_t *surface;
+	cairo_t *cr;
+	guint index;
+	gint pages;
+} RenderPdfDocument;
+
+/* Parses and lays out one document for the PDF FILENAME, on the main
+ * thread. The GtkHTML is only there for its engine and is never shown. */
+static RenderPdfDocument *
+render_pdf_begin (const gchar *html_src,
+                  gint length,
+                  const gchar *filename,
+                  gdouble page_width,
+                  gdouble page_height)
+{
+	RenderPdfDocument *doc;
+	HTMLEngine *engine;
+
+	doc = g_new0 (RenderPdfDocument, 1);
+	doc->pages = -1;
+	doc->surface = cairo_pdf_surface_create (filename, page_width, page_height);
+	if (cairo_surface_status (doc->surface) != CAIRO_STATUS_SUCCESS) {
+		cairo_surface_destroy (doc->surface);
+		g_free (doc);
+		return NULL;
+	}
+	doc->cr = cairo_create (doc->surface);
+
+	doc->html = g_object_ref_sink (gtk_html_new ());
+	gtk_html_load_from_string (GTK_HTML (doc->html), html_src, length);
+
+	engine = GTK_HTML (doc->html)->engine;
+	if (engine->clue != NULL)
+		doc->job = html_engine_print_job_new (engine, doc->cr, page_width, page_height);
+
+	return doc;
+}
+
+/* Draws the pages and writes the file out, from any thread unless the
+ * print job is live. */
+static void
+render_pdf_draw (RenderPdfDocument *doc)
+{
+	if (doc->job == NULL)
+		return;
+
+	doc->pages = html_print_job_run (doc->job);
+	cairo_surface_finish (doc->surface);
+	if (cairo_surface_status (doc->surface) != CAIRO_STATUS_SUCCESS)
+		doc->pages = -1;
+}
+
+static gint
+render_pdf_end (RenderPdfDocument *doc)
+{
+	gint pages = doc->pages;
+
+	if (doc->job != NULL)
+		html_print_job_free (doc->job);
+	gtk_widget_destroy (doc->html);
+	g_object_unref (doc->html);
+	cairo_destroy (doc->cr);
+	cairo_surface_destroy (doc->surface);
+	g_free (doc);
+
+	return pages;
+}
+
+static void
+render_pdf_thread (RenderPdfDocument *doc,
+                   GAsyncQueue *done)
+{
+	render_pdf_draw (doc);
+	g_async_queue_push (done, doc);
+}
+
+/**
+ * gtk_html_render_pdf:
+ * @html_src: the HTML document, in UTF-8
+ * @length: length of @html_src in bytes, or -1 if it is nul terminated
+ * @filename: the PDF file to write
+ * @page_width: page width in points
+ * @page_height: page height in points
+ *
+ * Renders an HTML document to a PDF file without a widget on screen, a
+ * print dialog or iterations of the main loop. Has to be called from the
+ * main thread.
+ *
+ * Returns: the number of pages written, or -1 on failure.
+ **/
+gint
+gtk_html_render_pdf (const gchar *html_src,
+                     gint length,
+                     const gchar *filename,
+                     gdouble page_width,
+                     gdouble page_height)
+{
+	RenderPdfDocument *doc;
+
+	g_return_val_if_fail (html_src != NULL, -1);
+	g_return_val_if_fail (filename != NULL, -1);
+
+	doc = render_pdf_begin (html_src, length, filename, page_width, page_height);
+	if (doc == NULL)
+		return -1;
+
+	render_pdf_draw (doc);
+
+	return render_pdf_end (doc);
+}
+
+/**
+ * gtk_html_render_pdf_batch:
+ * @html_srcs: nul terminated HTML documents, in UTF-8
+ * @filenames: the PDF file to write for each document
+ * @n_documents: number of documents
+ * @page_width: page width in points
+ * @page_height: page height in points
+ * @n_pages: return location for the page count of each document, -1 for
+ * documents which failed, or %NULL
+ *
+ * Renders many HTML documents to PDF files, like gtk_html_render_pdf().
+ * Documents are parsed and laid out one after another on the calling
+ * thread while the pages of the documents already laid out are drawn on
+ * a pool of threads. Documents with embedded widgets or frames are drawn
+ * on the calling thread. Has to be called from the main thread.
+ *
+ * Returns: %TRUE if all documents were written.
+ **/
+gboolean
+gtk_html_render_pdf_batch (const gchar * const *html_srcs,
+                           const gchar * const *filenames,
+                           guint n_documents,
+                           gdouble page_width,
+                           gdouble page_height,
+                           gint *n_pages)
+{
+	RenderPdfDocument *doc;
+	GAsyncQueue *done;
+	GThreadPool *pool;
+	gboolean success = TRUE;
+	guint i, pending = 0, max_pending;
+
+	g_return_val_if_fail (html_srcs != NULL || n_documents == 0, FALSE);
+	g_return_val_if_fail (filenames != NULL || n_documents == 0, FALSE);
+
+	done = g_async_queue_new ();
+	pool = g_thread_pool_new ((GFunc) render_pdf_thread, done, g_get_num_processors (), FALSE, NULL);
+
+	/* bounds the number of documents kept in memory */
+	max_pending = 2 * g_get_num_processors ();
+
+	for (i = 0; i < n_documents || pending > 0;) {
+		if (i < n_documents && pending < max_pending) {
+			doc = render_pdf_begin (html_srcs[i], -1, filenames[i], page_width, page_height);
+			if (doc == NULL) {
+				if (n_pages)
+					n_pages[i] = -1;
+				success = FALSE;
+			} else {
+				doc->index = i;
+				pending++;
+				if (doc->job != NULL && !doc->job->live)
+					g_thread_pool_push (pool, doc, NULL);
+				else
+					render_pdf_thread (doc, done);
+			}
+			i++;
+		} else {
+			gint pages;
+
+			doc = g_async_queue_pop (done);
+			pending--;
+			if (n_pages)
+				n_pages[doc->index] = doc->pages;
+			pages = render_pdf_end (doc);
+			success = success && pages >= 0;
+		}
+	}
+
+	g_thread_pool_free (pool, FALSE, TRUE);
+	g_async_queue_unref (done);
+
+	return success;
+}
+
+static void
+page_image_cb (gint page_nr,
+               cairo_surface_t *image,
+               GtkHTML *html)
+{
+	HTMLPrintPreview *preview = html->priv->page_images;
+
+	if (image != NULL) {
+		(*html->priv->page_image_func) (html, page_nr, image, html->priv->page_image_data);
+		return;
+	}
+
+	/* after the last page */
+	html->priv->page_images = NULL;
+	(*html->priv->page_image_func) (html, page_nr, NULL, html->priv->page_image_data);
+	html_print_preview_free (preview);
+}
+
+/**
+ * gtk_html_render_page_images:
+ * @html: a #GtkHTML
+ * @page_width: page width in points
+ * @page_height: page height in points
+ * @scale: pixels per point of the images
+ * @func: function receiving the page images
+ * @user_data: data to pass to @func
+ *
+ * Makes images of the printed pages of the document, for print preview
+ * or thumbnails. The pages are laid out from a snapshot of the document
+ * and turned into images on worker threads. @func is called from the main
+ * loop with the image of each page in page order, as soon as it is ready,
+ * and then once more with a %NULL image and the number of pages. Keep a
+ * reference to an image to use it after @func returns.
+ *
+ * Starting again, gtk_html_cancel_page_images() or destroying @html stops
+ * the images which have not been handed out yet.
+ **/
+void
+gtk_html_render_page_images (GtkHTML *html,
+                             gdouble page_width,
+                             gdouble page_height,
+                             gdouble scale,
+                             GtkHTMLPageImageFunc func,
+                             gpointer user_data)
+{
+	g_return_if_fail (GTK_IS_HTML (html));
+	g_return_if_fail (func != NULL);
+	g_return_if_fail (scale > 0);
+
+	gtk_html_cancel_page_images (html);
+
+	html->priv->page_image_func = func;
+	html->priv->page_image_data = user_data;
+	html->priv->page_images = html_engine_print_preview_new (
+		html->engine, page_width, page_height, scale,
+		(HTMLPrintPageImageFunc) page_image_cb, html);
+
+	/* nothing to print */
+	if (html->priv->page_images == NULL)
+		(*func) (html, 0, NULL, user_data);
+}
+
+/**
+ * gtk_html_cancel_page_images:
+ * @html: a #GtkHTML
+ *
+ * Stops the page images started by gtk_html_render_page_images(). The
+ * images not handed out yet are dropped.
+ **/
+void
+gtk_html_cancel_page_images (GtkHTML *html)
+{
+	g_return_if_fail (GTK_IS_HTML (html));
+
+	if (html->priv->page_images != NULL) {
+		html_print_preview_free (html->priv->page_images);
+		html->priv->page_images = NULL;
+	}
+}
+
 gboolean
 gtk_html_has_undo (GtkHTML *html)
 {
@@ -6562,6 +7035,23 @@ gtk_html_drop_undo (GtkHTML *html)
 	html_undo_reset (html->engine->undo);
 }
 
+/**
+ * gtk_html_set_undo_max_bytes:
+ * @html: a #GtkHTML
+ * @max_bytes: memory budget of the undo history in bytes, 0 for unlimited
+ *
+ * Limits memory used by the undo history, the oldest steps are dropped
+ * when the budget is exceeded.
+ **/
+void
+gtk_html_set_undo_max_bytes (GtkHTML *html,
+                             gsize max_bytes)
+{
+	g_return_if_fail (GTK_IS_HTML (html));
+
+	html_undo_set_max_bytes (html->engine->undo, max_bytes);
+}
+
 void
 gtk_html_flush (GtkHTML *html)
 {
@@ -111,6 +111,13 @@ struct _GtkHTMLClass {
 	gboolean use_emacs_bindings;
 };
 
+/* passed to the "frame_timing" signal after each paint */
+struct _GtkHTMLFrameTiming {
+	gdouble layout_ms;   /* layout done since the previous paint */
+	gdouble paint_ms;
+	guint64 dirty_area;  /* painted pixels */
+};
+
 struct _GtkHTMLEditorAPI
 {
 	/* spell checking methods */
@@ -183,6 +190,10 @@ gboolean                   gtk_html_export                        (GtkHTML
 								   const gchar                *type,
 								   GtkHTMLSaveReceiverFn      receiver,
 								   gpointer                   data);
+gboolean                   gtk_html_save_to_stream                (GtkHTML                   *html,
+								   GOutputStream             *stream,
+								   GCancellable              *cancellable,
+								   GError                   **error);
 gchar *                     gtk_html_get_selection_html            (GtkHTML                   *html,
 								   gint                       *len);
 gchar *                     gtk_html_get_selection_plain_text      (GtkHTML                   *html,
@@ -214,6 +225,13 @@ void			   gtk_html_set_caret_first_focus_anchor  (GtkHTML		     *html,
 void                       gtk_html_set_animate                   (GtkHTML                   *html,
 								   gboolean                   animate);
 gboolean                   gtk_html_get_animate                   (const GtkHTML             *html);
+void                       gtk_html_set_lazy_image_loading        (GtkHTML                   *html,
+								   gboolean                   lazy,
+								   guint                      max_requests);
+gboolean                   gtk_html_get_lazy_image_loading        (const GtkHTML             *html);
+void                       gtk_html_set_shared_images             (GtkHTML                   *html,
+								   gboolean                   shared);
+gboolean                   gtk_html_get_shared_images             (const GtkHTML             *html);
 
 /* Printing support.  */
 void			   gtk_html_print_page_with_header_footer (GtkHTML		     *html,
@@ -239,6 +257,24 @@ GtkPrintOperationResult	   gtk_html_print_operation_run		  (GtkHTML
 								   GtkHTMLPrintDrawFunc        draw_footer,
 								   gpointer                    user_data,
 								   GError                    **error);
+gint			   gtk_html_render_pdf			  (const gchar                *html_src,
+								   gint                        length,
+								   const gchar                *filename,
+								   gdouble                     page_width,
+								   gdouble                     page_height);
+gboolean		   gtk_html_render_pdf_batch		  (const gchar * const        *html_srcs,
+								   const gchar * const        *filenames,
+								   guint                       n_documents,
+								   gdouble                     page_width,
+								   gdouble                     page_height,
+								   gint                       *n_pages);
+void			   gtk_html_render_page_images		  (GtkHTML                    *html,
+								   gdouble                     page_width,
+								   gdouble                     page_height,
+								   gdouble                     scale,
+								   GtkHTMLPageImageFunc        func,
+								   gpointer                    user_data);
+void			   gtk_html_cancel_page_images		  (GtkHTML                    *html);
 
 /* Title.  */
 const gchar               *gtk_html_get_title                     (GtkHTML                   *html);
@@ -275,6 +311,8 @@ void                       gtk_html_paste                         (GtkHTML
 								   gboolean                   as_cite);
 void                       gtk_html_undo                          (GtkHTML                   *html);
 void                       gtk_html_redo                          (GtkHTML                   *html);
+void                       gtk_html_begin_batch_edit              (GtkHTML                   *html);
+void                       gtk_html_commit_batch_edit             (GtkHTML                   *html);
 void                       gtk_html_insert_html                   (GtkHTML                   *html,
 								   const gchar               *html_src);
 void                       gtk_html_insert_gtk_html               (GtkHTML                   *html,
@@ -323,6 +361,8 @@ void                       gtk_html_set_images_blocking           (GtkHTML
 								   gboolean                   block);
 gboolean                   gtk_html_has_undo                      (GtkHTML                   *html);
 void                       gtk_html_drop_undo                     (GtkHTML                   *html);
+void                       gtk_html_set_undo_max_bytes            (GtkHTML                   *html,
+								   gsize                      max_bytes);
 gchar *                     gtk_html_get_url_at                    (GtkHTML                   *html,
 								   gint                        x,
 								   gint                        y);
@@ -466,12 +466,69 @@ gtk_html_debug_list_text_attrs (HTMLText *text)
 void
 gtk_html_debug_list_links (HTMLText *text)
 {
-	GSList *l;
+	guint i;
 
-	for (l = text->links; l; l = l->next)
-		if (l->data) {
-			Link *link = (Link *) l->data;
+	for (i = 0; i < html_text_get_n_links (text); i++) {
+		Link *link = html_text_get_nth_link (text, i);
 
-			g_print ("%d-%d(%d-%d): %s#%s\n", link->start_offset, link->end_offset, link->start_index, link->end_index, link->url, link->target);
+		g_print ("%d-%d(%d-%d): %s#%s\n", link->start_offset, link->end_offset, link->start_index, link->end_index, link->url, link->target);
+	}
+}
+
+static guint
+check_recursive_length (HTMLObject *o,
+                        gboolean *consistent)
+{
+	if (html_object_is_clue (o) || HTML_OBJECT_TYPE (o) == HTML_TYPE_CLUEH) {
+		HTMLClue *clue = HTML_CLUE (o);
+		HTMLObject *child;
+		guint len = 0;
+
+		for (child = clue->head; child; child = child->next)
+			len += check_recursive_length (child, consistent);
+
+		if (clue->recursive_length >= 0 && clue->recursive_length != len) {
+			g_print ("%s %p caches recursive length %d, children sum up to %d\n",
+				 html_type_name (HTML_OBJECT_TYPE (o)), (gpointer) o, clue->recursive_length, len);
+			*consistent = FALSE;
 		}
+		/* recomputed below, together with the position index */
+		if (clue->recursive_length != len)
+			clue->recursive_length = -1;
+	} else if (HTML_OBJECT_TYPE (o) == HTML_TYPE_TABLE) {
+		HTMLTable *table = HTML_TABLE (o);
+		gint r, c;
+
+		for (r = 0; r < table->totalRows; r++)
+			for (c = 0; c < table->totalCols; c++) {
+				HTMLTableCell *cell = table->cells[r][c];
+
+				if (cell && cell->row == r && cell->col == c)
+					check_recursive_length (HTML_OBJECT (cell), consistent);
+			}
+	}
+
+	return html_object_get_recursive_length (o);
+}
+
+/**
+ * gtk_html_debug_check_recursive_lengths:
+ * @o: The root of the checked subtree.
+ *
+ * Compare the recursive lengths cached on the clues in @o with the
+ * lengths of their children, print the clues where they differ and
+ * replace the stale values.
+ *
+ * Return value: %TRUE if all the cached lengths were correct.
+ **/
+gboolean
+gtk_html_debug_check_recursive_lengths (HTMLObject *o)
+{
+	gboolean consistent = TRUE;
+
+	g_return_val_if_fail (o != NULL, FALSE);
+
+	check_recursive_length (o, &consistent);
+
+	return consistent;
 }
@@ -41,5 +41,6 @@ void  gtk_html_debug_dump_object       (HTMLObject  *o,
 					gint         level);
 void  gtk_html_debug_list_text_attrs   (HTMLText    *text);
 void  gtk_html_debug_list_links        (HTMLText    *text);
+gboolean gtk_html_debug_check_recursive_lengths (HTMLObject *o);
 
 #endif /* _GTKHTML_DEBUG_H_ */
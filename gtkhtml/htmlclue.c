@@ -36,6 +36,7 @@ HTMLClueClass html_clue_class;
 static HTMLObjectClass *parent_class = NULL;
 
 static void set_parent (HTMLObject *o, HTMLObject *tail, HTMLObject *parent);
+static void position_index_free (HTMLClue *clue);
 
 /* HTMLObject methods.  */
 
@@ -51,6 +52,7 @@ destroy (HTMLObject *o)
 	}
 	HTML_CLUE (o)->head = NULL;
 	HTML_CLUE (o)->tail = NULL;
+	position_index_free (HTML_CLUE (o));
 
 	HTML_OBJECT_CLASS (parent_class)->destroy (o);
 }
@@ -107,13 +109,21 @@ get_child_index (HTMLObject *self,
 static guint
 get_recursive_length (HTMLObject *self)
 {
-	HTMLObject *o = HTML_CLUE (self)->head;
+	HTMLClue *clue = HTML_CLUE (self);
+	HTMLObject *o = clue->head;
 	guint len = 0;
 
+	if (clue->recursive_length >= 0)
+		return clue->recursive_length;
+
+	/* the children changed since the index was built */
+	position_index_free (clue);
+
 	while (o) {
 		len += html_object_get_recursive_length (o);
 		o = o->next;
 	}
+	clue->recursive_length = len;
 
 	return len;
 }
@@ -127,6 +137,8 @@ copy (HTMLObject *self,
 	HTML_CLUE (dest)->head = NULL;
 	HTML_CLUE (dest)->tail = NULL;
 	HTML_CLUE (dest)->curr = NULL;
+	HTML_CLUE (dest)->recursive_length = -1;
+	HTML_CLUE (dest)->position_index = NULL;
 
 	HTML_CLUE (dest)->valign = HTML_CLUE (self)->valign;
 	HTML_CLUE (dest)->halign = HTML_CLUE (self)->halign;
@@ -230,6 +242,7 @@ merge (HTMLObject *self,
 	html_clue_append (clue1, clue2->head);
 	clue2->head = NULL;
 	clue2->tail = NULL;
+	clue2->recursive_length = -1;
 
 	html_object_change_set (self, HTML_CHANGE_ALL_CALC);
 	return TRUE;
@@ -264,6 +277,8 @@ split (HTMLObject *self,
 		HTML_CLUE (self)->head = NULL;
 	HTML_CLUE (dup)->head  = child;
 	set_parent (child, NULL, dup);
+	html_object_invalidate_recursive_length (self);
+	html_object_invalidate_recursive_length (dup);
 
 	if (self->parent && HTML_OBJECT_TYPE (self->parent) != HTML_TYPE_TABLE)
 		html_clue_append_after (HTML_CLUE (self->parent), dup, self);
@@ -489,6 +504,28 @@ check_page_split (HTMLObject *self,
 	return y;
 }
 
+static void
+add_page_split_ranges (HTMLObject *self,
+                       HTMLPainter *painter,
+                       gint y,
+                       GArray *ranges)
+{
+	HTMLObject *p;
+	gint last_under = 0;
+
+	for (p = HTML_CLUE (self)->head; p != NULL; p = p->next) {
+		gint y1, y2;
+
+		y1 = p->y - p->ascent;
+		y2 = p->y + p->descent;
+
+		/* between children only right under the previous one */
+		html_object_add_page_split_range (ranges, y + last_under + 1, y + y1 - 1);
+		html_object_add_page_split_ranges (p, painter, y + y1, ranges);
+		last_under = MAX (last_under, y2);
+	}
+}
+
 static void
 forall (HTMLObject *self,
         HTMLEngine *e,
@@ -691,6 +728,7 @@ html_clue_class_init (HTMLClueClass *klass,
 	object_class->calc_min_width = calc_min_width;
 	object_class->check_point = check_point;
 	object_class->check_page_split = check_page_split;
+	object_class->add_page_split_ranges = add_page_split_ranges;
 	object_class->find_anchor = find_anchor;
 	object_class->forall = forall;
 	object_class->is_container = is_container;
@@ -727,6 +765,8 @@ html_clue_init (HTMLClue *clue,
 	clue->head = NULL;
 	clue->tail = NULL;
 	clue->curr = NULL;
+	clue->recursive_length = -1;
+	clue->position_index = NULL;
 
 	clue->valign = HTML_VALIGN_TOP;
 	clue->halign = HTML_HALIGN_LEFT;
@@ -867,6 +907,7 @@ html_clue_append_after (HTMLClue *clue,
 		clue->tail = tail;
 
 	set_parent (o, tail, HTML_OBJECT (clue));
+	html_object_invalidate_recursive_length (HTML_OBJECT (clue));
 }
 
 /**
@@ -904,6 +945,7 @@ html_clue_append (HTMLClue *clue,
 	html_object_set_parent (o, HTML_OBJECT (clue));
 
 	set_parent (o, tail, HTML_OBJECT (clue));
+	html_object_invalidate_recursive_length (HTML_OBJECT (clue));
 }
 
 /**
@@ -939,6 +981,7 @@ html_clue_prepend (HTMLClue *clue,
 	o->prev = NULL;
 
 	set_parent (o, tail, HTML_OBJECT (clue));
+	html_object_invalidate_recursive_length (HTML_OBJECT (clue));
 }
 
 /**
@@ -969,6 +1012,10 @@ html_clue_remove (HTMLClue *clue,
 	o->parent = NULL;
 	o->prev = NULL;
 	o->next = NULL;
+
+	/* text slaves have no length, layout removes them all the time */
+	if (HTML_OBJECT_TYPE (o) != HTML_TYPE_TEXTSLAVE)
+		html_object_invalidate_recursive_length (HTML_OBJECT (clue));
 }
 
 void
@@ -999,3 +1046,170 @@ html_clue_is_empty (HTMLClue *clue)
 		return TRUE;
 	return FALSE;
 }
+
+/* Position index: the start positions (sums of the preceding recursive
+ * lengths) of the children other than text slaves, in document order and
+ * sorted by address, so both directions of the position <-> child mapping
+ * are binary searches.  It is built on demand and dropped whenever the
+ * cached recursive length is recomputed.  */
+
+struct _HTMLCluePositionIndex {
+	guint n_children;
+	HTMLObject **children;
+	guint *positions;
+	guint *by_address;  /* indices into children, sorted by child address */
+};
+
+static void
+position_index_free (HTMLClue *clue)
+{
+	HTMLCluePositionIndex *index = clue->position_index;
+
+	if (!index)
+		return;
+
+	g_free (index->children);
+	g_free (index->positions);
+	g_free (index->by_address);
+	g_free (index);
+	clue->position_index = NULL;
+}
+
+static gint
+position_index_address_cmp (gconstpointer a,
+                            gconstpointer b,
+                            gpointer user_data)
+{
+	HTMLObject **children = user_data;
+	gsize ca = GPOINTER_TO_SIZE (children[*(const guint *) a]);
+	gsize cb = GPOINTER_TO_SIZE (children[*(const guint *) b]);
+
+	return ca < cb ? -1 : ca > cb ? 1 : 0;
+}
+
+static HTMLCluePositionIndex *
+position_index_get (HTMLClue *clue)
+{
+	HTMLCluePositionIndex *index;
+	HTMLObject *o;
+	guint i, position = 0;
+
+	/* drops an index left from before the last change */
+	html_object_get_recursive_length (HTML_OBJECT (clue));
+	if (clue->position_index)
+		return clue->position_index;
+
+	index = g_new0 (HTMLCluePositionIndex, 1);
+	for (o = clue->head; o; o = o->next)
+		if (HTML_OBJECT_TYPE (o) != HTML_TYPE_TEXTSLAVE)
+			index->n_children++;
+
+	index->children = g_new (HTMLObject *, index->n_children);
+	index->positions = g_new (guint, index->n_children + 1);
+	index->by_address = g_new (guint, index->n_children);
+
+	for (i = 0, o = clue->head; o; o = o->next) {
+		if (HTML_OBJECT_TYPE (o) == HTML_TYPE_TEXTSLAVE)
+			continue;
+		index->children[i] = o;
+		index->positions[i] = position;
+		index->by_address[i] = i;
+		position += html_object_get_recursive_length (o);
+		i++;
+	}
+	index->positions[i] = position;
+
+	g_qsort_with_data (index->by_address, index->n_children, sizeof (guint),
+			   position_index_address_cmp, index->children);
+
+	clue->position_index = index;
+
+	return index;
+}
+
+/**
+ * html_clue_get_child_at_position:
+ * @clue: An HTMLClue.
+ * @position: A position relative to the start of @clue.
+ * @child: Return location for the child.
+ * @child_position: Return location for the start position of @child.
+ *
+ * Finds the first child (text slaves excluded) of @clue which ends at or
+ * after @position.
+ *
+ * Return value: %FALSE if @position is past the end of @clue.
+ **/
+gboolean
+html_clue_get_child_at_position (HTMLClue *clue,
+                                 guint position,
+                                 HTMLObject **child,
+                                 guint *child_position)
+{
+	HTMLCluePositionIndex *index;
+	guint lo, hi;
+
+	g_return_val_if_fail (clue != NULL, FALSE);
+
+	index = position_index_get (clue);
+
+	/* first i with positions[i + 1] >= position */
+	lo = 0;
+	hi = index->n_children;
+	while (lo < hi) {
+		guint mid = (lo + hi) / 2;
+
+		if (index->positions[mid + 1] < position)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	if (lo >= index->n_children)
+		return FALSE;
+
+	*child = index->children[lo];
+	*child_position = index->positions[lo];
+
+	return TRUE;
+}
+
+/**
+ * html_clue_get_child_position:
+ * @clue: An HTMLClue.
+ * @child: A child of @clue, not a text slave.
+ * @child_position: Return location for the start position of @child.
+ *
+ * Gets the position where @child starts, relative to the start of @clue.
+ *
+ * Return value: %FALSE if @child is not indexed in @clue.
+ **/
+gboolean
+html_clue_get_child_position (HTMLClue *clue,
+                              HTMLObject *child,
+                              guint *child_position)
+{
+	HTMLCluePositionIndex *index;
+	guint lo, hi;
+
+	g_return_val_if_fail (clue != NULL, FALSE);
+
+	index = position_index_get (clue);
+
+	lo = 0;
+	hi = index->n_children;
+	while (lo < hi) {
+		guint mid = (lo + hi) / 2;
+		HTMLObject *o = index->children[index->by_address[mid]];
+
+		if (o == child) {
+			*child_position = index->positions[index->by_address[mid]];
+			return TRUE;
+		}
+		if (GPOINTER_TO_SIZE (o) < GPOINTER_TO_SIZE (child))
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return FALSE;
+}
@@ -33,6 +33,11 @@ struct _HTMLClue {
 	HTMLObject *tail;
 	HTMLObject *curr;
 
+	/* sum of the children's recursive lengths, -1 when not known */
+	gint recursive_length;
+	/* start positions of the children, dropped with recursive_length */
+	HTMLCluePositionIndex *position_index;
+
 	HTMLVAlignType valign;
 	HTMLHAlignType halign;
 };
@@ -99,5 +104,12 @@ void      html_clue_remove                (HTMLClue      *clue,
 					   HTMLObject    *o);
 void      html_clue_remove_text_slaves    (HTMLClue      *clue);
 gboolean  html_clue_is_empty              (HTMLClue      *clue);
+gboolean  html_clue_get_child_at_position (HTMLClue      *clue,
+					   guint          position,
+					   HTMLObject   **child,
+					   guint         *child_position);
+gboolean  html_clue_get_child_position    (HTMLClue      *clue,
+					   HTMLObject    *child,
+					   guint         *child_position);
 
 #endif /* HTMLCLUE_H */
@@ -438,8 +438,8 @@ merge (HTMLObject *self,
 	return rv;
 }
 
-static guint
-calc_padding (HTMLPainter *painter)
+guint
+html_clueflow_calc_padding (HTMLPainter *painter)
 {
 	if (!HTML_IS_PLAIN_PAINTER (painter)) {
 		return 2 * html_painter_get_space_width (painter, GTK_HTML_FONT_STYLE_SIZE_3, NULL);
@@ -1132,7 +1132,7 @@ html_clue_flow_real_calc_size (HTMLObject *o,
 	o->width = MAX (o->max_width, html_object_calc_min_width (o, painter));
 
 	/* calc size */
-	padding = calc_padding (painter);
+	padding = html_clueflow_calc_padding (painter);
 	add_pre_padding (cf, padding);
 	changed = html_clue_flow_layout (o, painter, changed_objs, &leaf_children_changed_size);
 	add_post_padding (cf, padding);
@@ -2088,6 +2088,14 @@ utf8_length_in_width (const gchar *str,
 	return l;
 }
 
+/* the parallel plain text export doesn't use the painter outside of the
+ * main thread, it supplies the padding and its own pango context instead */
+static guint
+save_plain_padding (HTMLEngineSaveState *state)
+{
+	return state->pango_context ? state->padding : html_clueflow_calc_padding (state->engine->painter);
+}
+
 static gboolean
 save_plain (HTMLObject *self,
             HTMLEngineSaveState *state,
@@ -2107,6 +2115,8 @@ save_plain (HTMLObject *self,
 	pad = plain_padding (flow, NULL, FALSE);
 	buffer_state = html_engine_save_buffer_new (state->engine,
 						    state->inline_frames);
+	buffer_state->pango_context = state->pango_context;
+	buffer_state->padding = state->padding;
 	max_width = MAX (requested_width - pad, 0);
 	/* buffer the paragraph's content into the save buffer */
 	if (HTML_OBJECT_CLASS (&html_clue_class)->save_plain (self,
@@ -2115,7 +2125,7 @@ save_plain (HTMLObject *self,
 		guchar *s;
 		gint offset;
 
-		if (get_pre_padding (flow, calc_padding (state->engine->painter)) > 0) {
+		if (get_pre_padding (flow, save_plain_padding (state)) > 0) {
 			plain_padding (flow, out, FALSE);
 			g_string_append (out, "\n");
 		}
@@ -2129,7 +2139,7 @@ save_plain (HTMLObject *self,
 			PangoAttrList *attrs = pango_attr_list_new ();
 			gint bytes = html_engine_save_buffer_peek_text_bytes (buffer_state), slen = g_utf8_strlen ((gchar *) s, -1), i, clen, n_items;
 			GList *items_list, *cur;
-			PangoContext *pc = state->engine->painter->pango_context;
+			PangoContext *pc = state->pango_context ? state->pango_context : state->engine->painter->pango_context;
 			PangoLogAttr *lattrs;
 			PangoItem **items;
 			gint len, width, skip;
@@ -2262,7 +2272,7 @@ save_plain (HTMLObject *self,
 			g_free (lattrs);
 		}
 
-		if (get_post_padding (flow, calc_padding (state->engine->painter)) > 0) {
+		if (get_post_padding (flow, save_plain_padding (state)) > 0) {
 			plain_padding (flow, out, FALSE);
 			g_string_append (out, "\n");
 		}
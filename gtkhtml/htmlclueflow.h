@@ -133,6 +133,7 @@ gboolean           html_clueflow_style_equals                 (HTMLClueFlow
 
 void               html_clueflow_set_item_color               (HTMLClueFlow       *flow,
 							       HTMLColor          *color);
+guint              html_clueflow_calc_padding                 (HTMLPainter        *painter);
 
 #define SPELL_CHECK(f, e) if (f && HTML_OBJECT_TYPE (f) == HTML_TYPE_CLUEFLOW) \
                                    html_clueflow_spell_check (HTML_CLUEFLOW (f), e, NULL)
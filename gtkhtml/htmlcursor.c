@@ -30,6 +30,7 @@
 
 #include "gtkhtml-private.h"
 #include "htmlclue.h"
+#include "htmlcluev.h"
 #include "htmlengine.h"
 #include "htmlengine-edit.h"
 #include "htmltext.h"
@@ -40,6 +41,11 @@
 
 static gboolean move_right (HTMLCursor *cursor, HTMLEngine *e);
 static gboolean move_left (HTMLCursor *cursor, HTMLEngine *e);
+static gboolean get_indexed_position (HTMLEngine *engine, HTMLObject *object, guint offset, gint *position);
+static gboolean jump_to_indexed_position (HTMLCursor *cursor, HTMLEngine *engine, gint position, gboolean exact_position);
+
+/* jumps shorter than this are cheaper to do step by step */
+#define POSITION_INDEX_MIN_DISTANCE 256
 
 #define _HTML_CURSOR_DEBUG
 
@@ -583,6 +589,7 @@ html_cursor_real_jump_to (HTMLCursor *cursor,
                           gboolean exact_position)
 {
 	HTMLCursor original;
+	gint position, i;
 
 	g_return_val_if_fail (cursor != NULL, FALSE);
 	g_return_val_if_fail (object != NULL, FALSE);
@@ -600,6 +607,24 @@ html_cursor_real_jump_to (HTMLCursor *cursor,
 
 	html_cursor_copy (&original, cursor);
 
+	/* try the neighbourhood before computing the target position */
+	for (i = 0; i < POSITION_INDEX_MIN_DISTANCE && forward (cursor, engine, exact_position); i++)
+		if (cursor->object == object && cursor->offset == offset)
+			return TRUE;
+	html_cursor_copy (cursor, &original);
+	for (i = 0; i < POSITION_INDEX_MIN_DISTANCE && backward (cursor, engine, exact_position); i++)
+		if (cursor->object == object && cursor->offset == offset)
+			return TRUE;
+	html_cursor_copy (cursor, &original);
+
+	if (get_indexed_position (engine, object, offset, &position)
+	    && jump_to_indexed_position (cursor, engine, position, exact_position)) {
+		html_cursor_normalize (cursor);
+		if (cursor->object == object && cursor->offset == offset)
+			return TRUE;
+		html_cursor_copy (cursor, &original);
+	}
+
 	while (forward (cursor, engine, exact_position)) {
 		if (cursor->object == object && cursor->offset == offset)
 			return TRUE;
@@ -692,6 +717,127 @@ html_cursor_end_of_document (HTMLCursor *cursor,
 		;
 }
 
+/* Position index.
+ *
+ * Cursor positions advance by one per character and by one between
+ * objects, which is exactly what html_object_get_recursive_length ()
+ * counts.  The start positions of the children that clues keep on top of
+ * the cached lengths therefore map positions to objects and back with a
+ * binary search per tree level, without stepping through every
+ * character in between.  The descent only trusts containers whose
+ * length matches the cursor movement across them: flows and block
+ * (or toplevel) vertical clues.  Anything else, tables in particular,
+ * is left to the step by step movement.  */
+
+static gboolean
+position_index_trusts (HTMLObject *o)
+{
+	switch (HTML_OBJECT_TYPE (o)) {
+	case HTML_TYPE_CLUEFLOW:
+		return TRUE;
+	case HTML_TYPE_CLUEV:
+		return o->parent == NULL || HTML_CLUEV (o)->display == DISPLAY_BLOCK;
+	default:
+		return FALSE;
+	}
+}
+
+static gboolean
+position_index_locate (HTMLObject *clue,
+                       gint position,
+                       HTMLObject **object,
+                       guint *offset)
+{
+	HTMLObject *child;
+	guint start;
+
+	/* children before this one end before position */
+	if (!html_clue_get_child_at_position (HTML_CLUE (clue), position, &child, &start))
+		return FALSE;
+	position -= start;
+
+	for (; child; child = html_object_next_not_slave (child)) {
+		gint len;
+
+		if (html_object_is_container (child)) {
+			len = html_object_get_recursive_length (child);
+			if (position < len || (position == len && !html_object_next_not_slave (child)))
+				return position_index_trusts (child)
+					&& position_index_locate (child, position, object, offset);
+		} else {
+			len = html_object_get_length (child);
+			if (position <= len && html_object_accepts_cursor (child)) {
+				*object = child;
+				*offset = position;
+				return TRUE;
+			}
+		}
+		position -= len;
+	}
+
+	return FALSE;
+}
+
+static gboolean
+get_indexed_position (HTMLEngine *engine,
+                      HTMLObject *object,
+                      guint offset,
+                      gint *position)
+{
+	HTMLObject *o;
+	gint pos = offset;
+
+	if (html_object_is_container (object) || !html_object_accepts_cursor (object))
+		return FALSE;
+
+	for (o = object; o->parent; o = o->parent) {
+		guint start;
+
+		if (!position_index_trusts (o->parent)
+		    || !html_clue_get_child_position (HTML_CLUE (o->parent), o, &start))
+			return FALSE;
+
+		pos += start;
+	}
+
+	if (o != engine->clue)
+		return FALSE;
+
+	*position = pos;
+
+	return TRUE;
+}
+
+static gboolean
+jump_to_indexed_position (HTMLCursor *cursor,
+                          HTMLEngine *engine,
+                          gint position,
+                          gboolean exact_position)
+{
+	HTMLObject *object;
+	guint offset;
+
+	if (ABS (position - cursor->position) < POSITION_INDEX_MIN_DISTANCE || !engine->clue
+	    || !position_index_trusts (engine->clue)
+	    || !position_index_locate (engine->clue, position, &object, &offset))
+		return FALSE;
+
+	cursor->object = object;
+	cursor->offset = offset;
+	cursor->position = position;
+
+	/* stepping forward stops at the first cursor position at or past the
+	 * target, landing inside a cluster has to do the same */
+	if (!exact_position && html_object_is_text (object) && offset > 0 && offset < html_object_get_length (object)) {
+		HTMLTextPangoInfo *pi = html_text_get_pango_info (HTML_TEXT (object), engine->painter);
+
+		if (!pi->attrs[offset].is_cursor_position)
+			forward (cursor, engine, FALSE);
+	}
+
+	return TRUE;
+}
+
 gint
 html_cursor_get_position (HTMLCursor *cursor)
 {
@@ -712,6 +858,8 @@ html_cursor_real_jump_to_position (HTMLCursor *cursor,
 	if (engine->need_spell_check)
 		html_engine_spell_check_range (engine, engine->cursor, engine->cursor);
 
+	jump_to_indexed_position (cursor, engine, position, exact_position);
+
 	if (cursor->position < position) {
 		while (cursor->position < position) {
 			if (!forward (cursor, engine, exact_position))
@@ -32,49 +32,10 @@
 #include "htmlsettings.h"
 #include "gtkhtml.h"
 
-/* HTMLDrawQueueClearElement handling.  */
-
-static HTMLDrawQueueClearElement *
-clear_element_new (gint x,
-                   gint y,
-                   guint width,
-                   guint height,
-                   const GdkColor *background_color)
-{
-	HTMLDrawQueueClearElement *new;
-
-	new = g_new (HTMLDrawQueueClearElement, 1);
-
-	new->x = x;
-	new->y = y;
-	new->width = width;
-	new->height = height;
-
-	/* GDK color API non const-correct.  */
-	new->background_color = gdk_color_copy ((GdkColor *) background_color);
-
-	new->background_image = NULL;
-	new->background_image_x_offset = 0;
-	new->background_image_y_offset = 0;
-
-	return new;
-}
+/* The queue collects the objects and areas to be redrawn; a flush turns
+ * them into a single region of the window, so that any number of queued
+ * changes is repainted by one expose.  */
 
-static void
-clear_element_destroy (HTMLDrawQueueClearElement *elem)
-{
-	g_return_if_fail (elem != NULL);
-
-	if (elem->background_color != NULL)
-		gdk_color_free (elem->background_color);
-
-	if (elem->background_image != NULL)
-		g_object_unref (elem->background_image);
-
-	g_free (elem);
-}
-
-
 HTMLDrawQueue *
 html_draw_queue_new (HTMLEngine *engine)
 {
@@ -89,8 +50,12 @@ html_draw_queue_new (HTMLEngine *engine)
 	new->elems = NULL;
 	new->last = NULL;
 
-	new->clear_elems = NULL;
-	new->clear_last = NULL;
+	new->clear_region = NULL;
+	new->n_clears = 0;
+
+	new->flushes = 0;
+	new->flushed_items = 0;
+	new->flushed_area = 0;
 
 	return new;
 }
@@ -111,9 +76,18 @@ html_draw_queue_destroy (HTMLDrawQueue *queue)
 
 	g_list_free (queue->elems);
 
+	if (queue->clear_region)
+		cairo_region_destroy (queue->clear_region);
+
 	g_free (queue);
 }
 
+static gboolean
+is_empty (HTMLDrawQueue *queue)
+{
+	return queue->elems == NULL && queue->clear_region == NULL;
+}
+
 void
 html_draw_queue_add (HTMLDrawQueue *queue,
                      HTMLObject *object)
@@ -126,32 +100,19 @@ html_draw_queue_add (HTMLDrawQueue *queue,
 
 	object->redraw_pending = TRUE;
 
-	queue->last = g_list_append (queue->last, object);
-
-	if (queue->elems == NULL && queue->clear_elems == NULL)
+	if (is_empty (queue))
 		g_signal_emit_by_name (queue->engine, "draw_pending");
 
+	queue->last = g_list_append (queue->last, object);
+
 	if (queue->elems == NULL)
 		queue->elems = queue->last;
 	else
 		queue->last = queue->last->next;
 }
 
-
-static void
-add_clear (HTMLDrawQueue *queue,
-           HTMLDrawQueueClearElement *elem)
-{
-	queue->clear_last = g_list_append (queue->clear_last, elem);
-	if (queue->elems == NULL && queue->clear_elems == NULL)
-		g_signal_emit_by_name (queue->engine, "draw_pending");
-
-	if (queue->clear_elems == NULL)
-		queue->clear_elems = queue->clear_last;
-	else
-		queue->clear_last = queue->clear_last->next;
-}
-
+/* The area is cleared with the background of the engine when it is
+ * redrawn, background_color is kept for compatibility only.  */
 void
 html_draw_queue_add_clear (HTMLDrawQueue *queue,
                            gint x,
@@ -160,67 +121,74 @@ html_draw_queue_add_clear (HTMLDrawQueue *queue,
                            guint height,
                            const GdkColor *background_color)
 {
-	HTMLDrawQueueClearElement *new;
+	cairo_rectangle_int_t rect;
 
 	g_return_if_fail (queue != NULL);
 	g_return_if_fail (background_color != NULL);
 
-	new = clear_element_new (x, y, width, height, background_color);
-	add_clear (queue, new);
+	if (width == 0 || height == 0)
+		return;
+
+	if (is_empty (queue))
+		g_signal_emit_by_name (queue->engine, "draw_pending");
+
+	rect.x = x;
+	rect.y = y;
+	rect.width = width;
+	rect.height = height;
+
+	if (queue->clear_region)
+		cairo_region_union_rectangle (queue->clear_region, &rect);
+	else
+		queue->clear_region = cairo_region_create_rectangle (&rect);
+	queue->n_clears++;
 }
 
 static void
-draw_obj (HTMLDrawQueue *queue,
-          HTMLObject *obj)
+add_obj (HTMLDrawQueue *queue,
+         cairo_region_t *region,
+         HTMLObject *obj)
 {
-	HTMLEngine *e;
+	HTMLEngine *e = queue->engine;
 	gint x1, y1, x2, y2;
 	gint tx, ty;
 
 	if (obj->width == 0 || obj->ascent + obj->descent == 0)
 		return;
 
-	e = queue->engine;
-	e->clue->x = html_engine_get_left_border (e);
-	e->clue->y = html_engine_get_top_border (e) + e->clue->ascent;
-
 	html_object_engine_translation (obj, e, &tx, &ty);
 	if (html_object_engine_intersection (obj, e, tx, ty, &x1, &y1, &x2, &y2)) {
-		GdkRectangle paint;
+		cairo_rectangle_int_t paint;
 
 		paint.x = x1;
 		paint.y = y1;
 		paint.width = x2 - x1;
 		paint.height = y2 - y1;
-		gdk_window_invalidate_rect (HTML_GDK_PAINTER (e->painter)->window, &paint, FALSE);
+		cairo_region_union_rectangle (region, &paint);
 	}
 }
 
 static void
-clear (HTMLDrawQueue *queue,
-       HTMLDrawQueueClearElement *elem)
+add_clear (HTMLDrawQueue *queue,
+           cairo_region_t *region,
+           const cairo_rectangle_int_t *rect)
 {
-	HTMLEngine *e;
 	gint x1, y1, x2, y2;
 
-	e = queue->engine;
-	e->clue->x = html_engine_get_left_border (e);
-	e->clue->y = html_engine_get_top_border (e) + e->clue->ascent;
-
-	x1 = elem->x;
-	y1 = elem->y;
+	x1 = rect->x;
+	y1 = rect->y;
 
-	x2 = x1 + elem->width;
-	y2 = y1 + elem->height;
+	x2 = x1 + rect->width;
+	y2 = y1 + rect->height;
 
-	if (html_engine_intersection (e, &x1, &y1, &x2, &y2)) {
-		GdkRectangle paint;
+	if (html_engine_intersection (queue->engine, &x1, &y1, &x2, &y2)) {
+		cairo_rectangle_int_t paint;
 
 		paint.x = x1;
 		paint.y = y1;
 		paint.width = x2 - x1;
 		paint.height = y2 - y1;
-		gdk_window_invalidate_rect (HTML_GDK_PAINTER (e->painter)->window, &paint, FALSE);
+		cairo_region_union_rectangle (region, &paint);
 	}
 }
 
@@ -239,11 +207,13 @@ html_draw_queue_clear (HTMLDrawQueue *queue)
 		}
 	}
 
-	g_list_free (queue->clear_elems);
 	g_list_free (queue->elems);
 
-	queue->clear_elems = NULL;
-	queue->clear_last = NULL;
+	if (queue->clear_region)
+		cairo_region_destroy (queue->clear_region);
+
+	queue->clear_region = NULL;
+	queue->n_clears = 0;
 	queue->elems = NULL;
 	queue->last = NULL;
 }
@@ -251,36 +221,60 @@ html_draw_queue_clear (HTMLDrawQueue *queue)
 void
 html_draw_queue_flush (HTMLDrawQueue *queue)
 {
+	HTMLEngine *e = queue->engine;
+	cairo_region_t *region;
 	GList *p;
-	GdkVisual *vis;
+	gint i, n;
 
 	/* check to make sure we have something to draw on */
 
-	vis = queue->engine->window ? gdk_window_get_visual (queue->engine->window): NULL;
+	if (!e->window || !gdk_window_get_visual (e->window) || is_empty (queue)) {
+		html_draw_queue_clear (queue);
+		return;
+	}
+
+	e->clue->x = html_engine_get_left_border (e);
+	e->clue->y = html_engine_get_top_border (e) + e->clue->ascent;
+
+	region = cairo_region_create ();
 
-	/* Draw clear areas.  */
+	/* Clear areas.  */
 
-	for (p = queue->clear_elems; p != NULL; p = p->next) {
-		HTMLDrawQueueClearElement *clear_elem;
+	if (queue->clear_region) {
+		n = cairo_region_num_rectangles (queue->clear_region);
+		for (i = 0; i < n; i++) {
+			cairo_rectangle_int_t rect;
 
-		clear_elem = p->data;
-		if (vis)
-			clear (queue, clear_elem);
-		clear_element_destroy (clear_elem);
+			cairo_region_get_rectangle (queue->clear_region, i, &rect);
+			add_clear (queue, region, &rect);
+		}
+		queue->flushed_items += queue->n_clears;
 	}
 
-	/* Draw objects.  */
+	/* Objects.  */
 
-	if (vis) {
-		for (p = queue->elems; p != NULL; p = p->next) {
-			HTMLObject *obj = HTML_OBJECT (p->data);
+	for (p = queue->elems; p != NULL; p = p->next) {
+		HTMLObject *obj = HTML_OBJECT (p->data);
 
-			if (obj->redraw_pending && !obj->free_pending) {
-				draw_obj (queue, obj);
-				obj->redraw_pending = FALSE;
-			}
+		if (obj->redraw_pending && !obj->free_pending) {
+			add_obj (queue, region, obj);
+			obj->redraw_pending = FALSE;
+			queue->flushed_items++;
 		}
 	}
+
+	n = cairo_region_num_rectangles (region);
+	for (i = 0; i < n; i++) {
+		cairo_rectangle_int_t rect;
+
+		cairo_region_get_rectangle (region, i, &rect);
+		queue->flushed_area += (guint64) rect.width * rect.height;
+	}
+	queue->flushes++;
+
+	if (!cairo_region_is_empty (region))
+		gdk_window_invalidate_region (HTML_GDK_PAINTER (e->painter)->window, region, FALSE);
+	cairo_region_destroy (region);
+
 	html_draw_queue_clear (queue);
 }
-
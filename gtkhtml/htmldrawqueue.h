@@ -24,30 +24,28 @@
 #include <gtk/gtk.h>
 #include "htmltypes.h"
 
-struct _HTMLDrawQueueClearElement {
-	gint x, y;
-	guint width, height;
-	GdkColor *background_color;
-	GdkPixbuf *background_image;
-	guint background_image_x_offset, background_image_y_offset;
-};
-
 struct _HTMLDrawQueue {
 	/* The associated engine.  */
 	HTMLEngine *engine;
 
-	/* Elements to be drawn.  */
+	/* Elements to be drawn, each one queued only once.  */
 	GList *elems;
 	/* Pointer to the last element in the list, for faster appending.  */
 	GList *last;
 
-	/* Elements to be cleared (HTMLDrawQueueClearElement).  */
-	GList *clear_elems;
-	/* Pointer to the last element.  */
-	GList *clear_last;
+	/* Areas to be cleared, in document coordinates, and the number
+	 * of clears they were queued by.  */
+	cairo_region_t *clear_region;
+	guint n_clears;
+
+	/* Statistics: the number of flushes, of objects and clears they
+	 * processed and of pixels they invalidated.  */
+	guint flushes;
+	guint flushed_items;
+	guint64 flushed_area;
 };
 
-
+
 /* Creation/destruction.  */
 HTMLDrawQueue *html_draw_queue_new      (HTMLEngine    *engine);
 void           html_draw_queue_destroy  (HTMLDrawQueue *queue);
@@ -65,13 +63,5 @@ void  html_draw_queue_add_clear                  (HTMLDrawQueue  *queue,
 						  guint           width,
 						  guint           height,
 						  const GdkColor *background_color);
-void  html_draw_queue_add_clear_with_background  (HTMLDrawQueue  *queue,
-						  gint            x,
-						  gint            y,
-						  guint           width,
-						  guint           height,
-						  GdkPixbuf      *background_image,
-						  guint           image_x_offset,
-						  guint           image_y_offset);
 
 #endif /* _HTMLDRAWQUEUE_H */
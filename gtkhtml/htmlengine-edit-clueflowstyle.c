@@ -77,6 +77,21 @@ style_operation_destroy (HTMLUndoData *data)
 	free_prop_list (((ClueFlowStyleOperation *) data)->prop_list);
 }
 
+static gsize
+style_operation_get_size (HTMLUndoData *data)
+{
+	gsize size = sizeof (ClueFlowStyleOperation);
+	GList *p;
+
+	for (p = ((ClueFlowStyleOperation *) data)->prop_list; p != NULL; p = p->next) {
+		ClueFlowProps *props = (ClueFlowProps *) p->data;
+
+		size += sizeof (GList) + sizeof (ClueFlowProps) + sizeof (GByteArray) + props->levels->len;
+	}
+
+	return size;
+}
+
 static ClueFlowStyleOperation *
 style_operation_new (GList *prop_list,
                      gboolean forward)
@@ -87,9 +102,10 @@ style_operation_new (GList *prop_list,
 
 	html_undo_data_init (HTML_UNDO_DATA (op));
 
-	op->data.destroy = style_operation_destroy;
-	op->prop_list    = prop_list;
-	op->forward      = forward;
+	op->data.destroy  = style_operation_destroy;
+	op->data.get_size = style_operation_get_size;
+	op->prop_list     = prop_list;
+	op->forward       = forward;
 
 	return op;
 }
@@ -32,6 +32,7 @@
 #include "htmlclue.h"
 #include "htmlcluealigned.h"
 #include "htmlclueflow.h"
+#include "htmlcluev.h"
 #include "htmlcursor.h"
 #include "htmlcolorset.h"
 #include "htmlengine.h"
@@ -487,6 +488,7 @@ delete_setup_undo (HTMLEngine *e,
 #endif
 	html_undo_data_init (HTML_UNDO_DATA (undo));
 	undo->data.destroy = delete_undo_destroy;
+	undo->data.size    = sizeof (DeleteUndo) + (buffer ? html_object_get_memory_size (buffer) : 0);
 	undo->buffer       = buffer;
 	undo->buffer_len   = len;
 	undo->level        = level;
@@ -1042,6 +1044,23 @@ insert_undo_action (HTMLEngine *e,
 	}
 }
 
+static gboolean
+insert_undo_merge (HTMLUndoData *data,
+                   HTMLUndoData *next)
+{
+	InsertUndo *undo = (InsertUndo *) data;
+	InsertUndo *next_undo = (InsertUndo *) next;
+
+	if (undo->delete_paragraph_before || undo->delete_paragraph_after
+	    || next_undo->delete_paragraph_before || next_undo->delete_paragraph_after
+	    || undo->len + next_undo->len > HTML_UNDO_COALESCE_LIMIT)
+		return FALSE;
+
+	undo->len += next_undo->len;
+
+	return TRUE;
+}
+
 static void
 insert_setup_undo (HTMLEngine *e,
                    guint len,
@@ -1055,6 +1074,8 @@ insert_setup_undo (HTMLEngine *e,
 	undo = g_new (InsertUndo, 1);
 
 	html_undo_data_init (HTML_UNDO_DATA (undo));
+	undo->data.merge = insert_undo_merge;
+	undo->data.size = sizeof (InsertUndo);
 	undo->len = len;
 	undo->delete_paragraph_before = delete_paragraph_before;
 	undo->delete_paragraph_after  = delete_paragraph_after;
@@ -1494,6 +1515,84 @@ use_pictograms (HTMLEngine *e)
 	}
 }
 
+/* Builds the paragraphs of multi-line text as flows in a clue, so that
+ * large texts are inserted with one insert_object () instead of one text
+ * and one empty paragraph insertion per line. The flows are duplicated
+ * from the cursor flow the same way html_engine_insert_empty_paragraph ()
+ * splits it. */
+static HTMLObject *
+new_flows_from_text (HTMLEngine *e,
+                     HTMLClueFlow *current,
+                     const gchar *text,
+                     gsize bytes,
+                     PangoAttrList *attrs)
+{
+	HTMLObject *cluev, *flow, *o;
+	HTMLClueFlowStyle style;
+	HTMLDirection dir;
+	const gchar *end, *nl;
+	gint alen;
+
+	style = html_clueflow_get_style (current);
+	if (style == HTML_CLUEFLOW_STYLE_H1 || style == HTML_CLUEFLOW_STYLE_H2 || style == HTML_CLUEFLOW_STYLE_H3 || style == HTML_CLUEFLOW_STYLE_H4 || style == HTML_CLUEFLOW_STYLE_H5 || style == HTML_CLUEFLOW_STYLE_H6)
+		style = HTML_CLUEFLOW_STYLE_NORMAL;
+	dir = html_text_direction_pango_to_html (gdk_keymap_get_direction (gdk_keymap_get_for_display (gtk_widget_get_display (GTK_WIDGET (e->widget)))));
+
+	cluev = html_cluev_new (0, 0, 100);
+	end = text + bytes;
+	do {
+		nl   = memchr (text, '\n', end - text);
+		alen = g_utf8_pointer_to_offset (text, nl ? nl : end);
+
+		flow = html_object_dup (HTML_OBJECT (current));
+		HTML_CLUEFLOW (flow)->style = style;
+		HTML_CLUEFLOW (flow)->dir = dir;
+
+		if (alen) {
+			/* stop inserting links after space */
+			if (*text == ' ')
+				html_engine_set_insertion_link (e, NULL, NULL);
+
+			o = html_engine_new_text (e, text, alen);
+			if (attrs)
+				HTML_TEXT (o)->extra_attr_list = pango_attr_list_copy (attrs);
+			html_text_convert_nbsp (HTML_TEXT (o));
+		} else
+			o = html_engine_new_text_empty (e);
+
+		html_clue_append (HTML_CLUE (flow), o);
+		html_clue_append (HTML_CLUE (cluev), flow);
+
+		if (nl)
+			text = nl + 1;
+	} while (nl);
+
+	return cluev;
+}
+
+/* Links the URLs in the inserted lines from position start to stop, the
+ * end of the last line ended by a newline, as inserting the newline alone
+ * does. */
+static void
+magic_links_ended_lines (HTMLEngine *e,
+                         gint start,
+                         gint stop)
+{
+	HTMLCursor *begin, *end;
+	gint position = e->cursor->position;
+
+	begin = html_cursor_dup (e->cursor);
+	html_cursor_jump_to_position_no_spell (begin, e, start);
+	end = html_cursor_dup (e->cursor);
+	html_cursor_jump_to_position_no_spell (end, e, stop);
+
+	html_engine_magic_links_range (e, begin, end);
+	html_cursor_jump_to_position_no_spell (e->cursor, e, position);
+
+	html_cursor_destroy (begin);
+	html_cursor_destroy (end);
+}
+
 void
 html_engine_insert_text_with_extra_attributes (HTMLEngine *e,
                                                const gchar *ptext,
@@ -1502,6 +1601,7 @@ html_engine_insert_text_with_extra_attributes (HTMLEngine *e,
 {
 	gchar *nl, *sanitized_text = NULL;
 	const gchar *text;
+	HTMLClueFlow *flow;
 	gint alen;
 	gsize bytes;
 
@@ -1517,6 +1617,21 @@ html_engine_insert_text_with_extra_attributes (HTMLEngine *e,
 	/* FIXME add insert text event */
 	gtk_html_editor_event_command (e->widget, GTK_HTML_COMMAND_INSERT_PARAGRAPH, TRUE);
 
+	flow = html_object_get_flow (e->cursor->object);
+	if (flow && memchr (text, '\n', bytes)) {
+		HTMLObject *o;
+		gint start = e->cursor->position;
+
+		o = new_flows_from_text (e, flow, text, bytes, attrs);
+		insert_object (e, o, len, e->cursor->position + len,
+			       html_engine_get_insert_level_for_object (e, o), HTML_UNDO_UNDO, TRUE);
+		if (gtk_html_get_magic_links (e->widget))
+			magic_links_ended_lines (e, start, start + len - 1 - g_utf8_pointer_to_offset (g_strrstr_len (text, bytes, "\n") + 1, text + bytes));
+		html_undo_level_end (e->undo, e);
+		g_free (sanitized_text);
+		return;
+	}
+
 	do {
 		nl   = memchr (text, '\n', bytes);
 		alen = nl ? g_utf8_pointer_to_offset (text, nl) : len;
@@ -1533,7 +1648,7 @@ html_engine_insert_text_with_extra_attributes (HTMLEngine *e,
 			o = html_engine_new_text (e, text, alen);
 			if (attrs)
 				HTML_TEXT (o)->extra_attr_list = pango_attr_list_copy (attrs);
-			html_text_convert_nbsp (HTML_TEXT (o), TRUE);
+			html_text_convert_nbsp (HTML_TEXT (o));
 
 			if (alen == 1 && html_is_in_word (html_text_get_char (HTML_TEXT (o), 0))
 			    && !html_is_in_word (html_cursor_get_current_char (e->cursor))) {
@@ -329,6 +329,7 @@ set_empty_flow_style (HTMLEngine *e,
 	undo->and_mask = and_mask;
 	undo->or_mask = old_or_mask;
 	undo->data.destroy = NULL;
+	undo->data.size = sizeof (HTMLEmptyParaSetStyle);
 	html_undo_add_action (e->undo, e,
 			      html_undo_action_new ("Set empty paragraph text style", set_empty_flow_style_undo_action,
 						    HTML_UNDO_DATA (undo), html_cursor_get_position (e->cursor),
@@ -22,6 +22,7 @@
 */
 
 #include <config.h>
+#include <string.h>
 #include "htmlcluealigned.h"
 #include "htmlclueflow.h"
 #include "htmlcursor.h"
@@ -148,6 +149,7 @@ insert_undo_data_new (gint pos)
 	InsertCellsUndo *ud = g_new0 (InsertCellsUndo, 1);
 
 	html_undo_data_init (HTML_UNDO_DATA (ud));
+	ud->data.size = sizeof (InsertCellsUndo);
 	ud->pos = pos;
 
 	return HTML_UNDO_DATA (ud);
@@ -347,6 +349,20 @@ delete_cells_undo_destroy (HTMLUndoData *undo_data)
 	g_free (data->cells);
 }
 
+static gsize
+delete_cells_undo_get_size (HTMLUndoData *undo_data)
+{
+	DeleteCellsUndo *data = (DeleteCellsUndo *) undo_data;
+	gsize size = sizeof (DeleteCellsUndo) + data->size * sizeof (HTMLTableCell *);
+	gint i;
+
+	for (i = 0; i < data->size; i++)
+		if (data->cells[i])
+			size += html_object_get_memory_size (HTML_OBJECT (data->cells[i]));
+
+	return size;
+}
+
 static DeleteCellsUndo *
 delete_cells_undo_new (HTMLTableCell **cells,
                        gint size,
@@ -358,7 +374,8 @@ delete_cells_undo_new (HTMLTableCell **cells,
 
 	html_undo_data_init (HTML_UNDO_DATA (data));
 
-	data->data.destroy = delete_cells_undo_destroy;
+	data->data.destroy  = delete_cells_undo_destroy;
+	data->data.get_size = delete_cells_undo_get_size;
 	data->cells        = cells;
 	data->pos          = pos;
 	data->size         = size;
@@ -833,14 +850,26 @@ attr_destroy (HTMLUndoData *undo_data)
 	}
 }
 
+static gsize
+attr_get_size (HTMLUndoData *undo_data)
+{
+	HTMLTableSetAttrUndo *data = (HTMLTableSetAttrUndo *) undo_data;
+
+	if (data->type == HTML_TABLE_BGPIXMAP && data->attr.pixmap)
+		return sizeof (HTMLTableSetAttrUndo) + strlen (data->attr.pixmap) + 1;
+
+	return sizeof (HTMLTableSetAttrUndo);
+}
+
 static HTMLTableSetAttrUndo *
 attr_undo_new (HTMLTableAttrType type)
 {
 	HTMLTableSetAttrUndo *undo = g_new (HTMLTableSetAttrUndo, 1);
 
 	html_undo_data_init (HTML_UNDO_DATA (undo));
-	undo->data.destroy = attr_destroy;
-	undo->type         = type;
+	undo->data.destroy  = attr_destroy;
+	undo->data.get_size = attr_get_size;
+	undo->type          = type;
 
 	return undo;
 }
@@ -21,6 +21,7 @@
 */
 
 #include <config.h>
+#include <string.h>
 #include "htmlcursor.h"
 #include "htmlengine.h"
 #include "htmlengine-edit.h"
@@ -97,14 +98,26 @@ attr_destroy (HTMLUndoData *undo_data)
 	}
 }
 
+static gsize
+attr_get_size (HTMLUndoData *undo_data)
+{
+	HTMLTableCellSetAttrUndo *data = (HTMLTableCellSetAttrUndo *) undo_data;
+
+	if (data->type == HTML_TABLE_CELL_BGPIXMAP && data->attr.pixmap)
+		return sizeof (HTMLTableCellSetAttrUndo) + strlen (data->attr.pixmap) + 1;
+
+	return sizeof (HTMLTableCellSetAttrUndo);
+}
+
 static HTMLTableCellSetAttrUndo *
 attr_undo_new (HTMLTableCellAttrType type)
 {
 	HTMLTableCellSetAttrUndo *undo = g_new (HTMLTableCellSetAttrUndo, 1);
 
 	html_undo_data_init (HTML_UNDO_DATA (undo));
-	undo->data.destroy = attr_destroy;
-	undo->type         = type;
+	undo->data.destroy  = attr_destroy;
+	undo->data.get_size = attr_get_size;
+	undo->type          = type;
 
 	return undo;
 }
@@ -591,6 +604,27 @@ expand_undo_destroy (HTMLUndoData *undo_data)
 	g_slist_free (data->move_undo);
 }
 
+static gsize
+expand_undo_get_size (HTMLUndoData *undo_data)
+{
+	ExpandSpanUndo *data = EXPAND_UNDO (undo_data);
+	gsize size = sizeof (ExpandSpanUndo);
+	GSList *slist;
+	gint i;
+
+	for (slist = data->move_undo; slist; slist = slist->next) {
+		struct MoveCellRDUndo *undo = (struct MoveCellRDUndo *) slist->data;
+
+		size += sizeof (GSList) + sizeof (struct MoveCellRDUndo)
+			+ undo->rspan * undo->cspan * (sizeof (struct Move) + sizeof (HTMLTableCell *));
+		for (i = 0; i < undo->rspan * undo->cspan; i++)
+			if (undo->removed[i])
+				size += html_object_get_memory_size (HTML_OBJECT (undo->removed[i]));
+	}
+
+	return size;
+}
+
 static HTMLUndoData *
 expand_undo_data_new (gint span,
                       GSList *slist)
@@ -598,7 +632,8 @@ expand_undo_data_new (gint span,
 	ExpandSpanUndo *ud = g_new0 (ExpandSpanUndo, 1);
 
 	html_undo_data_init (HTML_UNDO_DATA (ud));
-	ud->data.destroy = expand_undo_destroy;
+	ud->data.destroy  = expand_undo_destroy;
+	ud->data.get_size = expand_undo_get_size;
 	ud->span = span;
 	ud->move_undo = slist;
 
@@ -724,6 +759,7 @@ collapse_undo_data_new (gint span)
 	CollapseSpanUndo *ud = g_new0 (CollapseSpanUndo, 1);
 
 	html_undo_data_init (HTML_UNDO_DATA (ud));
+	ud->data.size = sizeof (CollapseSpanUndo);
 	ud->span = span;
 
 	return HTML_UNDO_DATA (ud);
@@ -56,13 +56,12 @@ upper_lower (HTMLObject *obj,
 {
 	if (html_object_is_text (obj)) {
 		gboolean up = GPOINTER_TO_INT (data);
-		gchar *old_text;
+		gchar *new_text;
 
-		old_text = HTML_TEXT (obj)->text;
-		HTML_TEXT (obj)->text = up ? g_utf8_strup (old_text, -1) : g_utf8_strdown (old_text, -1);
-		g_free (old_text);
-		HTML_TEXT (obj)->text_len = g_utf8_strlen (HTML_TEXT (obj)->text, -1);
-		HTML_TEXT (obj)->text_bytes = strlen (HTML_TEXT (obj)->text);
+		/* the text string may be shared with the clipboard or undo copies */
+		new_text = up ? g_utf8_strup (HTML_TEXT (obj)->text, -1) : g_utf8_strdown (HTML_TEXT (obj)->text, -1);
+		html_text_set_text (HTML_TEXT (obj), new_text);
+		g_free (new_text);
 	}
 }
 
@@ -228,6 +228,13 @@ html_engine_spell_check_range (HTMLEngine *e,
 	if (!e->widget->editor_api || !gtk_html_get_inline_spelling (e->widget) || !begin->object->parent)
 		return;
 
+	if (e->batch_level > 0) {
+		/* checked in one go by html_engine_commit_batch () */
+		if (e->batch_spell_position < 0 || begin->position < e->batch_spell_position)
+			e->batch_spell_position = begin->position;
+		return;
+	}
+
 	begin = html_cursor_dup (begin);
 	end   = html_cursor_dup (end);
 
@@ -253,6 +260,83 @@ html_engine_spell_check_range (HTMLEngine *e,
 	html_cursor_destroy (end);
 }
 
+static void
+magic_links_object (HTMLObject *o,
+                    HTMLEngine *e,
+                    gpointer data)
+{
+	if (HTML_IS_TEXT (o))
+		html_text_magic_links (HTML_TEXT (o), e);
+}
+
+void
+html_engine_magic_links_range (HTMLEngine *e,
+                               HTMLCursor *begin,
+                               HTMLCursor *end)
+{
+	HTMLInterval *i;
+
+	g_return_if_fail (HTML_IS_ENGINE (e));
+
+	if (!begin->object->parent || !end->object->parent)
+		return;
+
+	i = html_interval_new_from_cursor (begin, end);
+	html_interval_forall (i, e, magic_links_object, NULL);
+	html_interval_destroy (i);
+}
+
+/* Batches group programmatic edits: relayout waits for the outermost
+   commit, the whole batch is one undo step and inline spell checking of
+   the edited text runs once at commit. Batches nest. */
+
+void
+html_engine_begin_batch (HTMLEngine *e)
+{
+	g_return_if_fail (HTML_IS_ENGINE (e));
+
+	if (e->batch_level++ > 0)
+		return;
+
+	e->batch_spell_position = -1;
+	html_engine_freeze (e);
+	html_undo_level_begin (e->undo, "Batch edit", "Revert batch edit");
+}
+
+void
+html_engine_commit_batch (HTMLEngine *e)
+{
+	g_return_if_fail (HTML_IS_ENGINE (e));
+	g_return_if_fail (e->batch_level > 0);
+
+	if (--e->batch_level > 0)
+		return;
+
+	html_undo_level_end (e->undo, e);
+
+	if (e->batch_spell_position >= 0) {
+		HTMLCursor *begin, *end;
+		gboolean need_spell_check;
+
+		need_spell_check = e->need_spell_check;
+		e->need_spell_check = FALSE;
+
+		begin = html_cursor_dup (e->cursor);
+		html_cursor_jump_to_position_no_spell (begin, e, e->batch_spell_position);
+		end = html_cursor_dup (begin);
+		html_cursor_end_of_document (end, e);
+
+		html_engine_spell_check_range (e, begin, end);
+		e->need_spell_check = need_spell_check;
+
+		html_cursor_destroy (begin);
+		html_cursor_destroy (end);
+		e->batch_spell_position = -1;
+	}
+
+	html_engine_thaw (e);
+}
+
 gboolean
 html_is_in_word (gunichar uc)
 {
@@ -59,6 +59,11 @@ void                       html_engine_cut_and_paste               (HTMLEngine
 void                       html_engine_spell_check_range           (HTMLEngine                *e,
 								    HTMLCursor                *begin,
 								    HTMLCursor                *end);
+void                       html_engine_magic_links_range           (HTMLEngine                *e,
+								    HTMLCursor                *begin,
+								    HTMLCursor                *end);
+void                       html_engine_begin_batch                 (HTMLEngine                *e);
+void                       html_engine_commit_batch                (HTMLEngine                *e);
 void                       html_engine_set_data_by_type            (HTMLEngine                *e,
 								    HTMLType                   object_type,
 								    const gchar               *key,
@@ -20,6 +20,7 @@
 */
 
 #include <config.h>
+#include <math.h>
 #include <gtk/gtk.h>
 #include <glib/gi18n-lib.h>
 #include "gtkhtml.h"
@@ -27,13 +28,164 @@
 #include "gtkhtml-private.h"
 #include "gtkhtml-properties.h"
 #include "htmlprinter.h"
+#include "htmlembedded.h"
 #include "htmlengine-print.h"
+#include "htmlimage.h"
 #include "htmlobject.h"
 
 
 
 /* #define CLIP_DEBUG */
 
+/* Printing lays out a detached copy of the document with the printer
+ * painter. The copy shares text and image data with the live tree, so it
+ * is cheap to make, and the visible engine keeps its painter and layout
+ * instead of being laid out for paper and then for the screen again.
+ * Documents with widgets or frames, which draw through the live engine,
+ * are still printed by switching the engine to the printer. */
+
+static void
+check_live_object (HTMLObject *o,
+                   HTMLEngine *e,
+                   gboolean *live)
+{
+	if (html_object_is_embedded (o) || HTML_OBJECT_TYPE (o) == HTML_TYPE_FRAMESET)
+		*live = TRUE;
+}
+
+static gint
+print_calc_min_width (HTMLEngine *engine,
+                      HTMLObject *clue,
+                      HTMLPainter *painter)
+{
+	if (clue == engine->clue)
+		return html_engine_calc_min_width (engine);
+
+	return html_object_calc_min_width (clue, painter)
+		+ html_painter_get_pixel_size (painter) * (engine->leftBorder + engine->rightBorder);
+}
+
+static void
+print_calc_size (HTMLEngine *engine,
+                 HTMLObject *clue,
+                 HTMLPainter *painter)
+{
+	gint pixel_size, max_width;
+
+	if (clue == engine->clue) {
+		html_engine_calc_size (engine, NULL);
+		return;
+	}
+
+	/* as html_engine_calc_size () with the printer as the engine painter */
+	pixel_size = html_painter_get_pixel_size (painter);
+	max_width = MAX (0, html_painter_get_page_width (painter, engine)
+			 - (engine->leftBorder + engine->rightBorder) * pixel_size);
+	max_width = MIN (max_width, pixel_size * (MAX_WIDGET_WIDTH - engine->leftBorder - engine->rightBorder));
+
+	html_object_reset (clue);
+	html_object_set_max_width (clue, painter, max_width);
+	html_object_calc_size (clue, painter, NULL);
+
+	clue->x = engine->leftBorder;
+	clue->y = clue->ascent + engine->topBorder;
+}
+
+static gint
+print_get_doc_height (HTMLEngine *engine,
+                      HTMLObject *clue)
+{
+	if (clue == engine->clue)
+		return html_engine_get_doc_height (engine);
+
+	return clue->ascent + clue->descent + engine->topBorder + engine->bottomBorder;
+}
+
+/* Returns the document laid out for PAINTER: a snapshot copy, or the live
+ * tree with PAINTER set on the engine, in which case the previous painter
+ * is returned in OLD_PAINTER. */
+static HTMLObject *
+print_layout_begin (HTMLEngine *engine,
+                    HTMLPainter *painter,
+                    HTMLPainter **old_painter)
+{
+	HTMLObject *clue;
+	gboolean live = FALSE;
+	guint len = 0;
+
+	if (engine->clue)
+		html_object_forall (engine->clue, engine, (HTMLObjectForallFunc) check_live_object, &live);
+	if (live || !engine->clue) {
+		*old_painter = g_object_ref (engine->painter);
+		html_engine_set_painter (engine, painter);
+
+		return engine->clue;
+	}
+
+	*old_painter = NULL;
+	clue = html_object_op_copy (engine->clue, NULL, engine, NULL, NULL, &len);
+	html_object_set_painter (clue, painter);
+	html_object_change_set_down (clue, HTML_CHANGE_ALL);
+	print_calc_size (engine, clue, painter);
+
+	return clue;
+}
+
+static void
+print_layout_end (HTMLEngine *engine,
+                  HTMLObject *clue,
+                  HTMLPainter *old_painter)
+{
+	if (old_painter) {
+		html_engine_set_painter (engine, old_painter);
+		g_object_unref (old_painter);
+	} else
+		html_object_destroy (clue);
+}
+
+/* Scales PAINTER down, to half size at most, when the document does
+ * not fit the page width. */
+static void
+print_fit_page_width (HTMLEngine *engine,
+                      HTMLObject *clue,
+                      HTMLPainter *painter)
+{
+	gint min_width, page_width;
+
+	min_width = print_calc_min_width (engine, clue, painter);
+	page_width = html_painter_get_page_width (painter, engine);
+	if (min_width > page_width) {
+		html_printer_set_scale (
+			HTML_PRINTER (painter),
+			MAX (0.5, ((gdouble) page_width) / min_width));
+		html_font_manager_clear_font_cache (
+			&painter->font_manager);
+		html_object_change_set_down (
+			clue, HTML_CHANGE_ALL);
+		print_calc_size (engine, clue, painter);
+	}
+}
+
+/* Returns where the page starting at SPLIT_OFFSET ends. */
+static gint
+print_next_split (HTMLEngine *engine,
+                  GArray *splits,
+                  gint split_offset,
+                  gint body_height)
+{
+	gint new_split_offset;
+
+	new_split_offset = html_object_check_page_split_index (
+		splits, split_offset + body_height);
+
+	if (new_split_offset <= split_offset ||
+	    new_split_offset - split_offset <
+	    engine->min_split_index * body_height)
+		new_split_offset = split_offset + body_height;
+
+	return new_split_offset;
+}
+
 static void
 print_header_footer (HTMLPainter *painter,
                      HTMLEngine *engine,
@@ -47,7 +199,7 @@ print_header_footer (HTMLPainter *painter,
 	GtkPrintContext *context = printer->context;
 	cairo_t *cr;
 
-	cr = gtk_print_context_get_cairo_context (context);
+	cr = html_printer_get_cairo_context (printer);
 
 	cairo_save (cr);
 	html_painter_set_clip_rectangle (
@@ -68,6 +220,7 @@ print_header_footer (HTMLPainter *painter,
 static void
 print_page (HTMLPainter *painter,
             HTMLEngine *engine,
+            HTMLObject *clue,
             gint start_y,
             gint page_width,
             gint page_height,
@@ -79,15 +232,9 @@ print_page (HTMLPainter *painter,
             gpointer user_data)
 {
 	HTMLPrinter *printer = HTML_PRINTER (painter);
-	GtkPrintContext *context = printer->context;
 	cairo_t *cr;
 
-	cr = gtk_print_context_get_cairo_context (context);
-
-	/* Show the previous page before we start drawing a new one.
-	 * GtkPrint will show the last page automatically for us. */
-	if (start_y > 0)
-		cairo_show_page (cr);
+	cr = html_printer_get_cairo_context (printer);
 
 	html_painter_begin (painter, 0, 0, page_width, page_height);
 
@@ -104,7 +251,7 @@ print_page (HTMLPainter *painter,
 		painter, 0, header_height, page_width, body_height);
 #endif
 	html_object_draw (
-		engine->clue, painter, 0, start_y, page_width,
+		clue, painter, 0, start_y, page_width,
 		body_height, 0, -start_y + header_height);
 	cairo_restore (cr);
 
@@ -120,6 +267,7 @@ print_page (HTMLPainter *painter,
 static gint
 print_all_pages (HTMLPainter *painter,
                  HTMLEngine *engine,
+                 HTMLObject *clue,
                  gdouble header_height,
                  gdouble footer_height,
                  GtkHTMLPrintCallback header_print,
@@ -134,6 +282,7 @@ print_all_pages (HTMLPainter *painter,
 	gint page_width;
 	gint page_height;
 	gint body_height;
+	GArray *splits;
 
 	page_height = html_printer_get_page_height (printer);
 	page_width = html_printer_get_page_width (printer);
@@ -148,29 +297,33 @@ print_all_pages (HTMLPainter *painter,
 		SCALE_GNOME_PRINT_TO_ENGINE (header_height + footer_height);
 	split_offset = 0;
 
-	document_height = html_engine_get_doc_height (engine);
+	document_height = print_get_doc_height (engine, clue);
+	splits = html_object_get_page_split_index (clue, painter);
 
 	do {
 		pages++;
-		new_split_offset = html_object_check_page_split (
-			engine->clue, painter, split_offset + body_height);
+		new_split_offset = print_next_split (
+			engine, splits, split_offset, body_height);
 
-		if (new_split_offset <= split_offset ||
-		    new_split_offset - split_offset <
-		    engine->min_split_index * body_height)
-			new_split_offset = split_offset + body_height;
+		if (do_print) {
+			/* Show the previous page before we start drawing a new one.
+			 * GtkPrint will show the last page automatically for us. */
+			if (split_offset > 0)
+				cairo_show_page (html_printer_get_cairo_context (printer));
 
-		if (do_print)
 			print_page (
-				painter, engine, split_offset, page_width,
+				painter, engine, clue, split_offset, page_width,
 				page_height, new_split_offset - split_offset,
 				header_height, footer_height, header_print,
 				footer_print, user_data);
+		}
 
 		split_offset = new_split_offset;
 
 	} while (split_offset < document_height);
 
+	g_array_free (splits, TRUE);
+
 	return pages;
 }
 
@@ -199,33 +352,17 @@ print_with_header_footer (HTMLEngine *engine,
 
 	if (default_font != NULL) {
 		HTMLPainter *old_painter;
-		gint min_width, page_width;
-
-		old_painter = g_object_ref (engine->painter);
-
-		html_engine_set_painter (engine, printer);
-
-		min_width = html_engine_calc_min_width (engine);
-		page_width = html_painter_get_page_width (
-			engine->painter, engine);
-		if (min_width > page_width) {
-			html_printer_set_scale (
-				HTML_PRINTER (printer),
-				MAX (0.5, ((gdouble) page_width) / min_width));
-			html_font_manager_clear_font_cache (
-				&printer->font_manager);
-			html_object_change_set_down (
-				engine->clue, HTML_CHANGE_ALL);
-			html_engine_calc_size (engine, NULL);
-		}
+		HTMLObject *clue;
+
+		clue = print_layout_begin (engine, printer, &old_painter);
+		print_fit_page_width (engine, clue, printer);
 
 		pages = print_all_pages (
-			HTML_PAINTER (printer), engine, header_height,
+			HTML_PAINTER (printer), engine, clue, header_height,
 			footer_height, header_print, footer_print,
 			user_data, do_print);
 
-		html_engine_set_painter (engine, old_painter);
-		g_object_unref (old_painter);
+		print_layout_end (engine, clue, old_painter);
 	} else {
 		/* TODO2 dialog instead of warning */
 		g_warning (_("Cannot allocate default font for printing"));
@@ -261,6 +398,343 @@ html_engine_print_get_pages_num (HTMLEngine *engine,
 		NULL, NULL, NULL, FALSE);
 }
 
+HTMLPrintJob *
+html_engine_print_job_new (HTMLEngine *engine,
+                           cairo_t *cr,
+                           gdouble page_width,
+                           gdouble page_height)
+{
+	HTMLPrintJob *job;
+	HTMLPainter *printer;
+
+	g_return_val_if_fail (HTML_IS_ENGINE (engine), NULL);
+	g_return_val_if_fail (engine->clue != NULL, NULL);
+	g_return_val_if_fail (cr != NULL, NULL);
+
+	printer = html_printer_new_for_cairo (
+		GTK_WIDGET (engine->widget), cr, page_width, page_height);
+	gtk_html_set_fonts (engine->widget, printer);
+
+	if (html_painter_get_font (printer, NULL, GTK_HTML_FONT_STYLE_DEFAULT) == NULL) {
+		g_warning (_("Cannot allocate default font for printing"));
+		g_object_unref (printer);
+		return NULL;
+	}
+
+	/* the pages may be drawn on another thread, which must not render
+	 * the placeholder icon of missing images itself */
+	html_image_factory_get_missing (engine->image_factory);
+
+	job = g_new0 (HTMLPrintJob, 1);
+	job->engine = engine;
+	job->painter = printer;
+	job->clue = print_layout_begin (engine, printer, &job->old_painter);
+	job->live = job->clue == engine->clue;
+	print_fit_page_width (engine, job->clue, printer);
+
+	return job;
+}
+
+gint
+html_print_job_run (HTMLPrintJob *job)
+{
+	gint pages;
+
+	g_return_val_if_fail (job != NULL, 0);
+
+	pages = print_all_pages (
+		job->painter, job->engine, job->clue,
+		0, 0, NULL, NULL, NULL, TRUE);
+
+	/* there is no GtkPrint to show the last page */
+	cairo_show_page (html_printer_get_cairo_context (HTML_PRINTER (job->painter)));
+
+	return pages;
+}
+
+void
+html_print_job_free (HTMLPrintJob *job)
+{
+	g_return_if_fail (job != NULL);
+
+	print_layout_end (job->engine, job->clue, job->old_painter);
+	g_object_unref (job->painter);
+	g_free (job);
+}
+
+/* Page images for print preview.  Drawing the object tree is not thread
+ * safe, text slaves build their glyph caches while they are drawn, so every
+ * page is recorded into a cairo recording surface on the engine's thread,
+ * one page per main loop iteration, and only turned into an image by a
+ * worker thread.  Images are handed out in page order as soon as they are
+ * ready, so the first page shows up before the rest is even recorded. */
+
+typedef struct {
+	gint page_nr;
+	cairo_surface_t *surface;
+} PreviewPage;
+
+struct _HTMLPrintPreview {
+	HTMLPrintJob *job;
+	cairo_t *idle_cr;
+	GArray *splits;
+	gint split_offset;
+	gint document_height;
+
+	gdouble page_width;
+	gdouble page_height;
+	gdouble scale;
+
+	GThreadPool *pool;
+	GAsyncQueue *done;
+	volatile gint cancelled;
+
+	/* images by page number until they are handed out */
+	GPtrArray *images;
+	guint n_delivered;
+	gboolean recorded;
+	gboolean finished;
+	gboolean delivering;
+	gboolean free_pending;
+	guint record_id;
+
+	HTMLPrintPageImageFunc func;
+	gpointer user_data;
+};
+
+static gboolean
+preview_deliver (HTMLPrintPreview *preview)
+{
+	PreviewPage *page;
+
+	while ((page = g_async_queue_try_pop (preview->done)) != NULL) {
+		g_ptr_array_index (preview->images, page->page_nr) = page->surface;
+		g_free (page);
+	}
+
+	preview->delivering = TRUE;
+	while (!preview->free_pending
+	       && preview->n_delivered < preview->images->len
+	       && g_ptr_array_index (preview->images, preview->n_delivered) != NULL) {
+		cairo_surface_t *image = g_ptr_array_index (preview->images, preview->n_delivered);
+
+		g_ptr_array_index (preview->images, preview->n_delivered) = NULL;
+		(*preview->func) (preview->n_delivered++, image, preview->user_data);
+		cairo_surface_destroy (image);
+	}
+	preview->delivering = FALSE;
+
+	if (preview->free_pending) {
+		html_print_preview_free (preview);
+		return FALSE;
+	}
+
+	if (preview->recorded && !preview->finished
+	    && preview->n_delivered == preview->images->len) {
+		preview->finished = TRUE;
+		/* may free the preview */
+		(*preview->func) (preview->n_delivered, NULL, preview->user_data);
+	}
+
+	return FALSE;
+}
+
+static void
+preview_rasterize_page (PreviewPage *page,
+                        HTMLPrintPreview *preview)
+{
+	cairo_surface_t *image;
+	cairo_t *cr;
+
+	if (g_atomic_int_get (&preview->cancelled)) {
+		g_async_queue_push (preview->done, page);
+		return;
+	}
+
+	image = cairo_image_surface_create (
+		CAIRO_FORMAT_RGB24,
+		ceil (preview->page_width * preview->scale),
+		ceil (preview->page_height * preview->scale));
+	cr = cairo_create (image);
+	cairo_set_source_rgb (cr, 1.0, 1.0, 1.0);
+	cairo_paint (cr);
+	cairo_scale (cr, preview->scale, preview->scale);
+	cairo_set_source_surface (cr, page->surface, 0, 0);
+	cairo_paint (cr);
+	cairo_destroy (cr);
+
+	cairo_surface_destroy (page->surface);
+	page->surface = image;
+
+	g_async_queue_push (preview->done, page);
+	g_idle_add ((GSourceFunc) preview_deliver, preview);
+}
+
+/* Records the next page, returns FALSE after the last one. */
+static gboolean
+preview_record_page (HTMLPrintPreview *preview)
+{
+	HTMLPrintJob *job = preview->job;
+	HTMLPrinter *printer = HTML_PRINTER (job->painter);
+	cairo_rectangle_t extents;
+	PreviewPage *page;
+	gint page_width, page_height, new_split_offset;
+	cairo_t *cr;
+
+	page_width = html_printer_get_page_width (printer);
+	page_height = html_printer_get_page_height (printer);
+	new_split_offset = print_next_split (
+		job->engine, preview->splits, preview->split_offset, page_height);
+
+	extents.x = extents.y = 0;
+	extents.width = preview->page_width;
+	extents.height = preview->page_height;
+
+	page = g_new0 (PreviewPage, 1);
+	page->page_nr = preview->images->len;
+	page->surface = cairo_recording_surface_create (CAIRO_CONTENT_COLOR_ALPHA, &extents);
+	cr = cairo_create (page->surface);
+	html_printer_set_cairo_context (printer, cr);
+	print_page (
+		job->painter, job->engine, job->clue, preview->split_offset,
+		page_width, page_height, new_split_offset - preview->split_offset,
+		0, 0, NULL, NULL, NULL);
+	/* the page belongs to a worker thread from now on */
+	html_printer_set_cairo_context (printer, preview->idle_cr);
+	cairo_destroy (cr);
+
+	g_ptr_array_add (preview->images, NULL);
+	g_thread_pool_push (preview->pool, page, NULL);
+
+	preview->split_offset = new_split_offset;
+	if (preview->split_offset < preview->document_height)
+		return TRUE;
+
+	/* the pages are recorded, the layout is no longer needed */
+	g_array_free (preview->splits, TRUE);
+	preview->splits = NULL;
+	html_print_job_free (preview->job);
+	preview->job = NULL;
+	preview->recorded = TRUE;
+
+	return FALSE;
+}
+
+static gboolean
+preview_record_idle (HTMLPrintPreview *preview)
+{
+	if (preview_record_page (preview))
+		return TRUE;
+
+	preview->record_id = 0;
+
+	return FALSE;
+}
+
+/* Starts making SCALE pixels per point images of the pages of ENGINE,
+ * PAGE_WIDTH x PAGE_HEIGHT points each.  FUNC gets them in page order
+ * from the main loop, and a NULL image after the last page.  Returns NULL
+ * for an empty document. */
+HTMLPrintPreview *
+html_engine_print_preview_new (HTMLEngine *engine,
+                               gdouble page_width,
+                               gdouble page_height,
+                               gdouble scale,
+                               HTMLPrintPageImageFunc func,
+                               gpointer user_data)
+{
+	HTMLPrintPreview *preview;
+	HTMLPrintJob *job;
+	cairo_surface_t *surface;
+	cairo_t *cr;
+
+	g_return_val_if_fail (HTML_IS_ENGINE (engine), NULL);
+	g_return_val_if_fail (func != NULL, NULL);
+
+	if (engine->clue == NULL)
+		return NULL;
+
+	/* the printer draws here between pages, pages get their own context */
+	surface = cairo_recording_surface_create (CAIRO_CONTENT_COLOR_ALPHA, NULL);
+	cr = cairo_create (surface);
+	cairo_surface_destroy (surface);
+	job = html_engine_print_job_new (engine, cr, page_width, page_height);
+
+	if (job == NULL) {
+		cairo_destroy (cr);
+		return NULL;
+	}
+
+	preview = g_new0 (HTMLPrintPreview, 1);
+	preview->job = job;
+	preview->idle_cr = cr;
+	preview->splits = html_object_get_page_split_index (job->clue, job->painter);
+	preview->document_height = print_get_doc_height (engine, job->clue);
+	preview->page_width = page_width;
+	preview->page_height = page_height;
+	preview->scale = scale;
+	preview->func = func;
+	preview->user_data = user_data;
+	preview->done = g_async_queue_new ();
+	preview->images = g_ptr_array_new ();
+	preview->pool = g_thread_pool_new (
+		(GFunc) preview_rasterize_page, preview,
+		g_get_num_processors (), FALSE, NULL);
+
+	if (job->live) {
+		/* the engine draws with the printer until the job is freed */
+		while (preview_record_page (preview))
+			;
+	} else if (preview_record_page (preview))
+		preview->record_id = g_idle_add ((GSourceFunc) preview_record_idle, preview);
+
+	return preview;
+}
+
+/* Stops making page images.  Images not handed out yet are dropped. */
+void
+html_print_preview_free (HTMLPrintPreview *preview)
+{
+	PreviewPage *page;
+	guint i;
+
+	g_return_if_fail (preview != NULL);
+
+	g_atomic_int_set (&preview->cancelled, TRUE);
+	if (preview->delivering) {
+		/* called from FUNC, preview_deliver () frees it */
+		preview->free_pending = TRUE;
+		return;
+	}
+
+	if (preview->record_id != 0)
+		g_source_remove (preview->record_id);
+
+	/* waits for the pages being drawn, the rest are dropped */
+	g_thread_pool_free (preview->pool, FALSE, TRUE);
+	while (g_source_remove_by_user_data (preview))
+		;
+
+	while ((page = g_async_queue_try_pop (preview->done)) != NULL) {
+		cairo_surface_destroy (page->surface);
+		g_free (page);
+	}
+	g_async_queue_unref (preview->done);
+
+	for (i = 0; i < preview->images->len; i++)
+		if (g_ptr_array_index (preview->images, i) != NULL)
+			cairo_surface_destroy (g_ptr_array_index (preview->images, i));
+	g_ptr_array_free (preview->images, TRUE);
+
+	if (preview->job != NULL) {
+		g_array_free (preview->splits, TRUE);
+		html_print_job_free (preview->job);
+	}
+	cairo_destroy (preview->idle_cr);
+
+	g_free (preview);
+}
+
 void
 html_engine_print_set_min_split_index (HTMLEngine *engine,
                                        gdouble index)
@@ -270,6 +744,7 @@ html_engine_print_set_min_split_index (HTMLEngine *engine,
 
 typedef struct {
 	HTMLEngine *engine;
+	HTMLObject *clue;
 	HTMLPainter *painter;
 	HTMLPainter *old_painter;
 	GtkHTMLPrintCalcHeight calc_header_height;
@@ -289,13 +764,12 @@ engine_print_begin_print (GtkPrintOperation *operation,
 {
 	HTMLPrinter *printer;
 	HTMLFont *default_font;
-	gint min_width;
-	gint page_width;
 	gint page_height;
 	gint body_height;
 	gint document_height;
 	gint new_split_offset;
 	gint split_offset;
+	GArray *splits;
 
 	data->painter = html_printer_new (
 		GTK_WIDGET (data->engine->widget), context);
@@ -309,24 +783,11 @@ engine_print_begin_print (GtkPrintOperation *operation,
 	if (default_font == NULL)
 		g_warning (_("Cannot allocate default font for printing"));
 
-	data->old_painter = g_object_ref (data->engine->painter);
-	html_engine_set_painter (data->engine, data->painter);
+	data->clue = print_layout_begin (
+		data->engine, data->painter, &data->old_painter);
 
 	printer = HTML_PRINTER (data->painter);
-
-	min_width = html_engine_calc_min_width (data->engine);
-	page_width = html_painter_get_page_width (
-		data->engine->painter, data->engine);
-	if (min_width > page_width) {
-		html_printer_set_scale (
-			printer, MAX (0.5,
-			((gdouble) page_width) / min_width));
-		html_font_manager_clear_font_cache (
-			&data->painter->font_manager);
-		html_object_change_set_down (
-			data->engine->clue, HTML_CHANGE_ALL);
-		html_engine_calc_size (data->engine, NULL);
-	}
+	print_fit_page_width (data->engine, data->clue, data->painter);
 
 	page_height = html_printer_get_page_height (printer);
 
@@ -354,26 +815,21 @@ engine_print_begin_print (GtkPrintOperation *operation,
 
 	body_height =
 		page_height - (data->header_height + data->footer_height);
-	document_height = html_engine_get_doc_height (data->engine);
+	document_height = print_get_doc_height (data->engine, data->clue);
 
 	split_offset = 0;
 	g_array_append_val (data->offsets, split_offset);
+	splits = html_object_get_page_split_index (data->clue, data->painter);
 
 	do {
-		new_split_offset = html_object_check_page_split (
-			data->engine->clue, data->painter,
-			split_offset + body_height);
-
-		if (new_split_offset <= split_offset ||
-		    new_split_offset - split_offset <
-		    data->engine->min_split_index * body_height)
-			new_split_offset = split_offset + body_height;
-
+		new_split_offset = print_next_split (
+			data->engine, splits, split_offset, body_height);
 		split_offset = new_split_offset;
 		g_array_append_val (data->offsets, split_offset);
 
 	} while (split_offset < document_height);
 
+	g_array_free (splits, TRUE);
 	gtk_print_operation_set_n_pages (operation, data->offsets->len - 1);
 }
 
@@ -436,7 +892,7 @@ engine_print_draw_page (GtkPrintOperation *operation,
 		painter, rec.x, rec.y, rec.width, rec.height);
 #endif
 	html_object_draw (
-		data->engine->clue, painter, 0, offset[0], page_width,
+		data->clue, painter, 0, offset[0], page_width,
 		body_height, 0, -offset[0] + data->header_height);
 	cairo_restore (cr);
 
@@ -467,10 +923,9 @@ engine_print_end_print (GtkPrintOperation *operation,
                         GtkPrintContext *context,
                         EnginePrintData *data)
 {
-	html_engine_set_painter (data->engine, data->old_painter);
+	print_layout_end (data->engine, data->clue, data->old_painter);
 
 	g_object_unref (data->painter);
-	g_object_unref (data->old_painter);
 	g_array_free (data->offsets, TRUE);
 }
 
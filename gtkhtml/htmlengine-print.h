@@ -39,6 +39,44 @@ gint	html_engine_print_get_pages_num	(HTMLEngine *engine,
 void	html_engine_print_set_min_split_index	(HTMLEngine *engine,
 						 gdouble index);
 
+/* Printing straight to a cairo context, without a GtkPrintOperation.
+ * html_engine_print_job_new () lays the document out and
+ * html_print_job_free () puts the engine back, both on the thread owning
+ * the engine.  Unless the job is live, that is it has to draw through the
+ * engine's own tree because of embedded widgets or frames,
+ * html_print_job_run () only touches the job, so jobs of different
+ * engines can be drawn concurrently from other threads. */
+typedef struct _HTMLPrintJob HTMLPrintJob;
+
+struct _HTMLPrintJob {
+	HTMLEngine *engine;
+	HTMLPainter *painter;
+	HTMLPainter *old_painter;
+	HTMLObject *clue;
+	gboolean live;
+};
+
+HTMLPrintJob	*html_engine_print_job_new	(HTMLEngine *engine,
+						 cairo_t *cr,
+						 gdouble page_width,
+						 gdouble page_height);
+gint		 html_print_job_run		(HTMLPrintJob *job);
+void		 html_print_job_free		(HTMLPrintJob *job);
+
+/* Page images for print preview, drawn on worker threads.  IMAGE is NULL
+ * after the last page. */
+typedef void (* HTMLPrintPageImageFunc) (gint page_nr,
+					 cairo_surface_t *image,
+					 gpointer user_data);
+
+HTMLPrintPreview *html_engine_print_preview_new	(HTMLEngine *engine,
+						 gdouble page_width,
+						 gdouble page_height,
+						 gdouble scale,
+						 HTMLPrintPageImageFunc func,
+						 gpointer user_data);
+void		 html_print_preview_free	(HTMLPrintPreview *preview);
+
 GtkPrintOperationResult
 html_engine_print_operation_run	   (HTMLEngine *engine,
 				    GtkPrintOperation *operation,
@@ -25,15 +25,21 @@
  *  <Daniel.Veillard@w3.org>.
 */
 
+#include <errno.h>
 #include <string.h>
+#include <unistd.h>
+
+#include <pango/pangocairo.h>
 
 #include "config.h"
+#include "htmlclueflow.h"
 #include "htmlcluev.h"
 #include "htmlcolor.h"
 #include "htmlengine.h"
 #include "htmlimage.h"
 #include "htmlentity.h"
 #include "htmlengine-save.h"
+#include "htmlpainter.h"
 #include "htmlsettings.h"
 
 #include "gtkhtmldebug.h"
@@ -46,93 +52,133 @@
 #define HTML_ENTITIES_MAX_LENGTH	14
 
 
-/* This routine was originally written by Daniel Velliard, (C) 1998 World Wide
- * Web Consortium.  */
-gchar *
-html_encode_entities (const gchar *input,
-                      guint len,
-                      guint *encoded_len_return)
+/* Replacements of the ASCII characters which have to be encoded, the
+ * control characters other than tab and new lines are written as numeric
+ * entities. */
+static const gchar *ascii_entities[128] = {
+	['"'] = "&quot;",
+	['&'] = "&amp;",
+	['<'] = "&lt;",
+	['>'] = "&gt;",
+};
+
+#define IS_PLAIN_ASCII(c) ((c) < 0x80 && !ascii_entities[(c)] \
+			   && ((c) >= 0x20 || (c) == '\n' || (c) == '\r' || (c) == '\t'))
+
+static void
+append_numeric_entity (GString *out,
+                       gunichar uc)
 {
-	gunichar uc;
-	const gchar *p;
-	guchar *buffer = NULL;
-	guchar *out = NULL;
-	gint buffer_size = 0;
-	guint count;
+	gchar buf[HTML_ENTITIES_MAX_LENGTH], *ptr;
+
+	ptr = buf + HTML_ENTITIES_MAX_LENGTH;
+	*--ptr = ';';
+	do {
+		*--ptr = '0' + uc % 10;
+		uc /= 10;
+	} while (uc);
+	*--ptr = '#';
+	*--ptr = '&';
+
+	g_string_append_len (out, ptr, buf + HTML_ENTITIES_MAX_LENGTH - ptr);
+}
 
-	/* Allocate an translation buffer.  */
-	buffer_size = 1000;
-	buffer      = g_malloc (buffer_size);
+/* Appends at most len characters of input to out, entity encoded. Runs of
+ * characters which need no encoding are copied at once. */
+static void
+encode_entities_append (GString *out,
+                        const gchar *input,
+                        guint len)
+{
+	const gchar *p, *run;
+	guint count;
 
-	out   = buffer;
 	p     = input;
+	run   = input;
 	count = 0;
 
 	while (p && *p && count < len) {
-		if (out - buffer > buffer_size - 100) {
-			gint index = out - buffer;
+		guchar c = *p;
+		gunichar uc;
 
-			buffer_size *= 2;
-			buffer = g_realloc (buffer, buffer_size);
-			out = &buffer[index];
+		if (IS_PLAIN_ASCII (c)) {
+			p++;
+			count++;
+			continue;
 		}
-		uc = g_utf8_get_char (p);
-
-		/* By default one have to encode at least '<', '>', '"' and '&'.  */
-
-		if (uc == '<') {
-			*out++ = '&';
-			*out++ = 'l';
-			*out++ = 't';
-			*out++ = ';';
-		} else if (uc == '>') {
-			*out++ = '&';
-			*out++ = 'g';
-			*out++ = 't';
-			*out++ = ';';
-		} else if (uc == '&') {
-			*out++ = '&';
-			*out++ = 'a';
-			*out++ = 'm';
-			*out++ = 'p';
-			*out++ = ';';
-		} else if (uc == '"') {
-			*out++ = '&';
-			*out++ = 'q';
-			*out++ = 'u';
-			*out++ = 'o';
-			*out++ = 't';
-			*out++ = ';';
-		} else if (uc == ENTITY_NBSP) {
-			*out++ = '&';
-			*out++ = 'n';
-			*out++ = 'b';
-			*out++ = 's';
-			*out++ = 'p';
-			*out++ = ';';
-		} else if (((uc >= 0x20) && (uc < 0x80))
-			   || (uc == '\n') || (uc == '\r') || (uc == '\t')) {
-			/* Default case, just copy. */
-			*out++ = uc;
-		} else {
-			gchar buf[HTML_ENTITIES_MAX_LENGTH], *ptr;
 
-			g_snprintf (buf, HTML_ENTITIES_MAX_LENGTH, "&#%d;", uc);
+		if (p > run)
+			g_string_append_len (out, run, p - run);
 
-			ptr = buf;
-			while (*ptr != 0)
-				*out++ = *ptr++;
+		if (c < 0x80) {
+			if (ascii_entities[c])
+				g_string_append (out, ascii_entities[c]);
+			else
+				append_numeric_entity (out, c);
+			p++;
+		} else {
+			uc = g_utf8_get_char (p);
+			if (uc == ENTITY_NBSP)
+				g_string_append_len (out, "&nbsp;", 6);
+			else
+				append_numeric_entity (out, uc);
+			p = g_utf8_next_char (p);
 		}
 
+		run = p;
 		count++;
-		p = g_utf8_next_char (p);
 	}
 
-	*out = 0;
+	if (p > run)
+		g_string_append_len (out, run, p - run);
+}
+
+gchar *
+html_encode_entities (const gchar *input,
+                      guint len,
+                      guint *encoded_len_return)
+{
+	GString *out;
+
+	out = g_string_sized_new (MAX (len, 1000));
+	encode_entities_append (out, input, len);
+
 	if (encoded_len_return)
-		*encoded_len_return = out - buffer;
+		*encoded_len_return = out->len;
+
+	return g_string_free (out, FALSE);
+}
+
+static gboolean
+save_flush (HTMLEngineSaveState *state)
+{
+	gboolean success;
+
+	if (!state->block || !state->block->len)
+		return !state->error;
+
+	/* the output is broken, don't try to write any more blocks */
+	if (state->error) {
+		g_string_truncate (state->block, 0);
+		return FALSE;
+	}
+
+	success = state->receiver (state->engine, state->block->str, state->block->len, state->user_data);
+	g_string_truncate (state->block, 0);
+
+	if (!success)
+		state->error = TRUE;
+
+	return success;
+}
 
-	return (gchar *) buffer;
+static inline gboolean
+save_block_written (HTMLEngineSaveState *state)
+{
+	if (state->block->len >= state->block_size)
+		return save_flush (state);
+
+	return !state->error;
 }
 
 gboolean
@@ -140,8 +186,7 @@ html_engine_save_encode (HTMLEngineSaveState *state,
                          const gchar *buffer,
                          guint length)
 {
-	gchar *encoded_buffer;
-	guint encoded_length;
+	GString *encoded;
 	gboolean success;
 
 	g_return_val_if_fail (state != NULL, FALSE);
@@ -150,10 +195,16 @@ html_engine_save_encode (HTMLEngineSaveState *state,
 	if (length == 0)
 		return TRUE;
 
-	encoded_buffer = html_encode_entities (buffer, length, &encoded_length);
-	success = state->receiver (state->engine, encoded_buffer, encoded_length, state->user_data);
+	if (state->block) {
+		encode_entities_append (state->block, buffer, length);
+		return save_block_written (state);
+	}
+
+	encoded = g_string_sized_new (length + 16);
+	encode_entities_append (encoded, buffer, length);
+	success = state->receiver (state->engine, encoded->str, encoded->len, state->user_data);
+	g_string_free (encoded, TRUE);
 
-	g_free (encoded_buffer);
 	return success;
 }
 
@@ -179,6 +230,11 @@ html_engine_save_output_stringv (HTMLEngineSaveState *state,
 	gchar *string;
 	gboolean retval;
 
+	if (state->block) {
+		g_string_append_vprintf (state->block, format, ap);
+		return save_block_written (state);
+	}
+
 	string = g_strdup_vprintf (format, ap);
 	retval = state->receiver (state->engine, string, strlen (string), state->user_data);
 	g_free (string);
@@ -211,6 +267,24 @@ html_engine_save_output_buffer (HTMLEngineSaveState *state,
 {
 	if (bytes == -1)
 		bytes = strlen (buffer);
+
+	if (state->block) {
+		/* large pieces don't need to be copied into the block */
+		if ((gsize) bytes >= state->block_size) {
+			if (!save_flush (state))
+				return FALSE;
+			if (!state->receiver (state->engine, buffer, bytes, state->user_data)) {
+				state->error = TRUE;
+				return FALSE;
+			}
+
+			return TRUE;
+		}
+
+		g_string_append_len (state->block, buffer, bytes);
+		return save_block_written (state);
+	}
+
 	return state->receiver (state->engine, buffer, bytes, state->user_data);
 }
 
@@ -345,12 +419,14 @@ write_end (HTMLEngineSaveState *state)
 	return TRUE;
 }
 
-gboolean
-html_engine_save (HTMLEngine *engine,
-                  HTMLEngineSaveReceiverFn receiver,
-                  gpointer user_data)
+static gboolean
+save_html (HTMLEngine *engine,
+           HTMLEngineSaveReceiverFn receiver,
+           gpointer user_data,
+           gsize block_size)
 {
 	HTMLEngineSaveState state;
+	gboolean retval = FALSE;
 
 	if (engine->clue == NULL) {
 		/* Empty document.  */
@@ -366,20 +442,115 @@ html_engine_save (HTMLEngine *engine,
 	state.inline_frames = FALSE;
 	state.user_data = user_data;
 	state.last_level = 0;
+	state.block = block_size ? g_string_sized_new (block_size + HTML_ENTITIES_MAX_LENGTH) : NULL;
+	state.block_size = block_size;
+	state.pango_context = NULL;
+	state.padding = 0;
+
+	if (write_header (&state)) {
+		html_object_save (engine->clue, &state);
+		if (!state.error && write_end (&state))
+			retval = save_flush (&state);
+	}
 
-	if (!write_header (&state))
-		return FALSE;
+	if (state.block)
+		g_string_free (state.block, TRUE);
 
-	html_object_save (engine->clue, &state);
-	if (state.error)
-		return FALSE;
+	return retval;
+}
 
-	if (!write_end (&state))
-		return FALSE;
+gboolean
+html_engine_save (HTMLEngine *engine,
+                  HTMLEngineSaveReceiverFn receiver,
+                  gpointer user_data)
+{
+	return save_html (engine, receiver, user_data, 0);
+}
+
+/* Same as html_engine_save, but the output is passed to receiver in blocks
+ * of block_size bytes (HTML_ENGINE_SAVE_BLOCK_SIZE when 0) instead of piece
+ * by piece. */
+gboolean
+html_engine_save_buffered (HTMLEngine *engine,
+                           HTMLEngineSaveReceiverFn receiver,
+                           gpointer user_data,
+                           gsize block_size)
+{
+	g_return_val_if_fail (receiver != NULL, FALSE);
+
+	return save_html (engine, receiver, user_data, block_size ? block_size : HTML_ENGINE_SAVE_BLOCK_SIZE);
+}
+
+static gboolean
+save_fd_receiver (const HTMLEngine *engine,
+                  const gchar *data,
+                  gsize len,
+                  gpointer user_data)
+{
+	gint fd = GPOINTER_TO_INT (user_data);
+
+	while (len > 0) {
+		gssize written = write (fd, data, len);
+
+		if (written < 0) {
+			if (errno == EINTR)
+				continue;
+			g_warning ("write error: %s", g_strerror (errno));
+			return FALSE;
+		}
+
+		data += written;
+		len  -= written;
+	}
 
 	return TRUE;
 }
 
+gboolean
+html_engine_save_to_fd (HTMLEngine *engine,
+                        gint fd,
+                        gsize block_size)
+{
+	g_return_val_if_fail (fd >= 0, FALSE);
+
+	return html_engine_save_buffered (engine, save_fd_receiver, GINT_TO_POINTER (fd), block_size);
+}
+
+typedef struct {
+	GOutputStream *stream;
+	GCancellable *cancellable;
+	GError **error;
+} SaveStreamData;
+
+static gboolean
+save_stream_receiver (const HTMLEngine *engine,
+                      const gchar *data,
+                      gsize len,
+                      gpointer user_data)
+{
+	SaveStreamData *sd = user_data;
+
+	return g_output_stream_write_all (sd->stream, data, len, NULL, sd->cancellable, sd->error);
+}
+
+gboolean
+html_engine_save_to_stream (HTMLEngine *engine,
+                            GOutputStream *stream,
+                            gsize block_size,
+                            GCancellable *cancellable,
+                            GError **error)
+{
+	SaveStreamData sd;
+
+	g_return_val_if_fail (G_IS_OUTPUT_STREAM (stream), FALSE);
+
+	sd.stream = stream;
+	sd.cancellable = cancellable;
+	sd.error = error;
+
+	return html_engine_save_buffered (engine, save_stream_receiver, &sd, block_size);
+}
+
 gboolean
 html_engine_save_plain (HTMLEngine *engine,
                         HTMLEngineSaveReceiverFn receiver,
@@ -401,6 +572,10 @@ html_engine_save_plain (HTMLEngine *engine,
 	state.inline_frames = FALSE;
 	state.user_data = user_data;
 	state.last_level = 0;
+	state.block = NULL;
+	state.block_size = 0;
+	state.pango_context = NULL;
+	state.padding = 0;
 
 	/* FIXME don't hardcode the length */
 	html_object_save_plain (engine->clue, &state, 72);
@@ -416,7 +591,7 @@ html_engine_save_buffer_receiver (const HTMLEngine *engine,
                                   gsize len,
                                   gpointer user_data)
 {
-	g_string_append ((GString *) user_data, (gchar *) data);
+	g_string_append_len ((GString *) user_data, data, len);
 
 	return TRUE;
 }
@@ -481,6 +656,141 @@ html_engine_save_buffer_new (HTMLEngine *engine,
 	return state;
 }
 
+/* Parallel plain text export: the paragraphs of the top level clue are
+ * split into chunks, each chunk is saved into its own buffer on a thread
+ * pool and the buffers are passed to the receiver in document order. The
+ * tree must not change meanwhile, the calling thread waits for the pool. */
+
+typedef struct {
+	HTMLEngine *engine;
+	PangoFontDescription *font_desc;
+	PangoLanguage *language;
+	PangoDirection base_dir;
+	guint padding;
+} SavePlainJob;
+
+typedef struct {
+	HTMLObject *first;
+	guint n_objects;
+	gchar *text;
+	gint bytes;
+	gboolean success;
+} SavePlainChunk;
+
+static void
+save_plain_chunk (gpointer data,
+                  gpointer user_data)
+{
+	SavePlainChunk *chunk = data;
+	SavePlainJob *job = user_data;
+	HTMLEngineSaveState *state;
+	PangoContext *pc;
+	HTMLObject *o;
+	guint i;
+
+	/* pango contexts are not thread safe, use one from this thread's font map */
+	pc = pango_font_map_create_context (pango_cairo_font_map_get_default ());
+	pango_context_set_font_description (pc, job->font_desc);
+	pango_context_set_language (pc, job->language);
+	pango_context_set_base_dir (pc, job->base_dir);
+
+	state = html_engine_save_buffer_new (job->engine, FALSE);
+	state->pango_context = pc;
+	state->padding = job->padding;
+
+	chunk->success = TRUE;
+	for (o = chunk->first, i = 0; o && i < chunk->n_objects && chunk->success; o = o->next, i++)
+		chunk->success = html_object_save_plain (o, state, 72) && !state->error;
+
+	chunk->bytes = html_engine_save_buffer_peek_text_bytes (state);
+	chunk->text = html_engine_save_buffer_free (state, FALSE);
+
+	g_object_unref (pc);
+}
+
+static void
+check_frames (HTMLObject *o,
+              HTMLEngine *e,
+              gpointer data)
+{
+	if (HTML_OBJECT_TYPE (o) == HTML_TYPE_IFRAME
+	    || HTML_OBJECT_TYPE (o) == HTML_TYPE_FRAME
+	    || HTML_OBJECT_TYPE (o) == HTML_TYPE_FRAMESET)
+		*(gboolean *) data = TRUE;
+}
+
+/* Produces the same output as html_engine_save_plain. chunk_size is the
+ * number of top level paragraphs saved by one job, HTML_ENGINE_SAVE_PLAIN_CHUNK
+ * when 0. Documents with frames, which are saved through other engines, and
+ * documents with a single chunk are saved serially. */
+gboolean
+html_engine_save_plain_parallel (HTMLEngine *engine,
+                                 HTMLEngineSaveReceiverFn receiver,
+                                 gpointer user_data,
+                                 guint chunk_size)
+{
+	SavePlainJob job;
+	SavePlainChunk *chunks;
+	GThreadPool *pool;
+	PangoContext *pc;
+	HTMLObject *o;
+	gboolean has_frames = FALSE, success = TRUE;
+	guint n_objects = 0, n_chunks, i;
+
+	g_return_val_if_fail (receiver != NULL, FALSE);
+
+	if (engine->clue == NULL) {
+		/* Empty document.  */
+		return FALSE;
+	}
+
+	if (chunk_size == 0)
+		chunk_size = HTML_ENGINE_SAVE_PLAIN_CHUNK;
+
+	if (HTML_IS_CLUEV (engine->clue)) {
+		for (o = HTML_CLUE (engine->clue)->head; o; o = o->next)
+			n_objects++;
+		html_object_forall (engine->clue, NULL, check_frames, &has_frames);
+	}
+
+	n_chunks = (n_objects + chunk_size - 1) / chunk_size;
+	if (has_frames || n_chunks < 2)
+		return html_engine_save_plain (engine, receiver, user_data);
+
+	pc = engine->painter->pango_context;
+	job.engine = engine;
+	job.font_desc = pango_context_get_font_description (pc);
+	job.language = pango_context_get_language (pc);
+	job.base_dir = pango_context_get_base_dir (pc);
+	job.padding = html_clueflow_calc_padding (engine->painter);
+
+	chunks = g_new0 (SavePlainChunk, n_chunks);
+	pool = g_thread_pool_new (save_plain_chunk, &job, g_get_num_processors (), FALSE, NULL);
+
+	for (o = HTML_CLUE (engine->clue)->head, i = 0; i < n_chunks; i++) {
+		guint j;
+
+		chunks[i].first = o;
+		chunks[i].n_objects = chunk_size;
+		for (j = 0; o && j < chunk_size; j++)
+			o = o->next;
+
+		g_thread_pool_push (pool, &chunks[i], NULL);
+	}
+
+	/* waits for all the chunks */
+	g_thread_pool_free (pool, FALSE, TRUE);
+
+	for (i = 0; i < n_chunks; i++) {
+		success = success && chunks[i].success
+			&& (chunks[i].bytes == 0 || receiver (engine, chunks[i].text, chunks[i].bytes, user_data));
+		g_free (chunks[i].text);
+	}
+	g_free (chunks);
+
+	return success;
+}
+
 gchar *
 html_engine_save_get_sample_body (HTMLEngine *e,
                                   HTMLObject *o)
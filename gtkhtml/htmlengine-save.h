@@ -41,8 +41,24 @@ struct _HTMLEngineSaveState {
 	guint last_level;
 
 	gpointer user_data;
+
+	/* output collected here and passed to receiver in blocks of
+	 * block_size bytes, NULL when receiver gets every piece directly */
+	GString *block;
+	gsize block_size;
+
+	/* set by the parallel plain text export, which must not use the
+	 * engine painter, padding is html_clueflow_calc_padding () of it */
+	PangoContext *pango_context;
+	guint padding;
 };
 
+/* default block size of the buffered save functions */
+#define HTML_ENGINE_SAVE_BLOCK_SIZE 65536
+
+/* default number of paragraphs exported by one html_engine_save_plain_parallel job */
+#define HTML_ENGINE_SAVE_PLAIN_CHUNK 64
+
 
 /* Entity encoding.  This is used by the HTML objects to output stuff through
  * entity-based encoding.  */
@@ -81,6 +97,22 @@ gboolean             html_engine_save                           (HTMLEngine
 gboolean             html_engine_save_plain                     (HTMLEngine                *engine,
 								 HTMLEngineSaveReceiverFn   receiver,
 								 gpointer                   user_data);
+gboolean             html_engine_save_plain_parallel            (HTMLEngine                *engine,
+								 HTMLEngineSaveReceiverFn   receiver,
+								 gpointer                   user_data,
+								 guint                      chunk_size);
+gboolean             html_engine_save_buffered                  (HTMLEngine                *engine,
+								 HTMLEngineSaveReceiverFn   receiver,
+								 gpointer                   user_data,
+								 gsize                      block_size);
+gboolean             html_engine_save_to_fd                     (HTMLEngine                *engine,
+								 gint                       fd,
+								 gsize                      block_size);
+gboolean             html_engine_save_to_stream                 (HTMLEngine                *engine,
+								 GOutputStream             *stream,
+								 gsize                      block_size,
+								 GCancellable              *cancellable,
+								 GError                   **error);
 gchar                *html_engine_save_buffer_free               (HTMLEngineSaveState       *state,
 								 gboolean                   free_string);
 guchar              *html_engine_save_buffer_peek_text          (HTMLEngineSaveState       *state);
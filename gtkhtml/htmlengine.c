@@ -102,6 +102,10 @@
 static gboolean  html_engine_timer_event      (HTMLEngine          *e);
 static gboolean  html_engine_update_event     (HTMLEngine          *e);
 static void      html_engine_queue_redraw_all (HTMLEngine *e);
+static gboolean  redraw_idle                  (HTMLEngine *e);
+static gboolean  thaw_idle                    (gpointer data);
+static void      html_engine_schedule_frame   (HTMLEngine *e);
+static void      html_engine_cancel_frame     (HTMLEngine *e);
 static gchar **   html_engine_stream_types     (GtkHTMLStream       *stream,
 					       gpointer            data);
 static void      html_engine_stream_write     (GtkHTMLStream       *stream,
@@ -4225,24 +4229,15 @@ html_engine_finalize (GObject *object)
 		g_source_remove (engine->timerId);
 		engine->timerId = 0;
 	}
-	if (engine->updateTimer != 0) {
-		g_source_remove (engine->updateTimer);
-		engine->updateTimer = 0;
-	}
-	if (engine->thaw_idle_id != 0) {
-		g_source_remove (engine->thaw_idle_id);
-		engine->thaw_idle_id = 0;
-	}
+	engine->update_pending = FALSE;
+	engine->thaw_pending = FALSE;
+	engine->redraw_pending = FALSE;
+	html_engine_cancel_frame (engine);
 	if (engine->blinking_timer_id != 0) {
 		if (engine->blinking_timer_id != -1)
 			g_source_remove (engine->blinking_timer_id);
 		engine->blinking_timer_id = 0;
 	}
-	if (engine->redraw_idle_id != 0) {
-		g_source_remove (engine->redraw_idle_id);
-		engine->redraw_idle_id = 0;
-	}
-
 	/* remove all the timers associated with image pointers also */
 	if (engine->image_factory) {
 		html_image_factory_stop_animations (engine->image_factory);
@@ -4546,7 +4541,7 @@ html_engine_init (HTMLEngine *engine)
 
 	/* STUFF might be missing here!   */
 	engine->freeze_count = 0;
-	engine->thaw_idle_id = 0;
+	engine->thaw_pending = FALSE;
 	engine->pending_expose = NULL;
 
 	engine->window = NULL;
@@ -4604,7 +4599,11 @@ html_engine_init (HTMLEngine *engine)
 	engine->cursor_hide_count = 1;
 
 	engine->timerId = 0;
-	engine->updateTimer = 0;
+	engine->update_pending = FALSE;
+	engine->redraw_pending = FALSE;
+	engine->frame_id = 0;
+	engine->frame_tick = FALSE;
+	engine->frame_layout_time = 0;
 
 	engine->blinking_timer_id = 0;
 	engine->blinking_status = FALSE;
@@ -4622,6 +4621,8 @@ html_engine_init (HTMLEngine *engine)
 
 	engine->search_info = NULL;
 	engine->need_spell_check = FALSE;
+	engine->batch_level = 0;
+	engine->batch_spell_position = -1;
 
 	html_engine_print_set_min_split_index (engine, .75);
 
@@ -4672,9 +4673,9 @@ html_engine_unrealize (HTMLEngine *e)
 {
 	g_return_if_fail (HTML_IS_ENGINE (e));
 
-	if (e->thaw_idle_id != 0) {
-		g_source_remove (e->thaw_idle_id);
-		e->thaw_idle_id = 0;
+	if (e->thaw_pending) {
+		e->thaw_pending = FALSE;
+		html_engine_cancel_frame (e);
 	}
 
 	if (HTML_IS_GDK_PAINTER (e->painter))
@@ -4962,6 +4963,113 @@ update_embedded (GtkWidget *widget,
 	}
 }
 
+/* Frames.  A thaw, a relayout and a redraw requested meanwhile run
+ * together in the next frame, in this order, so that the document is laid
+ * out and repainted once.  When the widget is mapped the frame runs from
+ * the frame clock, before it paints; otherwise (and with GTK+ older than
+ * 3.8) from an idle.  */
+
+static void
+html_engine_run_frame (HTMLEngine *e)
+{
+	gint64 start = g_get_monotonic_time ();
+
+	e->frame_id = 0;
+
+	if (e->thaw_pending)
+		thaw_idle (e);
+	if (e->update_pending)
+		html_engine_update_event (e);
+
+	e->frame_layout_time += g_get_monotonic_time () - start;
+
+	if (e->redraw_pending)
+		redraw_idle (e);
+
+	/* drop a frame requested by the steps above, they are done already */
+	html_engine_cancel_frame (e);
+}
+
+static gboolean
+frame_idle (gpointer data)
+{
+	html_engine_run_frame (HTML_ENGINE (data));
+
+	return FALSE;
+}
+
+#if GTK_CHECK_VERSION (3, 8, 0)
+static gboolean
+frame_tick (GtkWidget *widget,
+            GdkFrameClock *frame_clock,
+            gpointer data)
+{
+	html_engine_run_frame (HTML_ENGINE (data));
+
+	return FALSE;
+}
+#endif
+
+static void
+html_engine_schedule_frame (HTMLEngine *e)
+{
+	if (e->frame_id)
+		return;
+
+#if GTK_CHECK_VERSION (3, 8, 0)
+	if (e->widget && gtk_widget_get_mapped (GTK_WIDGET (e->widget))) {
+		e->frame_tick = TRUE;
+		e->frame_id = gtk_widget_add_tick_callback (GTK_WIDGET (e->widget), frame_tick, e, NULL);
+		return;
+	}
+#endif
+
+	/* schedule with priority higher than gtk+ uses for animations (check docs for G_PRIORITY_HIGH_IDLE) */
+	e->frame_tick = FALSE;
+	e->frame_id = g_idle_add_full (G_PRIORITY_HIGH_IDLE, frame_idle, e, NULL);
+}
+
+/* removes the scheduled frame once nothing is pending anymore */
+static void
+html_engine_cancel_frame (HTMLEngine *e)
+{
+	if (!e->frame_id || e->thaw_pending || e->update_pending || e->redraw_pending)
+		return;
+
+#if GTK_CHECK_VERSION (3, 8, 0)
+	if (e->frame_tick)
+		gtk_widget_remove_tick_callback (GTK_WIDGET (e->widget), e->frame_id);
+	else
+#endif
+		g_source_remove (e->frame_id);
+	e->frame_id = 0;
+}
+
+/**
+ * html_engine_reschedule_frame:
+ * @e: an engine
+ *
+ * Moves the pending frame to the frame clock when the widget has been
+ * mapped, or to an idle when it has been unmapped and its frame clock
+ * no longer ticks.
+ **/
+void
+html_engine_reschedule_frame (HTMLEngine *e)
+{
+	g_return_if_fail (HTML_IS_ENGINE (e));
+
+	if (e->frame_id) {
+#if GTK_CHECK_VERSION (3, 8, 0)
+		if (e->frame_tick)
+			gtk_widget_remove_tick_callback (GTK_WIDGET (e->widget), e->frame_id);
+		else
+#endif
+			g_source_remove (e->frame_id);
+		e->frame_id = 0;
+		html_engine_schedule_frame (e);
+	}
+}
+
 static gboolean
 html_engine_update_event (HTMLEngine *e)
 {
@@ -4977,7 +5085,7 @@ html_engine_update_event (HTMLEngine *e)
 	hadjustment = gtk_layout_get_hadjustment (layout);
 	vadjustment = gtk_layout_get_vadjustment (layout);
 
-	e->updateTimer = 0;
+	e->update_pending = FALSE;
 
 	if (html_engine_get_editable (e))
 		html_engine_hide_cursor (e);
@@ -5023,6 +5131,7 @@ html_engine_update_event (HTMLEngine *e)
 		gtk_adjustment_set_value (hadjustment, e->x_offset);
 	}
 	html_image_factory_deactivate_animations (e->image_factory);
+	html_image_factory_schedule_loads (e->image_factory);
 	gtk_container_forall (GTK_CONTAINER (e->widget), update_embedded, e->widget);
 	html_engine_queue_redraw_all (e);
 
@@ -5041,10 +5150,11 @@ html_engine_schedule_update (HTMLEngine *e)
 	DI (printf ("html_engine_schedule_update (may block %d)\n", e->opened_streams));
 	if (e->block && e->opened_streams)
 		return;
-	DI (printf ("html_engine_schedule_update - timer %d\n", e->updateTimer));
-	if (e->updateTimer == 0)
-		/* schedule with priority higher than gtk+ uses for animations (check docs for G_PRIORITY_HIGH_IDLE) */
-		e->updateTimer = g_idle_add_full (G_PRIORITY_HIGH_IDLE, (GSourceFunc) html_engine_update_event, e, NULL);
+	DI (printf ("html_engine_schedule_update - pending %d\n", e->update_pending));
+	if (!e->update_pending) {
+		e->update_pending = TRUE;
+		html_engine_schedule_frame (e);
+	}
 }
 
 
@@ -5142,9 +5252,9 @@ html_engine_timer_event (HTMLEngine *e)
 
  out:
 	if (!retval) {
-		if (e->updateTimer != 0) {
-			g_source_remove (e->updateTimer);
+		if (e->update_pending) {
 			html_engine_update_event (e);
+			html_engine_cancel_frame (e);
 		}
 
 		e->timerId = 0;
@@ -5333,7 +5443,7 @@ redraw_idle (HTMLEngine *e)
 {
 	g_return_val_if_fail (HTML_IS_ENGINE (e), FALSE);
 
-	e->redraw_idle_id = 0;
+	e->redraw_pending = FALSE;
 	e->need_redraw = FALSE;
 	html_engine_queue_redraw_all (e);
 
@@ -5349,11 +5459,11 @@ html_engine_schedule_redraw (HTMLEngine *e)
 
 	if (e->block_redraw)
 		e->need_redraw = TRUE;
-	else if (e->redraw_idle_id == 0) {
+	else if (!e->redraw_pending) {
 		clear_pending_expose (e);
 		html_draw_queue_clear (e->draw_queue);
-		/* schedule with priority higher than gtk+ uses for animations (check docs for G_PRIORITY_HIGH_IDLE) */
-		e->redraw_idle_id = g_idle_add_full (G_PRIORITY_HIGH_IDLE, (GSourceFunc) redraw_idle, e, NULL);
+		e->redraw_pending = TRUE;
+		html_engine_schedule_frame (e);
 	}
 }
 
@@ -5363,9 +5473,9 @@ html_engine_block_redraw (HTMLEngine *e)
 	g_return_if_fail (HTML_IS_ENGINE (e));
 
 	e->block_redraw++;
-	if (e->redraw_idle_id) {
-		g_source_remove (e->redraw_idle_id);
-		e->redraw_idle_id = 0;
+	if (e->redraw_pending) {
+		e->redraw_pending = FALSE;
+		html_engine_cancel_frame (e);
 		e->need_redraw = TRUE;
 	}
 }
@@ -5379,9 +5489,9 @@ html_engine_unblock_redraw (HTMLEngine *e)
 
 	e->block_redraw--;
 	if (!e->block_redraw && e->need_redraw) {
-		if (e->redraw_idle_id) {
-			g_source_remove (e->redraw_idle_id);
-			e->redraw_idle_id = 0;
+		if (e->redraw_pending) {
+			e->redraw_pending = FALSE;
+			html_engine_cancel_frame (e);
 		}
 		redraw_idle (e);
 	}
@@ -6097,7 +6207,7 @@ thaw_idle (gpointer data)
 	check_cursor (e);
 #endif
 
-	e->thaw_idle_id = 0;
+	e->thaw_pending = FALSE;
 	if (e->freeze_count != 1) {
 		/* we have been frozen again meanwhile */
 		DF (printf ("frozen again meanwhile\n"); fflush (stdout);)
@@ -6169,10 +6279,10 @@ html_engine_thaw (HTMLEngine *engine)
 	g_return_if_fail (engine->freeze_count > 0);
 
 	if (engine->freeze_count == 1) {
-		if (engine->thaw_idle_id == 0) {
+		if (!engine->thaw_pending) {
 			DF (printf ("queueing thaw_idle %d\n", engine->freeze_count);)
-			/* schedule with priority higher than gtk+ uses for animations (check docs for G_PRIORITY_HIGH_IDLE) */
-			engine->thaw_idle_id = g_idle_add_full (G_PRIORITY_HIGH_IDLE, thaw_idle, engine, NULL);
+			engine->thaw_pending = TRUE;
+			html_engine_schedule_frame (engine);
 		}
 	} else {
 		engine->freeze_count--;
@@ -6187,9 +6297,9 @@ html_engine_thaw_idle_flush (HTMLEngine *e)
 {
 	DF (printf ("html_engine_thaw_idle_flush\n"); fflush (stdout);)
 
-	if (e->thaw_idle_id) {
-		g_source_remove (e->thaw_idle_id);
+	if (e->thaw_pending) {
 		thaw_idle (e);
+		html_engine_cancel_frame (e);
 	}
 }
 
@@ -6407,7 +6517,7 @@ html_engine_spell_word_is_valid (HTMLEngine *e)
 {
 	HTMLObject *obj;
 	HTMLText   *text;
-	GList *cur;
+	guint i;
 	gboolean valid = TRUE;
 	gint offset;
 	gunichar prev, curr;
@@ -6437,17 +6547,10 @@ html_engine_spell_word_is_valid (HTMLEngine *e)
 	text = HTML_TEXT (obj);
 
 	/* now we have text, so let search for spell_error area in it */
-	cur = text->spell_errors;
-	while (cur) {
-		SpellError *se = (SpellError *) cur->data;
-		if (se->off <= offset && offset <= se->off + se->len) {
-			valid = FALSE;
-			break;
-		}
-		if (offset < se->off)
-			break;
-		cur = cur->next;
-	}
+	i = html_text_spell_errors_find (text, offset);
+	if (text->spell_errors && i < text->spell_errors->len
+	    && g_array_index (text->spell_errors, SpellError, i).off <= offset)
+		valid = FALSE;
 
 	/* printf ("is_valid: %d\n", valid); */
 
@@ -7150,7 +7253,7 @@ check_link_in_selection (HTMLObject *o,
 {
 	g_return_if_fail (HTML_IS_ENGINE (e));
 
-	if ((HTML_IS_TEXT (o) && HTML_TEXT (o)->links) ||
+	if ((HTML_IS_TEXT (o) && html_text_get_n_links (HTML_TEXT (o))) ||
 	    (HTML_IS_IMAGE (o) && (HTML_IMAGE (o)->url || HTML_IMAGE (o)->target)))
 		*has_link = TRUE;
 }
@@ -77,7 +77,7 @@ struct _HTMLEngine {
 	 * nor repaints.  When going from nonzero to zero, we relayout and
 	 * repaint everything.  */
 	guint freeze_count;
-	guint thaw_idle_id;
+	gboolean thaw_pending;
 	gint block_redraw;
 	gboolean need_redraw;
 	GSList *pending_expose;
@@ -126,13 +126,20 @@ struct _HTMLEngine {
 	gchar *url;
 	gchar *target;
 
-	/* timer id to schedule paint events */
-	guint updateTimer;
+	/* a relayout is scheduled for the next frame */
+	gboolean update_pending;
 
 	/* timer id for parsing routine */
 	guint timerId;
 
-	guint redraw_idle_id;
+	gboolean redraw_pending;
+
+	/* The thaw, update and redraw pending above run together in one
+	 * frame, from an idle or a tick callback of the widget.  */
+	guint frame_id;
+	gboolean frame_tick;
+	/* time spent in layout since the last paint, in microseconds */
+	gint64 frame_layout_time;
 
 	/* FIXME: replace with a `gchar *'?  */
 	GString *title;
@@ -238,6 +245,10 @@ struct _HTMLEngine {
 
 	gboolean need_spell_check;
 	gint block_events;
+
+	/* html_engine_begin_batch nesting and lowest deferred spell check position */
+	gint batch_level;
+	gint batch_spell_position;
 	gchar *language;
 
 	GSList *cursor_position_stack;
@@ -347,6 +358,7 @@ void  html_engine_draw_background      (HTMLEngine *e,
 
 /* Scrolling.  */
 void      html_engine_schedule_update      (HTMLEngine  *e);
+void      html_engine_reschedule_frame     (HTMLEngine  *e);
 void      html_engine_schedule_redraw      (HTMLEngine  *e);
 void      html_engine_block_redraw         (HTMLEngine  *e);
 void      html_engine_unblock_redraw       (HTMLEngine  *e);
@@ -234,6 +234,15 @@ check_page_split (HTMLObject *self,
 	return html_object_check_page_split (GTK_HTML (HTML_FRAME (self)->html)->engine->clue, p, y);
 }
 
+static void
+add_page_split_ranges (HTMLObject *self,
+                       HTMLPainter *p,
+                       gint y,
+                       GArray *ranges)
+{
+	html_object_add_page_split_ranges (GTK_HTML (HTML_FRAME (self)->html)->engine->clue, p, y, ranges);
+}
+
 static gboolean
 html_frame_real_calc_size (HTMLObject *o,
                            HTMLPainter *painter,
@@ -620,6 +629,7 @@ html_frame_class_init (HTMLFrameClass *klass,
 	object_class->set_max_width           = set_max_width;
 	object_class->forall                  = forall;
 	object_class->check_page_split        = check_page_split;
+	object_class->add_page_split_ranges   = add_page_split_ranges;
 	object_class->search                  = search;
 	object_class->head                    = head;
 	object_class->tail                    = tail;
@@ -392,6 +392,53 @@ calc_min_width (HTMLObject *o,
 	return -1;
 }
 
+static gint
+check_page_split (HTMLObject *self,
+                  HTMLPainter *p,
+                  gint y)
+{
+	HTMLFrameset *set = HTML_FRAMESET (self);
+	gboolean changed;
+	gint i;
+
+	/* the split has to fit all the frames it crosses */
+	do {
+		changed = FALSE;
+		for (i = 0; i < set->frames->len; i++) {
+			HTMLObject *frame = g_ptr_array_index (set->frames, i);
+			gint y1 = frame->y - frame->ascent;
+			gint y2 = frame->y + frame->descent;
+
+			if (y1 <= y && y < y2) {
+				gint cs = html_object_check_page_split (frame, p, y - y1) + y1;
+
+				if (cs < y) {
+					y = cs;
+					changed = TRUE;
+				}
+			}
+		}
+	} while (changed);
+
+	return y;
+}
+
+static void
+add_page_split_ranges (HTMLObject *self,
+                       HTMLPainter *p,
+                       gint y,
+                       GArray *ranges)
+{
+	HTMLFrameset *set = HTML_FRAMESET (self);
+	gint i;
+
+	for (i = 0; i < set->frames->len; i++) {
+		HTMLObject *frame = g_ptr_array_index (set->frames, i);
+
+		html_object_add_page_split_ranges (frame, p, y + frame->y - frame->ascent, ranges);
+	}
+}
+
 void
 html_frameset_type_init (void)
 {
@@ -419,6 +466,8 @@ html_frameset_class_init (HTMLFramesetClass *klass,
 	object_class->is_container = is_container;
 
 	object_class->calc_min_width = calc_min_width;
+	object_class->check_page_split = check_page_split;
+	object_class->add_page_split_ranges = add_page_split_ranges;
 	/*
 	object_class->copy = copy;
 	object_class->op_copy = op_copy;
@@ -439,7 +488,6 @@ html_frameset_class_init (HTMLFramesetClass *klass,
 	object_class->prev = prev;
 	object_class->save = save;
 	object_class->save_plain = save_plain;
-	object_class->check_page_split = check_page_split;
 	object_class->get_bg_color = get_bg_color;
 	object_class->get_recursive_length = get_recursive_length;
 	object_class->remove_child = remove_child;
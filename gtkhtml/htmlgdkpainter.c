@@ -569,66 +569,190 @@ draw_background (HTMLPainter *painter,
 	}
 }
 
+/* Image surface cache: the scaled and tinted versions of pixbufs are kept
+ * as premultiplied cairo image surfaces, so repainting an image costs a
+ * blit instead of a resample and a pixel format conversion. The entries
+ * of a pixbuf hang on the pixbuf itself and go away with it; all entries
+ * share one LRU list bounded by HTML_GDK_PAINTER_IMAGE_CACHE_SIZE bytes.
+ * The LRU list is guarded by image_cache, pixbufs (and so their entries)
+ * may be finalized off the main thread, e.g. by a print job. */
+
+typedef struct {
+	GSList *entries;
+} ImageCacheList;
+
+typedef struct {
+	ImageCacheList *list;
+	GList lru_link;
+	cairo_surface_t *surface;
+	gint width;
+	gint height;
+	gboolean tinted;
+	GdkColor tint;
+	gsize bytes;
+} ImageCacheEntry;
+
+static GQueue image_cache_lru = G_QUEUE_INIT;
+static gsize image_cache_bytes = 0;
+static GQuark image_cache_quark = 0;
+G_LOCK_DEFINE_STATIC (image_cache);
+
+/* image_cache must be held */
 static void
-draw_pixmap (HTMLPainter *painter,
-             GdkPixbuf *pixbuf,
-             gint x,
-             gint y,
-             gint scale_width,
-             gint scale_height,
-             const GdkColor *color)
+image_cache_entry_free (ImageCacheEntry *entry)
 {
-	GdkRectangle clip, image, paint;
-	HTMLGdkPainter *gdk_painter;
-	GdkPixbuf *tmp_pixbuf;
-	guint n_channels;
-	gint orig_width;
-	gint orig_height;
-	gint bilinear;
+	g_queue_unlink (&image_cache_lru, &entry->lru_link);
+	image_cache_bytes -= entry->bytes;
+	cairo_surface_destroy (entry->surface);
+	g_free (entry);
+}
 
-	gdk_painter = HTML_GDK_PAINTER (painter);
+static void
+image_cache_list_free (gpointer data)
+{
+	ImageCacheList *list = data;
 
-	orig_width = gdk_pixbuf_get_width (pixbuf);
-	orig_height = gdk_pixbuf_get_height (pixbuf);
+	G_LOCK (image_cache);
+	g_slist_free_full (list->entries, (GDestroyNotify) image_cache_entry_free);
+	G_UNLOCK (image_cache);
+	g_free (list);
+}
 
-	if (scale_width < 0)
-		scale_width = orig_width;
-	if (scale_height < 0)
-		scale_height = orig_height;
+/* image_cache must be held */
+static void
+image_cache_evict (void)
+{
+	while (image_cache_bytes > HTML_GDK_PAINTER_IMAGE_CACHE_SIZE && image_cache_lru.length > 1) {
+		ImageCacheEntry *entry = image_cache_lru.tail->data;
 
-	image.x = x;
-	image.y = y;
-	image.width  = scale_width;
-	image.height = scale_height;
+		entry->list->entries = g_slist_remove (entry->list->entries, entry);
+		image_cache_entry_free (entry);
+	}
+}
 
-	clip.x = gdk_painter->x1;
-	clip.width = gdk_painter->x2 - gdk_painter->x1;
-	clip.y = gdk_painter->y1;
-	clip.height = gdk_painter->y2 - gdk_painter->y1;
+static cairo_surface_t *
+image_cache_lookup (GdkPixbuf *pixbuf,
+                    gint width,
+                    gint height,
+                    const GdkColor *color)
+{
+	ImageCacheList *list;
+	cairo_surface_t *surface = NULL;
+	GSList *l;
+
+	if (!image_cache_quark)
+		return NULL;
+
+	G_LOCK (image_cache);
+	list = g_object_get_qdata (G_OBJECT (pixbuf), image_cache_quark);
+
+	for (l = list ? list->entries : NULL; l; l = l->next) {
+		ImageCacheEntry *entry = l->data;
+
+		if (entry->width == width && entry->height == height
+		    && entry->tinted == (color != NULL)
+		    && (!color || gdk_color_equal (&entry->tint, color))) {
+			g_queue_unlink (&image_cache_lru, &entry->lru_link);
+			g_queue_push_head_link (&image_cache_lru, &entry->lru_link);
+			surface = cairo_surface_reference (entry->surface);
+			break;
+		}
+	}
+	G_UNLOCK (image_cache);
 
-	if (!gdk_rectangle_intersect (&clip, &image, &paint))
-	    return;
+	return surface;
+}
 
-	if (scale_width == orig_width && scale_height == orig_height && color == NULL) {
-		gdk_cairo_set_source_pixbuf (gdk_painter->cr, pixbuf,
-					     image.x - clip.x,
-					     image.y - clip.y);
-		cairo_rectangle (gdk_painter->cr,
-				 image.x - clip.x, image.y - clip.y,
-				 image.width, image.height);
-		cairo_fill (gdk_painter->cr);
-		return;
+static cairo_surface_t *
+image_cache_insert (GdkPixbuf *pixbuf,
+                    GdkPixbuf *scaled,
+                    const GdkColor *color)
+{
+	ImageCacheList *list;
+	ImageCacheEntry *entry;
+	cairo_surface_t *surface;
+	cairo_t *cr;
+	gint width, height;
+
+	width = gdk_pixbuf_get_width (scaled);
+	height = gdk_pixbuf_get_height (scaled);
+	surface = cairo_image_surface_create (gdk_pixbuf_get_has_alpha (scaled) ? CAIRO_FORMAT_ARGB32 : CAIRO_FORMAT_RGB24,
+					      width, height);
+	cr = cairo_create (surface);
+	gdk_cairo_set_source_pixbuf (cr, scaled, 0, 0);
+	cairo_set_operator (cr, CAIRO_OPERATOR_SOURCE);
+	cairo_paint (cr);
+	cairo_destroy (cr);
+
+	if (!image_cache_quark)
+		image_cache_quark = g_quark_from_static_string ("html-gdk-painter-image-cache");
+
+	G_LOCK (image_cache);
+	list = g_object_get_qdata (G_OBJECT (pixbuf), image_cache_quark);
+	if (!list) {
+		list = g_new0 (ImageCacheList, 1);
+		g_object_set_qdata_full (G_OBJECT (pixbuf), image_cache_quark, list, image_cache_list_free);
 	}
 
+	entry = g_new0 (ImageCacheEntry, 1);
+	entry->list = list;
+	entry->lru_link.data = entry;
+	entry->surface = surface;
+	entry->width = width;
+	entry->height = height;
+	entry->tinted = color != NULL;
+	if (color)
+		entry->tint = *color;
+	entry->bytes = (gsize) cairo_image_surface_get_stride (surface) * height;
+
+	list->entries = g_slist_prepend (list->entries, entry);
+	g_queue_push_head_link (&image_cache_lru, &entry->lru_link);
+	image_cache_bytes += entry->bytes;
+
+	/* the new entry stays even if it alone is over the budget */
+	image_cache_evict ();
+
+	/* keep the surface alive for the caller even if another thread evicts it */
+	cairo_surface_reference (surface);
+	G_UNLOCK (image_cache);
+
+	return surface;
+}
+
+/* Drops the cached surfaces made from pixbuf, call it whenever the pixels
+ * of a pixbuf drawn before are modified (progressive loading, animations
+ * reusing the frame pixbuf). */
+void
+html_gdk_painter_pixbuf_changed (GdkPixbuf *pixbuf)
+{
+	if (image_cache_quark && pixbuf)
+		g_object_set_qdata (G_OBJECT (pixbuf), image_cache_quark, NULL);
+}
+
+static GdkPixbuf *
+scale_pixbuf (GdkPixbuf *pixbuf,
+              gint scale_width,
+              gint scale_height,
+              const GdkColor *color)
+{
+	GdkPixbuf *tmp_pixbuf;
+	guint n_channels;
+	gint orig_width;
+	gint orig_height;
+	gint bilinear;
+
+	orig_width = gdk_pixbuf_get_width (pixbuf);
+	orig_height = gdk_pixbuf_get_height (pixbuf);
+
 	tmp_pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB,
 				     gdk_pixbuf_get_has_alpha (pixbuf),
 				     gdk_pixbuf_get_bits_per_sample (pixbuf),
-				     image.width, image.height);
-
-	gdk_pixbuf_fill (tmp_pixbuf, 0xff000000);
+				     scale_width, scale_height);
 
 	if (tmp_pixbuf == NULL)
-		return;
+		return NULL;
+
+	gdk_pixbuf_fill (tmp_pixbuf, 0xff000000);
 
 	/*
 	 * FIXME this is a hack to work around a gdk-pixbuf bug
@@ -641,7 +765,7 @@ draw_pixmap (HTMLPainter *painter,
 	gdk_pixbuf_composite (pixbuf, tmp_pixbuf,
 			      0,
 			      0,
-			      image.width, image.height,
+			      scale_width, scale_height,
 			      (double) 0.,
 			      (double) 0.,
 			      (gdouble) scale_width/ (gdouble) orig_width,
@@ -655,10 +779,10 @@ draw_pixmap (HTMLPainter *painter,
 
 		n_channels = gdk_pixbuf_get_n_channels (tmp_pixbuf);
 		q = gdk_pixbuf_get_pixels (tmp_pixbuf);
-		for (i = 0; i < image.height; i++) {
+		for (i = 0; i < scale_height; i++) {
 			guchar *p = q;
 
-			for (j = 0; j < image.width; j++) {
+			for (j = 0; j < scale_width; j++) {
 				gint r, g, b, a;
 
 				if (n_channels > 3)
@@ -684,14 +808,67 @@ draw_pixmap (HTMLPainter *painter,
 		}
 	}
 
-	gdk_cairo_set_source_pixbuf (gdk_painter->cr, tmp_pixbuf,
-				     image.x - clip.x,
-				     image.y - clip.y);
+	return tmp_pixbuf;
+}
+
+static void
+draw_pixmap (HTMLPainter *painter,
+             GdkPixbuf *pixbuf,
+             gint x,
+             gint y,
+             gint scale_width,
+             gint scale_height,
+             const GdkColor *color)
+{
+	GdkRectangle clip, image, paint;
+	HTMLGdkPainter *gdk_painter;
+	cairo_surface_t *surface;
+
+	gdk_painter = HTML_GDK_PAINTER (painter);
+
+	if (scale_width < 0)
+		scale_width = gdk_pixbuf_get_width (pixbuf);
+	if (scale_height < 0)
+		scale_height = gdk_pixbuf_get_height (pixbuf);
+
+	image.x = x;
+	image.y = y;
+	image.width  = scale_width;
+	image.height = scale_height;
+
+	clip.x = gdk_painter->x1;
+	clip.width = gdk_painter->x2 - gdk_painter->x1;
+	clip.y = gdk_painter->y1;
+	clip.height = gdk_painter->y2 - gdk_painter->y1;
+
+	if (!gdk_rectangle_intersect (&clip, &image, &paint))
+	    return;
+
+	surface = image_cache_lookup (pixbuf, scale_width, scale_height, color);
+	if (!surface) {
+		GdkPixbuf *scaled;
+
+		if (scale_width == gdk_pixbuf_get_width (pixbuf)
+		    && scale_height == gdk_pixbuf_get_height (pixbuf) && color == NULL)
+			scaled = g_object_ref (pixbuf);
+		else
+			scaled = scale_pixbuf (pixbuf, scale_width, scale_height, color);
+
+		if (scaled == NULL)
+			return;
+
+		surface = image_cache_insert (pixbuf, scaled, color);
+		g_object_unref (scaled);
+	}
+
+	cairo_set_source_surface (gdk_painter->cr, surface,
+				  image.x - clip.x,
+				  image.y - clip.y);
 	cairo_rectangle (gdk_painter->cr,
 			 image.x - clip.x, image.y - clip.y,
 			 image.width, image.height);
 	cairo_fill (gdk_painter->cr);
-	g_object_unref (tmp_pixbuf);
+	cairo_surface_destroy (surface);
 }
 
 static void
@@ -767,17 +944,20 @@ set_gdk_color_from_pango_color (GdkColor *gdkc,
 static void
 set_item_gc (HTMLPainter *p,
              HTMLPangoProperties *properties,
+             GdkColor *fg_storage,
+             GdkColor *bg_storage,
              GdkColor **fg_color,
              GdkColor **bg_color)
 {
+	/* called for every glyph run drawn, keep the colors on the stack */
 	if (properties->fg_color) {
-		*fg_color = g_new0 (GdkColor, 1);
+		*fg_color = fg_storage;
 		set_gdk_color_from_pango_color (*fg_color, properties->fg_color);
 	} else
 		*fg_color = NULL;
 
 	if (properties->bg_color) {
-		*bg_color = g_new0 (GdkColor, 1);
+		*bg_color = bg_storage;
 		set_gdk_color_from_pango_color (*bg_color, properties->bg_color);
 	} else {
 		*bg_color = NULL;
@@ -822,6 +1002,7 @@ draw_glyphs (HTMLPainter *painter,
 	HTMLGdkPainter *gdk_painter;
 	guint i;
 	HTMLPangoProperties properties;
+	GdkColor fg_storage, bg_storage;
 	GdkColor *fg_text_color;
 	GdkColor *bg_text_color;
 	gint cw = 0;
@@ -833,7 +1014,7 @@ draw_glyphs (HTMLPainter *painter,
 
 	html_pango_get_item_properties (item, &properties);
 
-	set_item_gc (painter, &properties, &fg_text_color, &bg_text_color);
+	set_item_gc (painter, &properties, &fg_storage, &bg_storage, &fg_text_color, &bg_text_color);
 
 	if (bg_text_color || bg) {
 		PangoRectangle log_rect;
@@ -871,12 +1052,6 @@ draw_glyphs (HTMLPainter *painter,
 	if (fg_text_color || fg)
 		cairo_restore (gdk_painter->cr);
 
-	if (fg_text_color)
-		g_free (fg_text_color);
-
-	if (bg_text_color)
-		g_free (bg_text_color);
-
 	return cw;
 }
 
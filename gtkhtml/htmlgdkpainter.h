@@ -35,6 +35,9 @@ G_BEGIN_DECLS
 #define HTML_IS_GDK_PAINTER(obj)              (G_TYPE_CHECK_INSTANCE_TYPE ((obj), HTML_TYPE_GDK_PAINTER))
 #define HTML_IS_GDK_PAINTER_CLASS(klass)      (G_TYPE_CHECK_CLASS_TYPE ((klass), HTML_TYPE_GDK_PAINTER))
 
+/* byte budget of the surfaces cached for scaled and tinted images */
+#define HTML_GDK_PAINTER_IMAGE_CACHE_SIZE (32 * 1024 * 1024)
+
 struct _HTMLGdkPainter {
 	HTMLPainter base;
 	GtkWidget *widget;
@@ -68,6 +71,7 @@ void               html_gdk_painter_realize                          (HTMLGdkPai
 								      GdkWindow             *window);
 void               html_gdk_painter_unrealize                        (HTMLGdkPainter        *painter);
 gboolean           html_gdk_painter_realized                         (HTMLGdkPainter        *painter);
+void               html_gdk_painter_pixbuf_changed                   (GdkPixbuf             *pixbuf);
 
 G_END_DECLS
 
@@ -233,20 +233,32 @@ check_page_split (HTMLObject *self,
                   gint y)
 {
 	HTMLEngine *e = GTK_HTML (HTML_IFRAME (self)->html)->engine;
-	gint y1, y2, pixel_size = html_painter_get_pixel_size (p);
+	gint top = html_painter_get_pixel_size (p) * html_engine_get_top_border (e);
 
-	y1 = self->y - self->ascent + pixel_size * html_engine_get_top_border (e);
-	y2 = self->y + self->descent + pixel_size * html_engine_get_bottom_border (e);
-
-	if (y1 > y)
+	/* y is relative to the top of the iframe, like in add_page_split_ranges */
+	if (y < top)
 		return 0;
 
-	if (y >= y1 && y < y2)
-		return html_object_check_page_split (e->clue, p, y - y1) + y1;
+	if (e->clue)
+		return html_object_check_page_split (e->clue, p, y - top) + top;
 
 	return y;
 }
 
+static void
+add_page_split_ranges (HTMLObject *self,
+                       HTMLPainter *p,
+                       gint y,
+                       GArray *ranges)
+{
+	HTMLEngine *e = GTK_HTML (HTML_IFRAME (self)->html)->engine;
+	gint top = html_painter_get_pixel_size (p) * html_engine_get_top_border (e);
+
+	html_object_add_page_split_range (ranges, y + 1, y + top - 1);
+	if (e->clue)
+		html_object_add_page_split_ranges (e->clue, p, y + top, ranges);
+}
+
 static void
 copy (HTMLObject *self,
       HTMLObject *dest)
@@ -755,6 +767,7 @@ html_iframe_class_init (HTMLIFrameClass *klass,
 	object_class->set_max_width           = set_max_width;
 	object_class->forall                  = forall;
 	object_class->check_page_split        = check_page_split;
+	object_class->add_page_split_ranges   = add_page_split_ranges;
 	object_class->search                  = search;
 	object_class->head                    = head;
 	object_class->tail                    = tail;
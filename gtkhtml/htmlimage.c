@@ -24,6 +24,7 @@
 */
 
 #include <config.h>
+#include <math.h>
 #include <string.h>
 
 #include "gtkhtml.h"
@@ -52,6 +53,20 @@ struct _HTMLImageFactory {
 	GHashTable *loaded_images;
 	GdkPixbuf  *missing;
 	gboolean    animate;
+
+	/* lazy loading, images are requested nearest to the viewport first */
+	gboolean    lazy;
+	guint       max_requests; /* 0 for no limit */
+	guint       n_requests;   /* image streams not finished yet */
+	guint       load_idle;
+
+	/* serve and feed the process-wide image cache */
+	gboolean    shared;
+
+	/* one timer advances the animations of all the images */
+	guint       animation_timer;
+	gint64      animation_time;
+	guint       animation_tick; /* frame clock callback */
 };
 
 
@@ -67,10 +82,25 @@ static HTMLImagePointer   *html_image_pointer_new               (const gchar *fi
 static void                html_image_pointer_ref               (HTMLImagePointer *ip);
 static void                html_image_pointer_unref             (HTMLImagePointer *ip);
 static gboolean            html_image_pointer_timeout           (HTMLImagePointer *ip);
-static gint                html_image_pointer_update            (HTMLImagePointer *ip);
+static gboolean            html_image_pointer_update            (HTMLImagePointer *ip);
 static void                html_image_pointer_start_animation   (HTMLImagePointer *ip);
+static void                html_image_pointer_stop_animation    (HTMLImagePointer *ip);
+static void                html_image_decoder_cancel            (HTMLImageDecoder *decoder);
+static void                html_image_pointer_check_size        (HTMLImagePointer *ip);
+
 
-static GdkPixbuf *         html_image_factory_get_missing       (HTMLImageFactory *factory);
+/* layout uses the natural size, the animation may be decoded smaller */
+static gint
+image_natural_width (HTMLImagePointer *ip)
+{
+	return ip->natural_width > 0 ? ip->natural_width : gdk_pixbuf_animation_get_width (ip->animation);
+}
+
+static gint
+image_natural_height (HTMLImagePointer *ip)
+{
+	return ip->natural_height > 0 ? ip->natural_height : gdk_pixbuf_animation_get_height (ip->animation);
+}
 
 guint
 html_image_get_actual_width (HTMLImage *image,
@@ -90,13 +120,13 @@ html_image_get_actual_width (HTMLImage *image,
 	} else if (image->image_ptr == NULL || anim == NULL) {
 		width = DEFAULT_SIZE * pixel_size;
 	} else {
-		width = gdk_pixbuf_animation_get_width (anim) * pixel_size;
+		width = image_natural_width (image->image_ptr) * pixel_size;
 
 		if (image->specified_height > 0 || image->percent_height) {
 			gdouble scale;
 
 			scale =  ((double) html_image_get_actual_height (image, painter))
-				/ (gdk_pixbuf_animation_get_height (anim) * pixel_size);
+				/ (image_natural_height (image->image_ptr) * pixel_size);
 
 			width *= scale;
 		}
@@ -124,13 +154,13 @@ html_image_get_actual_height (HTMLImage *image,
 	} else if (image->image_ptr == NULL || anim == NULL) {
 		height = DEFAULT_SIZE * pixel_size;
 	} else {
-		height = gdk_pixbuf_animation_get_height (anim) * pixel_size;
+		height = image_natural_height (image->image_ptr) * pixel_size;
 
 		if (image->specified_width > 0 || image->percent_width) {
 			gdouble scale;
 
 			scale = ((double) html_image_get_actual_width (image, painter))
-				/ (gdk_pixbuf_animation_get_width (anim) * pixel_size);
+				/ (image_natural_width (image->image_ptr) * pixel_size);
 
 			height *= scale;
 		}
@@ -462,6 +492,9 @@ draw (HTMLObject *o,
 
 	if (ip->animation) {
 		if (HTML_IS_GDK_PAINTER (painter) && !gdk_pixbuf_animation_is_static_image (ip->animation)) {
+			/* visible again, resume the paused animation */
+			if (!ip->next_frame)
+				html_image_pointer_start_animation (ip);
 			pixbuf = gdk_pixbuf_animation_iter_get_pixbuf (ip->iter);
 		} else {
 			pixbuf = gdk_pixbuf_animation_get_static_image (ip->animation);
@@ -488,7 +521,8 @@ draw (HTMLObject *o,
 		hspace = image->hspace * pixel_size;
 		vspace = image->vspace * pixel_size;
 
-		if (image->image_ptr->loader && !image->image_ptr->stall)
+		if (image->image_ptr->pending
+		    || (image->image_ptr->decoder && !image->image_ptr->stall))
 			return;
 
 		if (o->selected) {
@@ -1047,6 +1081,8 @@ html_image_set_size (HTMLImage *image,
 	}
 
 	if (changed) {
+		/* a larger size may need the image decoded again */
+		html_image_pointer_check_size (image->image_ptr);
 		html_object_change_set (HTML_OBJECT (image), HTML_CHANGE_ALL_CALC);
 		html_engine_schedule_update (image->image_ptr->factory->engine);
 	}
@@ -1149,29 +1185,473 @@ update_or_redraw (HTMLImagePointer *ip)
 	}
 }
 
+/* Images decoded at their natural size can be shared by the image
+ * factories of the process which opted in with html_image_factory_set_shared.
+ * The cache is keyed by the checksum of the encoded data, an URL which is
+ * not local to a document maps to the checksum of its last loaded data so
+ * that the image is neither requested nor decoded again. Such a factory
+ * does not emit url_requested for cached URLs, so it must not be used for
+ * documents whose remote content the application may want to block. The
+ * least recently used images are dropped once the cache grows over its size
+ * limit. The cache is not locked, it must only be used from the main thread. */
+
+typedef struct {
+	gchar *hash;
+	GSList *urls;
+	GdkPixbufAnimation *animation;
+	gsize size;
+	GList *link;
+} SharedImage;
+
+static GHashTable *shared_images = NULL;      /* hash -> SharedImage */
+static GHashTable *shared_image_urls = NULL;  /* url -> SharedImage */
+static GQueue shared_images_lru = G_QUEUE_INIT;
+static gsize shared_images_max_size = 0;
+static HTMLImageCacheStats shared_images_stats;
+
+/* cid: parts and the like differ from one message to another */
+static gboolean
+shared_image_url_is_global (const gchar *url)
+{
+	return url && *url && g_ascii_strncasecmp (url, "cid:", 4) != 0;
+}
+
+static gsize
+shared_image_size (GdkPixbufAnimation *animation)
+{
+	if (gdk_pixbuf_animation_is_static_image (animation)) {
+		GdkPixbuf *pixbuf = gdk_pixbuf_animation_get_static_image (animation);
+
+		return gdk_pixbuf_get_rowstride (pixbuf) * gdk_pixbuf_get_height (pixbuf);
+	}
+
+	/* the frames are not accessible, count one of them */
+	return (gsize) gdk_pixbuf_animation_get_width (animation) * gdk_pixbuf_animation_get_height (animation) * 4;
+}
+
 static void
-html_image_factory_end_pixbuf (GtkHTMLStream *stream,
-                               GtkHTMLStreamStatus status,
-                               gpointer user_data)
+shared_image_unlink_url (const gchar *url)
+{
+	SharedImage *si = g_hash_table_lookup (shared_image_urls, url);
+	GSList *l;
+
+	if (!si)
+		return;
+
+	l = g_slist_find_custom (si->urls, url, (GCompareFunc) strcmp);
+	g_free (l->data);
+	si->urls = g_slist_delete_link (si->urls, l);
+	g_hash_table_remove (shared_image_urls, url);
+}
+
+static void
+shared_image_free (SharedImage *si)
 {
-	HTMLImagePointer *ip = user_data;
+	GSList *l;
 
-	gdk_pixbuf_loader_close (ip->loader, NULL);
+	for (l = si->urls; l; l = l->next) {
+		g_hash_table_remove (shared_image_urls, l->data);
+		g_free (l->data);
+	}
+	g_slist_free (si->urls);
 
-	if (!ip->animation) {
-		ip->animation = gdk_pixbuf_loader_get_animation (ip->loader);
+	g_queue_delete_link (&shared_images_lru, si->link);
+	shared_images_stats.size -= si->size;
+	shared_images_stats.n_images--;
 
-		if (ip->animation)
-			g_object_ref (ip->animation);
+	g_object_unref (si->animation);
+	g_free (si->hash);
+	g_free (si);
+}
+
+static void
+shared_images_trim (gsize max_size)
+{
+	while (shared_images_stats.size > max_size && shared_images_lru.tail) {
+		SharedImage *si = shared_images_lru.tail->data;
+
+		g_hash_table_remove (shared_images, si->hash);
+		shared_images_stats.evictions++;
+	}
+}
+
+static void
+shared_image_touch (SharedImage *si)
+{
+	g_queue_unlink (&shared_images_lru, si->link);
+	g_queue_push_head_link (&shared_images_lru, si->link);
+}
+
+/* returns a new reference to the cached animation of url, or NULL */
+static GdkPixbufAnimation *
+shared_image_lookup (const gchar *url)
+{
+	SharedImage *si = NULL;
+
+	if (!shared_images_max_size || !shared_image_url_is_global (url))
+		return NULL;
+
+	if (shared_image_urls)
+		si = g_hash_table_lookup (shared_image_urls, url);
+	if (!si) {
+		shared_images_stats.misses++;
+		return NULL;
 	}
-	html_image_pointer_start_animation (ip);
 
-	g_object_unref (ip->loader);
-	ip->loader = NULL;
+	shared_images_stats.hits++;
+	shared_image_touch (si);
+
+	return g_object_ref (si->animation);
+}
+
+/* takes animation, returns the animation to use for url, which is the
+ * cached one if an image with the same data is in the cache already */
+static GdkPixbufAnimation *
+shared_image_add (const gchar *url,
+                  const gchar *hash,
+                  GdkPixbufAnimation *animation)
+{
+	SharedImage *si;
+
+	if (!shared_images_max_size)
+		return animation;
+
+	if (!shared_images) {
+		shared_images = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, (GDestroyNotify) shared_image_free);
+		shared_image_urls = g_hash_table_new (g_str_hash, g_str_equal);
+	}
+
+	si = g_hash_table_lookup (shared_images, hash);
+	if (si) {
+		shared_images_stats.shared++;
+		shared_image_touch (si);
+		g_object_unref (animation);
+		animation = si->animation;
+	} else {
+		si = g_new0 (SharedImage, 1);
+		si->hash = g_strdup (hash);
+		si->animation = animation;
+		si->size = shared_image_size (animation);
+		g_queue_push_head (&shared_images_lru, si);
+		si->link = shared_images_lru.head;
+		shared_images_stats.size += si->size;
+		shared_images_stats.n_images++;
+		g_hash_table_insert (shared_images, si->hash, si);
+	}
+
+	/* the url now stands for this data */
+	if (shared_image_url_is_global (url) && g_hash_table_lookup (shared_image_urls, url) != si) {
+		gchar *key = g_strdup (url);
+
+		shared_image_unlink_url (url);
+		si->urls = g_slist_prepend (si->urls, key);
+		g_hash_table_insert (shared_image_urls, key, si);
+	}
+
+	g_object_ref (animation);
+	shared_images_trim (shared_images_max_size);
+
+	return animation;
+}
+
+/**
+ * html_image_cache_set_max_size:
+ * @max_size: the size limit in bytes, 0 disables the cache
+ *
+ * Sets the size limit of the decoded images shared by the GtkHTML widgets
+ * of the process which enabled gtk_html_set_shared_images(). The cache is
+ * disabled by default. It must only be used from the main thread.
+ **/
+void
+html_image_cache_set_max_size (gsize max_size)
+{
+	shared_images_max_size = max_size;
+	if (shared_images)
+		shared_images_trim (max_size);
+}
+
+gsize
+html_image_cache_get_max_size (void)
+{
+	return shared_images_max_size;
+}
+
+void
+html_image_cache_get_stats (HTMLImageCacheStats *stats)
+{
+	g_return_if_fail (stats != NULL);
+
+	*stats = shared_images_stats;
+}
+
+/* drops all the cached images and resets the statistics */
+void
+html_image_cache_clear (void)
+{
+	if (shared_images)
+		g_hash_table_remove_all (shared_images);
+	memset (&shared_images_stats, 0, sizeof (HTMLImageCacheStats));
+}
+
+/* Image decoding runs on a thread pool: the stream data of an image
+ * pointer is queued in its HTMLImageDecoder, a worker feeds it to the
+ * pixbuf loader and passes copies of the partially decoded image and
+ * finally the animation back to the main loop, where the pointer is
+ * updated. Only one worker at a time uses the loader of a decoder. */
+
+/* minimal time between two progress updates of a decoded image, in ms */
+#define DECODE_UPDATE_INTERVAL 250
+
+/* Images are decoded at the largest size any of the interested images is
+ * displayed at, the encoded data is kept to decode them again if a larger
+ * size is needed later. */
+typedef struct {
+	gint width;  /* -1 when it follows from the other dimension */
+	gint height;
+} DecodeSize;
+
+struct _HTMLImageDecoder {
+	gint refcount;
+	GMutex lock;
+
+	/* main thread only */
+	HTMLImagePointer *ip;
+	gboolean from_stream;
+	gboolean holds_request; /* counted in the factory's n_requests */
+
+	/* set before decoding starts, read-only then; NULL for natural size */
+	GArray *sizes;
+
+	/* protected by lock */
+	GQueue chunks;
+	gboolean queued;
+	gboolean closed;
+	gboolean cancelled;
+	GdkPixbuf *snapshot;
+	GdkPixbufAnimation *animation;
+	gint natural_width;
+	gint natural_height;
+	GBytes *data;
+	gchar *hash;
+
+	/* worker only */
+	GdkPixbufLoader *loader;
+	gboolean finished;
+	gint64 last_snapshot;
+	GByteArray *encoded;
+	GChecksum *checksum; /* of the data, for the shared image cache */
+};
+
+/* scale (at most 1) the image of the given natural size is decoded at */
+static gdouble
+decode_scale (GArray *sizes,
+              gint width,
+              gint height)
+{
+	gdouble scale = 0.0;
+	guint i;
+
+	if (!sizes || width <= 0 || height <= 0)
+		return 1.0;
+
+	for (i = 0; i < sizes->len; i++) {
+		DecodeSize *size = &g_array_index (sizes, DecodeSize, i);
+
+		if (size->width > 0)
+			scale = MAX (scale, (gdouble) size->width / width);
+		if (size->height > 0)
+			scale = MAX (scale, (gdouble) size->height / height);
+	}
+
+	return MIN (scale, 1.0);
+}
+
+/* sizes the interested images are displayed at, NULL when one of them
+ * needs the natural size or one which depends on the layout */
+static GArray *
+html_image_pointer_get_requested_sizes (HTMLImagePointer *ip)
+{
+	GArray *sizes;
+	GSList *l;
+	gint pixel_size = 1;
+
+	if (!ip->interests)
+		return NULL;
+
+	if (ip->factory && ip->factory->engine->painter)
+		pixel_size = html_painter_get_pixel_size (ip->factory->engine->painter);
+
+	sizes = g_array_new (FALSE, FALSE, sizeof (DecodeSize));
+	for (l = ip->interests; l; l = l->next) {
+		HTMLImage *image = l->data;
+		DecodeSize size;
+
+		/* backgrounds are tiled at the natural size */
+		if (!image || image->percent_width || image->percent_height
+		    || (image->specified_width <= 0 && image->specified_height <= 0)) {
+			g_array_free (sizes, TRUE);
+			return NULL;
+		}
+
+		size.width = image->specified_width > 0 ? image->specified_width * pixel_size : -1;
+		size.height = image->specified_height > 0 ? image->specified_height * pixel_size : -1;
+		g_array_append_val (sizes, size);
+	}
+
+	return sizes;
+}
+
+static GThreadPool *decode_pool = NULL;
+
+static void decoder_run (gpointer data, gpointer user_data);
+
+static HTMLImageDecoder *
+html_image_decoder_ref (HTMLImageDecoder *decoder)
+{
+	g_atomic_int_inc (&decoder->refcount);
+
+	return decoder;
+}
+
+static void
+html_image_decoder_unref (HTMLImageDecoder *decoder)
+{
+	if (!g_atomic_int_dec_and_test (&decoder->refcount))
+		return;
+
+	g_signal_handlers_disconnect_matched (decoder->loader, G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, decoder);
+	if (!decoder->finished)
+		gdk_pixbuf_loader_close (decoder->loader, NULL);
+	g_object_unref (decoder->loader);
+
+	g_queue_foreach (&decoder->chunks, (GFunc) g_bytes_unref, NULL);
+	g_queue_clear (&decoder->chunks);
+	if (decoder->snapshot)
+		g_object_unref (decoder->snapshot);
+	if (decoder->animation)
+		g_object_unref (decoder->animation);
+	if (decoder->data)
+		g_bytes_unref (decoder->data);
+	if (decoder->encoded)
+		g_byte_array_unref (decoder->encoded);
+	if (decoder->sizes)
+		g_array_free (decoder->sizes, TRUE);
+	if (decoder->checksum)
+		g_checksum_free (decoder->checksum);
+	g_free (decoder->hash);
+	g_mutex_clear (&decoder->lock);
+	g_free (decoder);
+}
+
+/* called with lock held */
+static void
+decoder_schedule (HTMLImageDecoder *decoder)
+{
+	if (decoder->queued)
+		return;
+
+	if (!decode_pool)
+		decode_pool = g_thread_pool_new (decoder_run, NULL, g_get_num_processors (), FALSE, NULL);
+
+	decoder->queued = TRUE;
+	g_thread_pool_push (decode_pool, html_image_decoder_ref (decoder), NULL);
+}
+
+static void
+html_image_pointer_set_animation (HTMLImagePointer *ip,
+                                  GdkPixbufAnimation *animation)
+{
+	if (ip->iter) {
+		html_image_pointer_stop_animation (ip);
+		g_object_unref (ip->iter);
+		ip->iter = NULL;
+	}
+	if (ip->animation)
+		g_object_unref (ip->animation);
+	ip->animation = animation;
+}
+
+static gboolean
+decoder_progress_idle (gpointer data)
+{
+	HTMLImageDecoder *decoder = data;
+	HTMLImagePointer *ip = decoder->ip;
+	GdkPixbufSimpleAnim *anim;
+	GdkPixbuf *snapshot;
+
+	g_mutex_lock (&decoder->lock);
+	snapshot = decoder->snapshot;
+	decoder->snapshot = NULL;
+	g_mutex_unlock (&decoder->lock);
+
+	if (snapshot && ip && ip->decoder == decoder) {
+		ip->natural_width = decoder->natural_width;
+		ip->natural_height = decoder->natural_height;
+
+		/* a single frame animation is static, it has no iter */
+		anim = gdk_pixbuf_simple_anim_new (gdk_pixbuf_get_width (snapshot), gdk_pixbuf_get_height (snapshot), 1);
+		gdk_pixbuf_simple_anim_add_frame (anim, snapshot);
+		html_image_pointer_set_animation (ip, GDK_PIXBUF_ANIMATION (anim));
+		update_or_redraw (ip);
+	}
+
+	if (snapshot)
+		g_object_unref (snapshot);
+	html_image_decoder_unref (decoder);
+
+	return FALSE;
+}
+
+/* gives the stream slot of the decoder back to the lazy loading */
+static void
+html_image_decoder_release_request (HTMLImageDecoder *decoder)
+{
+	HTMLImageFactory *factory = decoder->ip ? decoder->ip->factory : NULL;
+
+	if (!decoder->holds_request)
+		return;
+
+	decoder->holds_request = FALSE;
+	if (factory && factory->n_requests) {
+		factory->n_requests--;
+		html_image_factory_schedule_loads (factory);
+	}
+}
+
+static gboolean
+decoder_done_idle (gpointer data)
+{
+	HTMLImageDecoder *decoder = data;
+	HTMLImagePointer *ip = decoder->ip;
+
+	if (ip->decoder == decoder) {
+		ip->decoder = NULL;
+
+		g_mutex_lock (&decoder->lock);
+		if (decoder->animation) {
+			if (decoder->hash && ip->factory && ip->factory->shared)
+				decoder->animation = shared_image_add (ip->url, decoder->hash, decoder->animation);
+			html_image_pointer_set_animation (ip, decoder->animation);
+			ip->natural_width = decoder->natural_width;
+			ip->natural_height = decoder->natural_height;
+
+			if (ip->data)
+				g_bytes_unref (ip->data);
+			ip->data = decoder->data;
+			decoder->data = NULL;
+		}
+		decoder->animation = NULL;
+		g_mutex_unlock (&decoder->lock);
+
+		html_image_pointer_start_animation (ip);
+		html_image_decoder_unref (decoder);
+	}
 
 	/* if no ip->factory is set, then the image loading has been cancelled meanwhile, probably. */
-	if (ip->factory) {
+	if (ip->factory)
 		update_or_redraw (ip);
+	html_image_decoder_release_request (decoder);
+	if (ip->factory && decoder->from_stream) {
 		if (ip->factory->engine->opened_streams && ip->factory->engine->block_images)
 			html_engine_opened_streams_decrement (ip->factory->engine);
 		/* printf ("IMAGE(%p) opened streams: %d\n", ip->factory->engine, ip->factory->engine->opened_streams); */
@@ -1179,7 +1659,210 @@ html_image_factory_end_pixbuf (GtkHTMLStream *stream,
 			html_engine_schedule_update (ip->factory->engine);
 	}
 
+	/* images registered meanwhile may need it larger */
+	if (!ip->decoder)
+		html_image_pointer_check_size (ip);
+
+	/* the reference taken when the decoder was created */
+	decoder->ip = NULL;
 	html_image_pointer_unref (ip);
+	html_image_decoder_unref (decoder);
+
+	return FALSE;
+}
+
+/* worker side */
+
+static void
+decoder_take_snapshot (HTMLImageDecoder *decoder,
+                       gboolean force)
+{
+	GdkPixbuf *pixbuf;
+	gint64 now;
+	gboolean pending;
+
+	now = g_get_monotonic_time ();
+	if (!force && now - decoder->last_snapshot < DECODE_UPDATE_INTERVAL * 1000)
+		return;
+
+	pixbuf = gdk_pixbuf_loader_get_pixbuf (decoder->loader);
+	if (!pixbuf)
+		return;
+
+	decoder->last_snapshot = now;
+	/* the loader keeps writing into its pixbuf, the main loop gets a copy */
+	pixbuf = gdk_pixbuf_copy (pixbuf);
+
+	g_mutex_lock (&decoder->lock);
+	pending = decoder->snapshot != NULL;
+	if (decoder->snapshot)
+		g_object_unref (decoder->snapshot);
+	decoder->snapshot = pixbuf;
+	g_mutex_unlock (&decoder->lock);
+
+	if (!pending)
+		g_idle_add (decoder_progress_idle, html_image_decoder_ref (decoder));
+}
+
+static void
+decoder_size_prepared (GdkPixbufLoader *loader,
+                       gint width,
+                       gint height,
+                       HTMLImageDecoder *decoder)
+{
+	gdouble scale = decode_scale (decoder->sizes, width, height);
+
+	g_mutex_lock (&decoder->lock);
+	decoder->natural_width = width;
+	decoder->natural_height = height;
+	g_mutex_unlock (&decoder->lock);
+
+	if (scale < 1.0)
+		gdk_pixbuf_loader_set_size (loader, MAX (1, ceil (width * scale)), MAX (1, ceil (height * scale)));
+}
+
+static void
+decoder_area_prepared (GdkPixbufLoader *loader,
+                       HTMLImageDecoder *decoder)
+{
+	decoder_take_snapshot (decoder, TRUE);
+}
+
+static void
+decoder_area_updated (GdkPixbufLoader *loader,
+                      gint x,
+                      gint y,
+                      gint width,
+                      gint height,
+                      HTMLImageDecoder *decoder)
+{
+	decoder_take_snapshot (decoder, FALSE);
+}
+
+static void
+decoder_run (gpointer data,
+             gpointer user_data)
+{
+	HTMLImageDecoder *decoder = data;
+
+	for (;;) {
+		GBytes *bytes;
+		gboolean cancelled, finish;
+
+		g_mutex_lock (&decoder->lock);
+		bytes = g_queue_pop_head (&decoder->chunks);
+		cancelled = decoder->cancelled;
+		finish = !bytes && decoder->closed && !decoder->finished;
+		if (!bytes && !finish)
+			decoder->queued = FALSE;
+		g_mutex_unlock (&decoder->lock);
+
+		if (bytes) {
+			gsize size;
+			gconstpointer buffer = g_bytes_get_data (bytes, &size);
+
+			/* FIXME !Check return value */
+			if (!cancelled) {
+				gdk_pixbuf_loader_write (decoder->loader, buffer, size, NULL);
+				if (decoder->encoded)
+					g_byte_array_append (decoder->encoded, buffer, size);
+				if (decoder->checksum)
+					g_checksum_update (decoder->checksum, buffer, size);
+			}
+			g_bytes_unref (bytes);
+		} else if (finish) {
+			GdkPixbufAnimation *animation;
+
+			g_signal_handlers_disconnect_matched (decoder->loader, G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, decoder);
+			gdk_pixbuf_loader_close (decoder->loader, NULL);
+			decoder->finished = TRUE;
+
+			animation = cancelled ? NULL : gdk_pixbuf_loader_get_animation (decoder->loader);
+			g_mutex_lock (&decoder->lock);
+			decoder->animation = animation ? g_object_ref (animation) : NULL;
+
+			/* keep the encoded image only if it was decoded smaller */
+			if (animation && gdk_pixbuf_animation_get_width (animation) < decoder->natural_width) {
+				if (decoder->encoded)
+					decoder->data = g_byte_array_free_to_bytes (decoder->encoded);
+			} else if (decoder->data) {
+				g_bytes_unref (decoder->data);
+				decoder->data = NULL;
+			}
+			if (decoder->encoded && !decoder->data)
+				g_byte_array_unref (decoder->encoded);
+			decoder->encoded = NULL;
+
+			/* only images decoded at their natural size are shared */
+			if (animation && decoder->checksum && !decoder->data)
+				decoder->hash = g_strdup (g_checksum_get_string (decoder->checksum));
+			g_mutex_unlock (&decoder->lock);
+
+			g_idle_add (decoder_done_idle, html_image_decoder_ref (decoder));
+		} else
+			break;
+	}
+
+	html_image_decoder_unref (decoder);
+}
+
+/* main thread side */
+
+static HTMLImageDecoder *
+html_image_decoder_new (HTMLImagePointer *ip)
+{
+	HTMLImageDecoder *decoder;
+
+	decoder = g_new0 (HTMLImageDecoder, 1);
+	decoder->refcount = 1;
+	g_mutex_init (&decoder->lock);
+	g_queue_init (&decoder->chunks);
+	decoder->ip = ip;
+	decoder->sizes = html_image_pointer_get_requested_sizes (ip);
+	if (decoder->sizes)
+		decoder->encoded = g_byte_array_new ();
+	decoder->loader = gdk_pixbuf_loader_new ();
+
+	g_signal_connect (G_OBJECT (decoder->loader), "size_prepared",
+			  G_CALLBACK (decoder_size_prepared), decoder);
+	g_signal_connect (G_OBJECT (decoder->loader), "area_prepared",
+			  G_CALLBACK (decoder_area_prepared), decoder);
+	g_signal_connect (G_OBJECT (decoder->loader), "area_updated",
+			  G_CALLBACK (decoder_area_updated), decoder);
+
+	return decoder;
+}
+
+/* drops the pointer's decoder, results still being decoded are ignored */
+static void
+html_image_decoder_cancel (HTMLImageDecoder *decoder)
+{
+	g_mutex_lock (&decoder->lock);
+	decoder->cancelled = TRUE;
+	g_mutex_unlock (&decoder->lock);
+
+	/* the stream may never be closed, let the next image load */
+	html_image_decoder_release_request (decoder);
+
+	if (decoder->ip->decoder == decoder)
+		decoder->ip->decoder = NULL;
+	html_image_decoder_unref (decoder);
+}
+
+static void
+html_image_factory_end_pixbuf (GtkHTMLStream *stream,
+                               GtkHTMLStreamStatus status,
+                               gpointer user_data)
+{
+	HTMLImageDecoder *decoder = user_data;
+
+	g_mutex_lock (&decoder->lock);
+	decoder->closed = TRUE;
+	decoder_schedule (decoder);
+	g_mutex_unlock (&decoder->lock);
+
+	/* the stream's reference */
+	html_image_decoder_unref (decoder);
 }
 
 static void
@@ -1188,40 +1871,138 @@ html_image_factory_write_pixbuf (GtkHTMLStream *stream,
                                  gsize size,
                                  gpointer user_data)
 {
-	HTMLImagePointer *p = user_data;
+	HTMLImageDecoder *decoder = user_data;
+
+	g_mutex_lock (&decoder->lock);
+	if (!decoder->cancelled && !decoder->closed) {
+		g_queue_push_tail (&decoder->chunks, g_bytes_new (buffer, size));
+		decoder_schedule (decoder);
+	}
+	g_mutex_unlock (&decoder->lock);
+}
+
+/* Animation frames of all the images of a factory are advanced by a
+ * single timer, on multiples of the display frame interval so that the
+ * images changing at about the same time are redrawn together. When the
+ * widget is mapped, the timer only wakes the frame clock and the frames
+ * are advanced in its next frame, together with the engine's relayout
+ * and repaint (GTK+ 3.8 and later). An image none of whose interests has
+ * been drawn since its last frame is not on screen; its animation is
+ * paused until it is drawn again. */
+#define ANIMATION_FRAME_INTERVAL (G_USEC_PER_SEC / 60)
+
+static void html_image_factory_animation_tick (HTMLImageFactory *factory);
+
+#if GTK_CHECK_VERSION (3, 8, 0)
+static gboolean
+html_image_factory_animation_frame (GtkWidget *widget,
+                                    GdkFrameClock *frame_clock,
+                                    gpointer data)
+{
+	HTMLImageFactory *factory = data;
+
+	factory->animation_tick = 0;
+	html_image_factory_animation_tick (factory);
+
+	return FALSE;
+}
+#endif
+
+static gboolean
+html_image_factory_animation_timeout (HTMLImageFactory *factory)
+{
+	factory->animation_timer = 0;
+
+#if GTK_CHECK_VERSION (3, 8, 0)
+	if (factory->engine->widget && gtk_widget_get_mapped (GTK_WIDGET (factory->engine->widget))) {
+		factory->animation_tick = gtk_widget_add_tick_callback (GTK_WIDGET (factory->engine->widget),
+									html_image_factory_animation_frame,
+									factory, NULL);
+		return FALSE;
+	}
+#endif
+
+	html_image_factory_animation_tick (factory);
+
+	return FALSE;
+}
+
+static void
+html_image_factory_cancel_animation (HTMLImageFactory *factory)
+{
+	if (factory->animation_timer) {
+		g_source_remove (factory->animation_timer);
+		factory->animation_timer = 0;
+	}
+#if GTK_CHECK_VERSION (3, 8, 0)
+	if (factory->animation_tick) {
+		gtk_widget_remove_tick_callback (GTK_WIDGET (factory->engine->widget), factory->animation_tick);
+		factory->animation_tick = 0;
+	}
+#endif
+}
+
+static void
+html_image_factory_schedule_animation (HTMLImageFactory *factory,
+                                       gint64 time)
+{
+	gint64 now;
 
-	/* FIXME !Check return value */
-	gdk_pixbuf_loader_write (p->loader, (const guchar *) buffer, size, NULL);
+	/* the next frame reschedules the rest */
+	if (factory->animation_tick)
+		return;
+
+	if (factory->animation_timer) {
+		if (factory->animation_time <= time)
+			return;
+		g_source_remove (factory->animation_timer);
+	}
+
+	now = g_get_monotonic_time ();
+	factory->animation_time = time;
+	factory->animation_timer = g_timeout_add (time > now ? (time - now + 999) / 1000 : 0,
+						  (GSourceFunc) html_image_factory_animation_timeout,
+						  factory);
 }
 
 static void
 html_image_pointer_queue_animation (HTMLImagePointer *ip)
 {
-	if (!ip->animation_timeout && ip->factory && ip->factory->animate) {
+	if (!ip->next_frame && ip->factory && ip->factory->animate) {
 		gint delay;
 
 		gdk_pixbuf_animation_iter_advance (ip->iter, NULL);
 		delay = gdk_pixbuf_animation_iter_get_delay_time (ip->iter);
 
-		ip->animation_timeout = g_timeout_add (delay,
-						       (GSourceFunc) html_image_pointer_update,
-						       (gpointer) ip);
-	}
+		/* the last frame of an animation which does not loop */
+		if (delay < 0)
+			return;
 
+		ip->next_frame = g_get_monotonic_time () + (gint64) delay * 1000;
+		ip->next_frame += ANIMATION_FRAME_INTERVAL - 1;
+		ip->next_frame -= ip->next_frame % ANIMATION_FRAME_INTERVAL;
+		html_image_factory_schedule_animation (ip->factory, ip->next_frame);
+	}
 }
 
+/* redraws the current frame, returns FALSE when the animation is paused */
 static gboolean
 html_image_pointer_update (HTMLImagePointer *ip)
 {
 	HTMLEngine *engine;
 	GSList *cur;
+	gboolean visible = FALSE;
 
 	g_return_val_if_fail (ip->factory != NULL, FALSE);
 
 	engine = ip->factory->engine;
-	ip->animation_timeout = 0;
+	ip->next_frame = 0;
+
+	/* the frame pixbuf may be reused by the animation */
+	if (ip->iter)
+		html_gdk_painter_pixbuf_changed (gdk_pixbuf_animation_iter_get_pixbuf (ip->iter));
 
-	DA (printf ("animation_timeout (%p)\n", ip);)
+	DA (printf ("animation frame (%p)\n", ip);)
 	for (cur = ip->interests; cur; cur = cur->next) {
 		HTMLImage           *image = cur->data;
 
@@ -1230,11 +2011,38 @@ html_image_pointer_update (HTMLImagePointer *ip)
 
 			image->animation_active = FALSE;
 			html_engine_queue_draw (engine, HTML_OBJECT (image));
+			visible = TRUE;
 		}
 	}
 
-	html_image_pointer_start_animation (ip);
-	return FALSE;
+	if (visible)
+		html_image_pointer_start_animation (ip);
+
+	return visible;
+}
+
+static void
+html_image_factory_animation_tick (HTMLImageFactory *factory)
+{
+	GHashTableIter iter;
+	gpointer value;
+	gint64 now, next = G_MAXINT64;
+
+	now = g_get_monotonic_time ();
+
+	g_hash_table_iter_init (&iter, factory->loaded_images);
+	while (g_hash_table_iter_next (&iter, NULL, &value)) {
+		HTMLImagePointer *ip = value;
+
+		if (ip->next_frame && ip->next_frame <= now + ANIMATION_FRAME_INTERVAL / 2)
+			html_image_pointer_update (ip);
+		/* update may have scheduled the timer already */
+		if (ip->next_frame)
+			next = MIN (next, ip->next_frame);
+	}
+
+	if (next != G_MAXINT64)
+		html_image_factory_schedule_animation (factory, next);
 }
 
 static void
@@ -1251,39 +2059,12 @@ html_image_pointer_start_animation (HTMLImagePointer *ip)
 static void
 html_image_pointer_stop_animation (HTMLImagePointer *ip)
 {
-	if (ip->animation_timeout) {
-		g_source_remove (ip->animation_timeout);
-		ip->animation_timeout = 0;
-	}
-}
-
-static void
-html_image_factory_area_updated (GdkPixbufLoader *loader,
-                                 guint x,
-                                 guint y,
-                                 guint width,
-                                 guint height,
-                                 HTMLImagePointer *ip)
-{
-	html_image_pointer_stop_animation (ip);
-	/* update will requeue */
-	html_image_pointer_update (ip);
-}
-
-static void
-html_image_factory_area_prepared (GdkPixbufLoader *loader,
-                                  HTMLImagePointer *ip)
-{
-	if (!ip->animation) {
-		ip->animation = gdk_pixbuf_loader_get_animation (loader);
-		g_object_ref (ip->animation);
-
-		html_image_pointer_start_animation (ip);
-	}
-	update_or_redraw (ip);
+	ip->next_frame = 0;
 }
 
-static GdkPixbuf *
+/* the placeholder drawn for images which failed to load; it is rendered
+ * by GTK+ on first use, so that has to happen on the main thread */
+GdkPixbuf *
 html_image_factory_get_missing (HTMLImageFactory *factory)
 {
 	if (!factory->missing)
@@ -1302,6 +2083,14 @@ html_image_factory_new (HTMLEngine *e)
 	retval->loaded_images = g_hash_table_new (g_str_hash, g_str_equal);
 	retval->missing = NULL;
 	retval->animate = TRUE;
+	retval->lazy = FALSE;
+	retval->max_requests = 0;
+	retval->n_requests = 0;
+	retval->load_idle = 0;
+	retval->shared = FALSE;
+	retval->animation_timer = 0;
+	retval->animation_time = 0;
+	retval->animation_tick = 0;
 
 	return retval;
 }
@@ -1323,6 +2112,9 @@ cleanup_images (gpointer key,
 
 	/* clean only if this image is not used anymore */
 	if (!ip->interests) {
+		/* the stream may still be open, its slot is not ours anymore */
+		if (ip->decoder)
+			html_image_decoder_release_request (ip->decoder);
 		html_image_pointer_unref (ip);
 		ip->factory = NULL;
 		return TRUE;
@@ -1349,6 +2141,10 @@ html_image_factory_free (HTMLImageFactory *factory)
 	if (factory->missing)
 		g_object_unref (factory->missing);
 
+	if (factory->load_idle)
+		g_source_remove (factory->load_idle);
+	html_image_factory_cancel_animation (factory);
+
 	g_free (factory);
 }
 
@@ -1363,16 +2159,20 @@ html_image_pointer_new (const gchar *filename,
 	retval = g_new (HTMLImagePointer, 1);
 	retval->refcount = 1;
 	retval->url = g_strdup (filename);
-	retval->loader = gdk_pixbuf_loader_new ();
+	retval->decoder = NULL;
 	retval->iter = NULL;
 	retval->animation = NULL;
+	retval->natural_width = 0;
+	retval->natural_height = 0;
+	retval->data = NULL;
+	retval->pending = FALSE;
 	retval->interests = NULL;
 	retval->factory = factory;
 	retval->stall = FALSE;
 	retval->stall_timeout = g_timeout_add (STALL_INTERVAL,
 					       (GSourceFunc) html_image_pointer_timeout,
 					       retval);
-	retval->animation_timeout = 0;
+	retval->next_frame = 0;
 	return retval;
 }
 
@@ -1416,11 +2216,8 @@ html_image_pointer_ref (HTMLImagePointer *ip)
 static void
 free_image_ptr_data (HTMLImagePointer *ip)
 {
-	if (ip->loader) {
-		gdk_pixbuf_loader_close (ip->loader, NULL);
-		g_object_unref (ip->loader);
-		ip->loader = NULL;
-	}
+	if (ip->decoder)
+		html_image_decoder_cancel (ip->decoder);
 	if (ip->animation) {
 		g_object_unref (ip->animation);
 		ip->animation = NULL;
@@ -1429,6 +2226,12 @@ free_image_ptr_data (HTMLImagePointer *ip)
 		g_object_unref (ip->iter);
 		ip->iter = NULL;
 	}
+	if (ip->data) {
+		g_bytes_unref (ip->data);
+		ip->data = NULL;
+	}
+	ip->natural_width = 0;
+	ip->natural_height = 0;
 }
 
 static void
@@ -1463,15 +2266,260 @@ html_image_pointer_load (HTMLImagePointer *ip)
 	if (!ip->factory || ip->factory->engine->stopped)
 		return NULL;
 
+	/* released when the decoder is done */
 	html_image_pointer_ref (ip);
 
+	/* a new stream replaces the data of the previous one */
+	if (ip->decoder)
+		html_image_decoder_cancel (ip->decoder);
+	ip->decoder = html_image_decoder_new (ip);
+	ip->decoder->from_stream = TRUE;
+	if (shared_images_max_size && ip->factory->shared)
+		ip->decoder->checksum = g_checksum_new (G_CHECKSUM_SHA1);
+
+	ip->factory->n_requests++;
+	ip->decoder->holds_request = TRUE;
 	if (ip->factory->engine->block_images)
 		html_engine_opened_streams_increment (ip->factory->engine);
 	return gtk_html_stream_new (GTK_HTML (ip->factory->engine->widget),
 				    html_image_factory_types,
 				    html_image_factory_write_pixbuf,
 				    html_image_factory_end_pixbuf,
-				    ip);
+				    html_image_decoder_ref (ip->decoder));
+}
+
+/* requests the image data now or, in the lazy mode, once it is the
+ * nearest image to the viewport which is not loaded yet */
+static void
+html_image_pointer_request (HTMLImagePointer *ip)
+{
+	HTMLImageFactory *factory = ip->factory;
+	GtkHTMLStream *stream;
+
+	/* blocked engines wait for all the images before the first layout */
+	if (factory->lazy && !factory->engine->block_images) {
+		ip->pending = TRUE;
+		html_image_factory_schedule_loads (factory);
+		return;
+	}
+
+	ip->pending = FALSE;
+	stream = html_image_pointer_load (ip);
+	if (stream)
+		g_signal_emit_by_name (factory->engine, "url_requested", ip->url, stream);
+}
+
+/* distance of the image from the visible part of the document, images
+ * not laid out yet come last */
+static gint
+image_viewport_distance (HTMLImage *image,
+                         HTMLEngine *e)
+{
+	HTMLObject *o = HTML_OBJECT (image);
+	gint x, y, dx = 0, dy = 0;
+
+	/* the background is always visible */
+	if (!image)
+		return 0;
+	if (!o->parent)
+		return G_MAXINT;
+
+	html_object_calc_abs_position (o, &x, &y);
+
+	if (y + o->descent < e->y_offset)
+		dy = e->y_offset - y - o->descent;
+	else if (y - o->ascent > e->y_offset + e->height)
+		dy = y - o->ascent - e->y_offset - e->height;
+
+	if (x + o->width < e->x_offset)
+		dx = e->x_offset - x - o->width;
+	else if (x > e->x_offset + e->width)
+		dx = x - e->x_offset - e->width;
+
+	return dx + dy;
+}
+
+typedef struct {
+	HTMLImagePointer *ip;
+	gint distance;
+} PendingImage;
+
+static gint
+pending_image_compare (gconstpointer a,
+                       gconstpointer b)
+{
+	const PendingImage *pa = a, *pb = b;
+
+	return pa->distance < pb->distance ? -1 : pa->distance > pb->distance;
+}
+
+static gboolean
+html_image_factory_load_idle (HTMLImageFactory *factory)
+{
+	GHashTableIter iter;
+	GArray *pending;
+	gpointer value;
+	guint i, limit;
+
+	factory->load_idle = 0;
+
+	pending = g_array_new (FALSE, FALSE, sizeof (PendingImage));
+	g_hash_table_iter_init (&iter, factory->loaded_images);
+	while (g_hash_table_iter_next (&iter, NULL, &value)) {
+		HTMLImagePointer *ip = value;
+		PendingImage pi;
+		GSList *l;
+
+		if (!ip->pending)
+			continue;
+
+		pi.ip = ip;
+		pi.distance = G_MAXINT;
+		for (l = ip->interests; l; l = l->next)
+			pi.distance = MIN (pi.distance, image_viewport_distance (l->data, factory->engine));
+		g_array_append_val (pending, pi);
+	}
+
+	g_array_sort (pending, pending_image_compare);
+
+	/* the url_requested handlers may change the document */
+	for (i = 0; i < pending->len; i++)
+		html_image_pointer_ref (g_array_index (pending, PendingImage, i).ip);
+
+	limit = factory->lazy && factory->max_requests ? factory->max_requests : G_MAXUINT;
+	for (i = 0; i < pending->len; i++) {
+		HTMLImagePointer *ip = g_array_index (pending, PendingImage, i).ip;
+		GtkHTMLStream *stream;
+
+		if (ip->pending && ip->factory == factory && factory->n_requests < limit) {
+			ip->pending = FALSE;
+			stream = html_image_pointer_load (ip);
+			if (stream)
+				g_signal_emit_by_name (factory->engine, "url_requested", ip->url, stream);
+		}
+		html_image_pointer_unref (ip);
+	}
+
+	g_array_free (pending, TRUE);
+
+	return FALSE;
+}
+
+/**
+ * html_image_factory_schedule_loads:
+ * @factory: an image factory
+ *
+ * Lets the factory request the images waiting in the lazy loading mode
+ * once the current layout and scroll position are known.
+ **/
+void
+html_image_factory_schedule_loads (HTMLImageFactory *factory)
+{
+	g_return_if_fail (factory);
+
+	if (factory->lazy && !factory->load_idle)
+		factory->load_idle = g_idle_add ((GSourceFunc) html_image_factory_load_idle, factory);
+}
+
+/**
+ * html_image_factory_set_lazy_load:
+ * @factory: an image factory
+ * @lazy: whether images are requested lazily
+ * @max_requests: maximum number of image streams open at once, 0 for no limit
+ *
+ * In the lazy loading mode images are not requested as soon as they are
+ * parsed, but in the order of their distance from the viewport, with no
+ * more than @max_requests streams open at once.
+ **/
+void
+html_image_factory_set_lazy_load (HTMLImageFactory *factory,
+                                  gboolean lazy,
+                                  guint max_requests)
+{
+	g_return_if_fail (factory);
+
+	factory->max_requests = max_requests;
+	if (factory->lazy == lazy)
+		return;
+
+	factory->lazy = lazy;
+	if (!lazy && !factory->load_idle)
+		/* request the images still waiting */
+		factory->load_idle = g_idle_add ((GSourceFunc) html_image_factory_load_idle, factory);
+	else
+		html_image_factory_schedule_loads (factory);
+}
+
+gboolean
+html_image_factory_get_lazy_load (HTMLImageFactory *factory)
+{
+	g_return_val_if_fail (factory, FALSE);
+
+	return factory->lazy;
+}
+
+/**
+ * html_image_factory_set_shared:
+ * @factory: an image factory
+ * @shared: whether to use the process-wide image cache
+ *
+ * A shared factory takes the images of URLs already in the image cache
+ * (see html_image_cache_set_max_size()) without requesting them and adds
+ * the images it loads to the cache. Factories are not shared by default.
+ **/
+void
+html_image_factory_set_shared (HTMLImageFactory *factory,
+                               gboolean shared)
+{
+	g_return_if_fail (factory);
+
+	factory->shared = shared;
+}
+
+gboolean
+html_image_factory_get_shared (HTMLImageFactory *factory)
+{
+	g_return_val_if_fail (factory, FALSE);
+
+	return factory->shared;
+}
+
+/* decodes the kept image data again when it is displayed larger than
+ * it was decoded at */
+static void
+html_image_pointer_check_size (HTMLImagePointer *ip)
+{
+	HTMLImageDecoder *decoder;
+	GArray *sizes;
+	gdouble scale;
+
+	if (!ip->data || ip->decoder || !ip->animation || !ip->factory)
+		return;
+
+	sizes = html_image_pointer_get_requested_sizes (ip);
+	scale = decode_scale (sizes, ip->natural_width, ip->natural_height);
+	if (sizes)
+		g_array_free (sizes, TRUE);
+
+	if (ceil (ip->natural_width * scale) <= gdk_pixbuf_animation_get_width (ip->animation))
+		return;
+
+	/* released when the decoder is done */
+	html_image_pointer_ref (ip);
+
+	decoder = html_image_decoder_new (ip);
+	decoder->data = g_bytes_ref (ip->data);
+	if (decoder->encoded) {
+		g_byte_array_unref (decoder->encoded);
+		decoder->encoded = NULL;
+	}
+	ip->decoder = decoder;
+
+	g_mutex_lock (&decoder->lock);
+	g_queue_push_tail (&decoder->chunks, g_bytes_ref (ip->data));
+	decoder->closed = TRUE;
+	decoder_schedule (decoder);
+	g_mutex_unlock (&decoder->lock);
 }
 
 HTMLImagePointer *
@@ -1481,7 +2529,6 @@ html_image_factory_register (HTMLImageFactory *factory,
                              gboolean reload)
 {
 	HTMLImagePointer *ip;
-	GtkHTMLStream *stream = NULL;
 
 	g_return_val_if_fail (factory, NULL);
 	g_return_val_if_fail (url, NULL);
@@ -1491,36 +2538,30 @@ html_image_factory_register (HTMLImageFactory *factory,
 	if (!ip) {
 		ip = html_image_pointer_new (url, factory);
 		g_hash_table_insert (factory->loaded_images, ip->url, ip);
-		if (*url) {
-			g_signal_connect (G_OBJECT (ip->loader), "area_prepared",
-					  G_CALLBACK (html_image_factory_area_prepared),
-					  ip);
-
-			g_signal_connect (G_OBJECT (ip->loader), "area_updated",
-					  G_CALLBACK (html_image_factory_area_updated),
-					  ip);
-			stream = html_image_pointer_load (ip);
-		}
-	} else {
-		if (reload) {
-			free_image_ptr_data (ip);
-			ip->loader = gdk_pixbuf_loader_new ();
-			stream = html_image_pointer_load (ip);
+		if (*url && !reload && factory->shared) {
+			ip->animation = shared_image_lookup (url);
+			if (ip->animation)
+				html_image_pointer_start_animation (ip);
 		}
+		reload = *url && !ip->animation;
 	}
 
-	if (stream)
-		g_signal_emit_by_name (factory->engine, "url_requested", ip->url, stream);
-
 	html_image_pointer_ref (ip);
 
-	/* we add also NULL ptrs, as we dont want these to be cleaned out */
+	/* we add also NULL ptrs, as we dont want these to be cleaned out;
+	 * the interests decide the size the image is decoded at */
 	ip->interests = g_slist_prepend (ip->interests, i);
 
 	if (i) {
 		i->image_ptr = ip;
 	}
 
+	if (reload) {
+		free_image_ptr_data (ip);
+		html_image_pointer_request (ip);
+	} else
+		html_image_pointer_check_size (ip);
+
 	return ip;
 }
 
@@ -1553,6 +2594,8 @@ html_image_factory_unregister (HTMLImageFactory *factory,
 		 */
 		if (factory)
 			g_hash_table_remove (factory->loaded_images, pointer->url);
+		if (pointer->decoder)
+			html_image_decoder_release_request (pointer->decoder);
 		pointer->factory = NULL;
 		html_image_pointer_unref (pointer);
 	}
@@ -1573,6 +2616,8 @@ html_image_factory_stop_animations (HTMLImageFactory *factory)
 {
 	DA (g_warning ("stop animations");)
 	g_hash_table_foreach (factory->loaded_images, stop_anim, NULL);
+
+	html_image_factory_cancel_animation (factory);
 }
 
 static void
@@ -1623,7 +2668,7 @@ move_image_pointers (gpointer key,
 
 	g_hash_table_insert (dst->loaded_images, ip->url, ip);
 	if (!ip->factory->engine->stopped)
-		g_signal_emit_by_name (ip->factory->engine, "url_requested", ip->url, html_image_pointer_load (ip));
+		html_image_pointer_request (ip);
 
 	return TRUE;
 }
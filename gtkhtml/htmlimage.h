@@ -33,16 +33,30 @@
 struct _HTMLImagePointer {
 	gint refcount;
 	gchar *url;
-	GdkPixbufLoader *loader;
+	HTMLImageDecoder *decoder; /* set while the image data is being loaded */
 	GdkPixbufAnimation *animation;
 	GdkPixbufAnimationIter *iter;
+	gint natural_width;  /* size of the image, 0 until it's known; the */
+	gint natural_height; /* animation may be decoded smaller than that */
+	GBytes *data;        /* encoded image while the animation is smaller than its natural size */
+	gboolean pending;    /* waits to be requested by the lazy loading */
 	GSList *interests; /* A list of HTMLImage's, or a NULL pointer for the background pixmap */
 	HTMLImageFactory *factory;
 	gint stall;
 	guint stall_timeout;
-	guint animation_timeout;
+	gint64 next_frame; /* monotonic time the animation advances at, 0 when it is paused */
 };
 
+/* statistics of the image cache shared by all the image factories */
+typedef struct {
+	guint hits;      /* URLs found in the cache */
+	guint misses;    /* URLs which had to be requested */
+	guint shared;    /* loaded images whose data was in the cache already */
+	guint evictions; /* images dropped to stay under the size limit */
+	guint n_images;
+	gsize size;      /* in bytes */
+} HTMLImageCacheStats;
+
 #define HTML_IMAGE(x) ((HTMLImage *)(x))
 #define HTML_IMAGE_POINTER(x) ((HTMLImagePointer *)(x))
 
@@ -150,7 +164,16 @@ void              html_image_factory_start_animations       (HTMLImageFactory *f
 void              html_image_factory_set_animate            (HTMLImageFactory *factory,
 							     gboolean animate);
 gboolean          html_image_factory_get_animate            (HTMLImageFactory *factory);
+void              html_image_factory_set_lazy_load          (HTMLImageFactory *factory,
+							     gboolean          lazy,
+							     guint             max_requests);
+gboolean          html_image_factory_get_lazy_load          (HTMLImageFactory *factory);
+void              html_image_factory_set_shared             (HTMLImageFactory *factory,
+							     gboolean          shared);
+gboolean          html_image_factory_get_shared             (HTMLImageFactory *factory);
+void              html_image_factory_schedule_loads         (HTMLImageFactory *factory);
 void              html_image_factory_deactivate_animations  (HTMLImageFactory *factory);
+GdkPixbuf        *html_image_factory_get_missing            (HTMLImageFactory *factory);
 HTMLImagePointer *html_image_factory_register               (HTMLImageFactory *factory,
 							     HTMLImage        *i,
 							     const gchar       *filename,
@@ -166,4 +189,9 @@ void              html_image_factory_ref_image_ptr          (HTMLImageFactory *f
 							     const gchar      *url);
 void              html_image_factory_unref_image_ptr        (HTMLImageFactory *factory,
 							     const gchar      *url);
+
+void              html_image_cache_set_max_size             (gsize             max_size);
+gsize             html_image_cache_get_max_size             (void);
+void              html_image_cache_get_stats                (HTMLImageCacheStats *stats);
+void              html_image_cache_clear                    (void);
 #endif /* _HTMLIMAGE_H_ */
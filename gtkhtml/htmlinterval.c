@@ -205,6 +205,87 @@ html_interval_unselect (HTMLInterval *i,
 	html_interval_destroy (i);
 }
 
+typedef struct {
+	HTMLInterval *i;
+	gboolean in;
+} ReselectData;
+
+static void
+reselect_object (HTMLObject *o,
+                 HTMLEngine *e,
+                 gpointer data)
+{
+	ReselectData *d = (ReselectData *) data;
+	gint len = 0;
+
+	if (o == d->i->from.object)
+		d->in = TRUE;
+	if (d->in)
+		len = html_interval_get_length (d->i, o);
+
+	if (len || (d->in && html_object_is_container (o)))
+		html_object_select_range (o, e,
+					  html_interval_get_start (d->i, o), len,
+					  !html_engine_frozen (e));
+	else if (o->selected && !html_object_is_container (o))
+		html_object_select_range (o, e, 0, 0, !html_engine_frozen (e));
+
+	if (o == d->i->to.object)
+		d->in = FALSE;
+}
+
+static void
+reselect_span (HTMLInterval *i,
+               HTMLPoint *a,
+               HTMLPoint *b,
+               gboolean in,
+               HTMLEngine *e)
+{
+	ReselectData d;
+	HTMLInterval *span;
+	HTMLPoint *max;
+
+	if (html_point_eq (a, b))
+		return;
+
+	max = html_point_max (a, b);
+	span = html_interval_new_from_points (max == a ? b : a, max);
+	d.i = i;
+	d.in = in;
+	html_interval_forall (span, e, reselect_object, &d);
+	html_interval_destroy (span);
+}
+
+static gboolean
+html_point_before (HTMLPoint *a,
+                   HTMLPoint *b)
+{
+	return !html_point_eq (a, b) && html_point_max (a, b) == b;
+}
+
+/* Changes the selection from interval OLD_I to interval I by walking only
+ * the objects between their start points and between their end points,
+ * the objects in between keep their selection.  Returns FALSE when the
+ * intervals don't overlap and nothing was done. */
+gboolean
+html_interval_reselect (HTMLInterval *old_i,
+                        HTMLInterval *i,
+                        HTMLEngine *e)
+{
+	g_return_val_if_fail (old_i != NULL, FALSE);
+	g_return_val_if_fail (i != NULL, FALSE);
+
+	if (html_point_before (&i->to, &old_i->from) || html_point_before (&old_i->to, &i->from))
+		return FALSE;
+
+	i = html_interval_flat (i);
+	reselect_span (i, &old_i->from, &i->from, FALSE, e);
+	reselect_span (i, &old_i->to, &i->to, TRUE, e);
+	html_interval_destroy (i);
+
+	return TRUE;
+}
+
 gint
 html_interval_get_from_index (HTMLInterval *i)
 {
@@ -347,16 +428,21 @@ static HTMLObject *
 html_object_children_max (HTMLObject *a,
                           HTMLObject *b)
 {
-	HTMLObject *o;
+	HTMLObject *oa, *ob;
 
 	g_return_val_if_fail (a->parent, NULL);
 	g_return_val_if_fail (b->parent, NULL);
 	g_return_val_if_fail (a->parent == b->parent, NULL);
 
-	for (o = a; o; o = html_object_next_not_slave (o))
-		if (o == b)
+	/* walk from both sides, so that the cost depends on the distance
+	 * between a and b and not on the number of siblings after them */
+	for (oa = a, ob = b; oa && ob; oa = html_object_next_not_slave (oa), ob = html_object_next_not_slave (ob)) {
+		if (oa == b)
 			return b;
-	return a;
+		if (ob == a)
+			return a;
+	}
+	return oa ? b : a;
 }
 
 HTMLPoint *
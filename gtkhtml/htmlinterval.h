@@ -76,6 +76,9 @@ void          html_interval_select           (HTMLInterval          *i,
 					      HTMLEngine            *e);
 void          html_interval_unselect         (HTMLInterval          *i,
 					      HTMLEngine            *e);
+gboolean      html_interval_reselect         (HTMLInterval          *old_i,
+					      HTMLInterval          *i,
+					      HTMLEngine            *e);
 gint          html_interval_get_from_index   (HTMLInterval          *i);
 gint          html_interval_get_to_index     (HTMLInterval          *i);
 void          html_interval_forall           (HTMLInterval          *i,
@@ -611,6 +611,16 @@ check_page_split (HTMLObject *self,
 	return 0;
 }
 
+static void
+add_page_split_ranges (HTMLObject *self,
+                       HTMLPainter *p,
+                       gint y,
+                       GArray *ranges)
+{
+	/* only above the object */
+	html_object_add_page_split_range (ranges, y + 1, y + self->ascent + self->descent - 1);
+}
+
 static gboolean
 search (HTMLObject *self,
         HTMLSearch *info)
@@ -878,6 +888,7 @@ html_object_class_init (HTMLObjectClass *klass,
 	klass->save = save;
 	klass->save_plain = save_plain;
 	klass->check_page_split = check_page_split;
+	klass->add_page_split_ranges = add_page_split_ranges;
 	klass->search = search;
 	klass->search_next = search;
 	klass->get_length = get_length;
@@ -1568,6 +1579,98 @@ html_object_check_page_split (HTMLObject *self,
 	return (* HO_CLASS (self)->check_page_split) (self, p, y);
 }
 
+void
+html_object_add_page_split_ranges (HTMLObject *self,
+                                   HTMLPainter *p,
+                                   gint y,
+                                   GArray *ranges)
+{
+	g_return_if_fail (self != NULL);
+	g_return_if_fail (ranges != NULL);
+
+	(* HO_CLASS (self)->add_page_split_ranges) (self, p, y, ranges);
+}
+
+void
+html_object_add_page_split_range (GArray *ranges,
+                                  gint first,
+                                  gint last)
+{
+	HTMLPageSplitRange range;
+
+	if (first > last)
+		return;
+
+	range.first = first;
+	range.last = last;
+	g_array_append_val (ranges, range);
+}
+
+static gint
+page_split_range_compare (gconstpointer a,
+                          gconstpointer b)
+{
+	const HTMLPageSplitRange *ra = a, *rb = b;
+
+	return ra->first < rb->first ? -1 : ra->first > rb->first;
+}
+
+/* Collects the page split ranges of the whole tree in one pass, sorted and
+ * merged, so that each page split is then found by a binary search instead
+ * of a walk from the top of the document. */
+GArray *
+html_object_get_page_split_index (HTMLObject *self,
+                                  HTMLPainter *p)
+{
+	GArray *ranges;
+	guint i, n;
+
+	g_return_val_if_fail (self != NULL, NULL);
+
+	ranges = g_array_new (FALSE, FALSE, sizeof (HTMLPageSplitRange));
+	html_object_add_page_split_ranges (self, p, 0, ranges);
+	g_array_sort (ranges, page_split_range_compare);
+
+	for (i = 0, n = 0; i < ranges->len; i++) {
+		HTMLPageSplitRange *range = &g_array_index (ranges, HTMLPageSplitRange, i);
+		HTMLPageSplitRange *last = n ? &g_array_index (ranges, HTMLPageSplitRange, n - 1) : NULL;
+
+		if (last && range->first <= last->last + 1)
+			last->last = MAX (last->last, range->last);
+		else
+			g_array_index (ranges, HTMLPageSplitRange, n++) = *range;
+	}
+	g_array_set_size (ranges, n);
+
+	return ranges;
+}
+
+/* Returns the same position as html_object_check_page_split () on the
+ * object the index was made for. */
+gint
+html_object_check_page_split_index (GArray *index,
+                                    gint y)
+{
+	gint low = 0, high;
+
+	g_return_val_if_fail (index != NULL, y);
+
+	high = index->len;
+	while (low < high) {
+		gint mid = (low + high) / 2;
+		HTMLPageSplitRange *range = &g_array_index (index, HTMLPageSplitRange, mid);
+
+		if (y < range->first)
+			high = mid;
+		else if (y > range->last)
+			low = mid + 1;
+		else
+			return range->first - 1;
+	}
+
+	return y;
+}
+
 void
 html_object_change_set (HTMLObject *self,
                         HTMLChangeFlags f)
@@ -1579,6 +1682,8 @@ html_object_change_set (HTMLObject *self,
 	if (f != HTML_CHANGE_NONE) {
 		while (obj) {
 			obj->change |= f;
+			if (html_object_is_clue (obj) || HTML_OBJECT_TYPE (obj) == HTML_TYPE_CLUEH)
+				HTML_CLUE (obj)->recursive_length = -1;
 			obj = obj->parent;
 		}
 	}
@@ -1649,6 +1754,24 @@ html_object_get_recursive_length (HTMLObject *self)
 	return (* HO_CLASS (self)->get_recursive_length) (self);
 }
 
+/**
+ * html_object_invalidate_recursive_length:
+ * @self: An HTMLObject.
+ *
+ * Drop the recursive lengths cached on the clues containing @self.  Has
+ * to be called whenever the length of @self or the set of its siblings
+ * changes; html_object_change_set () does it as well.
+ **/
+void
+html_object_invalidate_recursive_length (HTMLObject *self)
+{
+	HTMLObject *obj;
+
+	for (obj = self; obj; obj = obj->parent)
+		if (html_object_is_clue (obj) || HTML_OBJECT_TYPE (obj) == HTML_TYPE_CLUEH)
+			HTML_CLUE (obj)->recursive_length = -1;
+}
+
 HTMLObject *
 html_object_next_by_type (HTMLObject *self,
                           HTMLType t)
@@ -1975,6 +2098,36 @@ html_object_get_bytes (HTMLObject *self)
 	return html_object_is_text (self) ? html_text_get_bytes (HTML_TEXT (self)) : html_object_get_length (self);
 }
 
+static void
+add_memory_size (HTMLObject *o,
+                 HTMLEngine *e,
+                 gpointer data)
+{
+	gsize *size = (gsize *) data;
+
+	*size += o->klass->object_size;
+
+	if (html_object_is_text (o)) {
+		HTMLText *text = HTML_TEXT (o);
+
+		*size += text->text_bytes + 1;
+		if (text->spell_errors)
+			*size += text->spell_errors->len * sizeof (SpellError);
+		*size += html_text_get_n_links (text) * (sizeof (Link) + sizeof (gpointer));
+	}
+}
+
+/* approximate heap size of the object subtree, used for undo accounting */
+gsize
+html_object_get_memory_size (HTMLObject *self)
+{
+	gsize size = 0;
+
+	html_object_forall (self, NULL, add_memory_size, &size);
+
+	return size;
+}
+
 guint
 html_object_get_index (HTMLObject *self,
                        guint offset)
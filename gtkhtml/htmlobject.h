@@ -82,6 +82,12 @@ struct _HTMLObjectClearRectangle {
 	gint height;
 };
 
+/* Positions FIRST to LAST, inclusive, at which a page must not be split.  */
+struct _HTMLPageSplitRange {
+	gint first;
+	gint last;
+};
+
 struct _HTMLObjectClass {
 	HTMLType type;
 
@@ -229,6 +235,11 @@ struct _HTMLObjectClass {
 
 	gint (* check_page_split) (HTMLObject *self, HTMLPainter *p, gint y);
 
+	/* Appends the HTMLPageSplitRanges of the object, placed with its top
+	 * at Y, to RANGES.  The positions left out are the ones
+	 * check_page_split returns unchanged.  */
+	void (* add_page_split_ranges) (HTMLObject *self, HTMLPainter *p, gint y, GArray *ranges);
+
 	/* Selection.  */
 	gboolean (* select_range) (HTMLObject *self, HTMLEngine *engine, guint start, gint length,
 				   gboolean queue_draw);
@@ -450,7 +461,9 @@ guint           html_object_get_line_length       (HTMLObject            *self,
 						   HTMLPainter           *p,
 						   gint                   line_offset);
 guint           html_object_get_recursive_length  (HTMLObject            *self);
+void            html_object_invalidate_recursive_length (HTMLObject      *self);
 guint           html_object_get_bytes             (HTMLObject            *self);
+gsize           html_object_get_memory_size       (HTMLObject            *self);
 guint           html_object_get_index             (HTMLObject            *self,
 						   guint                  offset);
 HTMLObject     *html_object_check_point           (HTMLObject            *clue,
@@ -514,6 +527,17 @@ GdkRectangle   *html_object_get_bounds            (HTMLObject            *o,
 gint  html_object_check_page_split  (HTMLObject  *self,
 				     HTMLPainter *p,
 				     gint         y);
+void  html_object_add_page_split_ranges  (HTMLObject  *self,
+					  HTMLPainter *p,
+					  gint         y,
+					  GArray      *ranges);
+void  html_object_add_page_split_range   (GArray      *ranges,
+					  gint         first,
+					  gint         last);
+GArray *html_object_get_page_split_index (HTMLObject  *self,
+					  HTMLPainter *p);
+gint  html_object_check_page_split_index (GArray      *index,
+					  gint         y);
 
 /* Selection.  */
 gboolean    html_object_select_range             (HTMLObject *self,
@@ -950,6 +950,102 @@ html_painter_draw_spell_error (HTMLPainter *painter,
 	return klass->draw_spell_error (painter, x, y, width);
 }
 
+/* Measuring a font itemizes and shapes several strings, which dominates
+ * layout of documents switching faces often.  The metrics only depend on
+ * the font description and the context they are measured in, so they are
+ * shared by all painters and kept across magnification changes. */
+
+typedef struct {
+	gint space_width;
+	gint space_asc;
+	gint space_dsc;
+	guint nbsp_width;
+	guint tab_width;
+	guint e_width;
+	guint indent_width;
+	guint cite_width_ltr;
+	guint cite_width_rtl;
+} FontMetrics;
+
+#define FONT_METRICS_MAX 1024
+
+static GHashTable *font_metrics = NULL;
+G_LOCK_DEFINE_STATIC (font_metrics);
+
+static gchar *
+font_metrics_key (HTMLPainter *painter,
+                  PangoFontDescription *desc)
+{
+	const cairo_font_options_t *options;
+	gchar *desc_str, *key;
+
+	options = pango_cairo_context_get_font_options (painter->pango_context);
+	desc_str = pango_font_description_to_string (desc);
+	key = g_strdup_printf ("%p %s %g %lx %g %s",
+			       (gpointer) pango_context_get_font_map (painter->pango_context),
+			       pango_language_to_string (pango_context_get_language (painter->pango_context)),
+			       pango_cairo_context_get_resolution (painter->pango_context),
+			       options ? cairo_font_options_hash (options) : 0,
+			       painter->engine_to_pango, desc_str);
+	g_free (desc_str);
+
+	return key;
+}
+
+static void
+font_metrics_measure (HTMLPainter *painter,
+                      PangoFontDescription *desc,
+                      FontMetrics *metrics)
+{
+	text_size (painter, desc, " ", 1, NULL, NULL, &metrics->space_width, &metrics->space_asc, &metrics->space_dsc);
+
+	metrics->nbsp_width = text_width (painter, desc, "\xc2\xa0", 2);
+	metrics->tab_width = text_width (painter, desc, "\t", 1);
+	metrics->e_width = text_width (painter, desc, "e", 1);
+	metrics->indent_width = text_width (painter, desc, HTML_BLOCK_INDENT, strlen (HTML_BLOCK_INDENT));
+	metrics->cite_width_ltr = text_width (painter, desc, HTML_BLOCK_CITE_LTR, strlen (HTML_BLOCK_CITE_LTR));
+	metrics->cite_width_rtl = text_width (painter, desc, HTML_BLOCK_CITE_RTL, strlen (HTML_BLOCK_CITE_RTL));
+}
+
+static void
+font_metrics_get (HTMLPainter *painter,
+                  PangoFontDescription *desc,
+                  FontMetrics *metrics)
+{
+	FontMetrics *cached;
+	gchar *key;
+
+	if (!painter->pango_context) {
+		font_metrics_measure (painter, desc, metrics);
+		return;
+	}
+
+	key = font_metrics_key (painter, desc);
+
+	G_LOCK (font_metrics);
+	if (!font_metrics)
+		font_metrics = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+	cached = g_hash_table_lookup (font_metrics, key);
+	if (cached)
+		*metrics = *cached;
+	G_UNLOCK (font_metrics);
+
+	if (cached) {
+		g_free (key);
+		return;
+	}
+
+	font_metrics_measure (painter, desc, metrics);
+	cached = g_new (FontMetrics, 1);
+	*cached = *metrics;
+
+	G_LOCK (font_metrics);
+	if (g_hash_table_size (font_metrics) >= FONT_METRICS_MAX)
+		g_hash_table_remove_all (font_metrics);
+	g_hash_table_insert (font_metrics, key, cached);
+	G_UNLOCK (font_metrics);
+}
+
 HTMLFont *
 html_painter_alloc_font (HTMLPainter *painter,
                          gchar *face,
@@ -958,7 +1054,7 @@ html_painter_alloc_font (HTMLPainter *painter,
                          GtkHTMLFontStyle style)
 {
 	PangoFontDescription *desc = NULL;
-	gint space_width, space_asc, space_dsc;
+	FontMetrics metrics;
 
 	if (face) {
 		desc = pango_font_description_from_string (face);
@@ -988,17 +1084,17 @@ html_painter_alloc_font (HTMLPainter *painter,
 	pango_font_description_set_style (desc, style & GTK_HTML_FONT_STYLE_ITALIC ? PANGO_STYLE_ITALIC : PANGO_STYLE_NORMAL);
 	pango_font_description_set_weight (desc, style & GTK_HTML_FONT_STYLE_BOLD ? PANGO_WEIGHT_BOLD : PANGO_WEIGHT_NORMAL);
 
-	text_size (painter, desc, " ", 1, NULL, NULL, &space_width, &space_asc, &space_dsc);
+	font_metrics_get (painter, desc, &metrics);
 
 	return html_font_new (desc,
-			      space_width,
-			      space_asc, space_dsc,
-			      text_width (painter, desc, "\xc2\xa0", 2),
-			      text_width (painter, desc, "\t", 1),
-			      text_width (painter, desc, "e", 1),
-			      text_width (painter, desc, HTML_BLOCK_INDENT, strlen (HTML_BLOCK_INDENT)),
-			      text_width (painter, desc, HTML_BLOCK_CITE_LTR, strlen (HTML_BLOCK_CITE_LTR)),
-			      text_width (painter, desc, HTML_BLOCK_CITE_RTL, strlen (HTML_BLOCK_CITE_RTL)));
+			      metrics.space_width,
+			      metrics.space_asc, metrics.space_dsc,
+			      metrics.nbsp_width,
+			      metrics.tab_width,
+			      metrics.e_width,
+			      metrics.indent_width,
+			      metrics.cite_width_ltr,
+			      metrics.cite_width_rtl);
 }
 
 void
@@ -40,11 +40,23 @@
 
 G_DEFINE_TYPE (HTMLPrinter, html_printer, HTML_TYPE_PAINTER);
 
+static cairo_t *
+printer_get_cairo_context (HTMLPrinter *printer)
+{
+	if (printer->context == NULL)
+		return printer->cr;
+
+	return gtk_print_context_get_cairo_context (printer->context);
+}
+
 static gdouble
 printer_get_page_height (HTMLPrinter *printer)
 {
 	GtkPageSetup *page_setup;
 
+	if (printer->context == NULL)
+		return printer->page_height;
+
 	page_setup = gtk_print_context_get_page_setup (printer->context);
 	return gtk_page_setup_get_page_height (page_setup, GTK_UNIT_POINTS);
 }
@@ -54,6 +66,9 @@ printer_get_page_width (HTMLPrinter *printer)
 {
 	GtkPageSetup *page_setup;
 
+	if (printer->context == NULL)
+		return printer->page_width;
+
 	page_setup = gtk_print_context_get_page_setup (printer->context);
 	return gtk_page_setup_get_page_width (page_setup, GTK_UNIT_POINTS);
 }
@@ -80,6 +95,11 @@ finalize (GObject *object)
 		printer->context = NULL;
 	}
 
+	if (printer->cr != NULL) {
+		cairo_destroy (printer->cr);
+		printer->cr = NULL;
+	}
+
 	G_OBJECT_CLASS (html_printer_parent_class)->finalize (object);
 }
 
@@ -92,7 +112,6 @@ begin (HTMLPainter *painter,
        gint y2)
 {
 	HTMLPrinter *printer;
-	GtkPrintContext *pc;
 	gdouble printer_x1, printer_y1;
 	gdouble printer_x2, printer_y2;
 	cairo_t *cr;
@@ -101,10 +120,9 @@ begin (HTMLPainter *painter,
 #endif
 	printer = HTML_PRINTER (painter);
 	g_return_if_fail (printer);
-	pc      = printer->context;
-	g_return_if_fail (pc);
+	g_return_if_fail (printer->context != NULL || printer->cr != NULL);
 
-	cr = gtk_print_context_get_cairo_context (pc);
+	cr = printer_get_cairo_context (printer);
 	cairo_save (cr);
 
 	printer_x1 = SCALE_ENGINE_TO_GNOME_PRINT (x1);
@@ -160,9 +178,9 @@ set_pen (HTMLPainter *painter,
 	cairo_t *cr;
 
 	printer = HTML_PRINTER (painter);
-	g_return_if_fail (printer->context != NULL);
+	g_return_if_fail (printer->context != NULL || printer->cr != NULL);
 
-	cr = gtk_print_context_get_cairo_context (printer->context);
+	cr = printer_get_cairo_context (printer);
 	cairo_set_source_rgb (cr, color->red / 65535.0, color->green / 65535.0, color->blue / 65535.0);
 }
 
@@ -182,7 +200,6 @@ prepare_rectangle (HTMLPainter *painter,
                    gint h)
 {
 	HTMLPrinter *printer = HTML_PRINTER (painter);
-	GtkPrintContext *context = printer->context;
 	gdouble x;
 	gdouble y;
 	gdouble width;
@@ -193,7 +210,7 @@ prepare_rectangle (HTMLPainter *painter,
 	height = SCALE_ENGINE_TO_GNOME_PRINT (h);
 	x = SCALE_ENGINE_TO_GNOME_PRINT (_x);
 	y = SCALE_ENGINE_TO_GNOME_PRINT (_y);
-	cr = gtk_print_context_get_cairo_context (context);
+	cr = printer_get_cairo_context (printer);
 	cairo_new_path (cr);
 	cairo_rectangle (cr, x, y, x + width, y + height);
 	cairo_close_path (cr);
@@ -208,10 +225,9 @@ do_rectangle (HTMLPainter *painter,
               gint lw)
 {
 	HTMLPrinter *printer = HTML_PRINTER (painter);
-	GtkPrintContext *context = printer->context;
 	cairo_t *cr;
 
-	cr = gtk_print_context_get_cairo_context (context);
+	cr = printer_get_cairo_context (printer);
 	cairo_set_line_width (cr, SCALE_ENGINE_TO_GNOME_PRINT (lw) * PIXEL_SIZE);
 	prepare_rectangle (painter,x, y, w, h);
 	cairo_stroke (cr);
@@ -226,7 +242,7 @@ set_clip_rectangle (HTMLPainter *painter,
 {
 	cairo_t *cr;
 	prepare_rectangle (painter, x, y, width, height);
-	cr = gtk_print_context_get_cairo_context (HTML_PRINTER (painter)->context);
+	cr = printer_get_cairo_context (HTML_PRINTER (painter));
 	cairo_clip (cr);
 }
 
@@ -245,14 +261,14 @@ draw_line (HTMLPainter *painter,
 	cairo_t *cr;
 
 	printer = HTML_PRINTER (painter);
-	g_return_if_fail (printer->context != NULL);
+	g_return_if_fail (printer->context != NULL || printer->cr != NULL);
 
 	printer_x1 = SCALE_ENGINE_TO_GNOME_PRINT (x1);
 	printer_y1 = SCALE_ENGINE_TO_GNOME_PRINT (y1);
 	printer_x2 = SCALE_ENGINE_TO_GNOME_PRINT (x2);
 	printer_y2 = SCALE_ENGINE_TO_GNOME_PRINT (y2);
 
-	cr = gtk_print_context_get_cairo_context (printer->context);
+	cr = printer_get_cairo_context (printer);
 	cairo_set_line_width (cr, PIXEL_SIZE);
 
 	cairo_new_path (cr);
@@ -282,7 +298,6 @@ draw_border (HTMLPainter *painter,
              gint bordersize)
 {
 	HTMLPrinter *printer = HTML_PRINTER (painter);
-	GtkPrintContext *pc = printer->context;
 	GdkColor *col1 = NULL, *col2 = NULL;
 	GdkColor dark, light;
 	gdouble x;
@@ -327,7 +342,7 @@ draw_border (HTMLPainter *painter,
 	x = SCALE_ENGINE_TO_GNOME_PRINT (_x);
 	y = SCALE_ENGINE_TO_GNOME_PRINT (_y);
 
-	cr = gtk_print_context_get_cairo_context (pc);
+	cr = printer_get_cairo_context (printer);
 	if (col2)
 		cairo_set_source_rgb (cr, col1->red / 65535.0, col1->green / 65535.0, col1->blue / 65535.0);
 	cairo_new_path (cr);
@@ -365,15 +380,13 @@ draw_background (HTMLPainter *painter,
                  gint tile_x,
                  gint tile_y)
 {
-	GtkPrintContext *pc;
 	HTMLPrinter *printer;
 	gdouble x, y, width, height;
 	cairo_t *cr;
 
 	printer = HTML_PRINTER (painter);
 	g_return_if_fail (printer);
-	pc = printer->context;
-	g_return_if_fail (printer->context);
+	g_return_if_fail (printer->context != NULL || printer->cr != NULL);
 
 	width = SCALE_ENGINE_TO_GNOME_PRINT  (pix_width);
 	height = SCALE_ENGINE_TO_GNOME_PRINT (pix_height);
@@ -381,7 +394,7 @@ draw_background (HTMLPainter *painter,
 	y = SCALE_ENGINE_TO_GNOME_PRINT (iy);
 
 	if (color) {
-		cr = gtk_print_context_get_cairo_context (pc);
+		cr = printer_get_cairo_context (printer);
 		cairo_save (cr);
 		cairo_set_source_rgb (cr, color->red / 65535.0, color->green / 65535.0, color->blue / 65535.0);
 		cairo_new_path (cr);
@@ -393,14 +406,12 @@ draw_background (HTMLPainter *painter,
 }
 
 static void
-print_pixbuf (GtkPrintContext *pc,
+print_pixbuf (cairo_t *cr,
               GdkPixbuf *pixbuf)
 {
-	cairo_t *cr;
 	if (!pixbuf || (gdk_pixbuf_get_colorspace (pixbuf) != GDK_COLORSPACE_RGB))
 		return;
 
-	cr = gtk_print_context_get_cairo_context (pc);
 	if (gdk_pixbuf_get_has_alpha (pixbuf)) {
 		gdk_cairo_set_source_pixbuf (cr, pixbuf, 0, 0);
 		cairo_rectangle (cr, 0, 0, (double) gdk_pixbuf_get_width (pixbuf), (double) gdk_pixbuf_get_height (pixbuf));                 cairo_clip (cr);
@@ -429,8 +440,8 @@ draw_pixmap (HTMLPainter *painter,
 	cairo_t *cr;
 
 	printer = HTML_PRINTER (painter);
-	g_return_if_fail (printer->context != NULL);
-	cr = gtk_print_context_get_cairo_context (printer->context);
+	g_return_if_fail (printer->context != NULL || printer->cr != NULL);
+	cr = printer_get_cairo_context (printer);
 	print_x = SCALE_ENGINE_TO_GNOME_PRINT (x);
 	print_y = SCALE_ENGINE_TO_GNOME_PRINT (y);
 	print_scale_width  = SCALE_ENGINE_TO_GNOME_PRINT (scale_width);
@@ -438,7 +449,7 @@ draw_pixmap (HTMLPainter *painter,
 	cairo_save (cr);
 	cairo_translate (cr, print_x, print_y);
 	cairo_scale (cr, print_scale_width / (double) gdk_pixbuf_get_width (pixbuf), print_scale_height / (double) gdk_pixbuf_get_height (pixbuf));
-	print_pixbuf (printer->context, pixbuf);
+	print_pixbuf (cr, pixbuf);
 	cairo_restore (cr);
 }
 
@@ -455,7 +466,7 @@ fill_rect (HTMLPainter *painter,
 	cairo_t *cr;
 
 	printer = HTML_PRINTER (painter);
-	g_return_if_fail (printer->context != NULL);
+	g_return_if_fail (printer->context != NULL || printer->cr != NULL);
 
 	printer_width = SCALE_ENGINE_TO_GNOME_PRINT (width);
 	printer_height = SCALE_ENGINE_TO_GNOME_PRINT (height);
@@ -463,7 +474,7 @@ fill_rect (HTMLPainter *painter,
 	printer_x = SCALE_ENGINE_TO_GNOME_PRINT (x);
 	printer_y = SCALE_ENGINE_TO_GNOME_PRINT (y);
 
-	cr = gtk_print_context_get_cairo_context (printer->context);
+	cr = printer_get_cairo_context (printer);
 	cairo_new_path (cr);
 	cairo_rectangle (cr, printer_x, printer_y, printer_width, printer_height);
 	cairo_close_path (cr);
@@ -487,7 +498,7 @@ draw_lines (HTMLPrinter *printer,
 		return;
 
 	metrics = pango_font_get_metrics (analysis->font, analysis->language);
-	cr = gtk_print_context_get_cairo_context (printer->context);
+	cr = printer_get_cairo_context (printer);
 	cairo_set_line_cap (cr, CAIRO_LINE_CAP_BUTT);
 
 	width = pango_units_to_double (log_rect.width);
@@ -535,7 +546,7 @@ draw_glyphs (HTMLPainter *painter,
 	print_x = SCALE_ENGINE_TO_GNOME_PRINT (x);
 	print_y = SCALE_ENGINE_TO_GNOME_PRINT (y);
 
-	cr = gtk_print_context_get_cairo_context (printer->context);
+	cr = printer_get_cairo_context (printer);
 
 	cairo_save (cr);
 
@@ -589,7 +600,7 @@ draw_embedded (HTMLPainter *p,
 	print_x = SCALE_ENGINE_TO_GNOME_PRINT (x);
 	print_y = SCALE_ENGINE_TO_GNOME_PRINT (y);
 
-	cr = gtk_print_context_get_cairo_context (printer->context);
+	cr = printer_get_cairo_context (printer);
 	cairo_save (cr);
 	cairo_translate (cr,
 			print_x, print_y + o->height * PIXEL_SIZE);
@@ -611,7 +622,7 @@ draw_shade_line (HTMLPainter *painter,
 	HTMLPrinter *printer;
 
 	printer = HTML_PRINTER (painter);
-	g_return_if_fail (printer->context != NULL);
+	g_return_if_fail (printer->context != NULL || printer->cr != NULL);
 
 	/* FIXME */
 }
@@ -705,6 +716,77 @@ html_printer_new (GtkWidget *widget,
 
 }
 
+/* Creates a printer drawing straight to CR, for output which is not driven
+ * by a GtkPrintOperation.  The pango context gets its own font map, so
+ * printers for different documents may draw from different threads. */
+HTMLPainter *
+html_printer_new_for_cairo (GtkWidget *widget,
+                            cairo_t *cr,
+                            gdouble page_width,
+                            gdouble page_height)
+{
+	GtkStyleContext *style_context;
+	const PangoFontDescription *font_desc;
+	cairo_font_options_t *options;
+	PangoFontMap *font_map;
+	HTMLPrinter *printer;
+	HTMLPainter *painter;
+
+	g_return_val_if_fail (cr != NULL, NULL);
+
+	printer = g_object_new (HTML_TYPE_PRINTER, NULL);
+	printer->cr = cairo_reference (cr);
+	printer->page_width = page_width;
+	printer->page_height = page_height;
+
+	painter = HTML_PAINTER (printer);
+	html_painter_set_widget (painter, widget);
+
+	style_context = gtk_widget_get_style_context (widget);
+	font_desc = gtk_style_context_get_font (style_context, GTK_STATE_FLAG_NORMAL);
+
+	/* the same setup gtk_print_context_create_pango_context () does */
+	font_map = pango_cairo_font_map_new ();
+	painter->pango_context = pango_font_map_create_context (font_map);
+	g_object_unref (font_map);
+
+	options = cairo_font_options_create ();
+	cairo_font_options_set_hint_metrics (options, CAIRO_HINT_METRICS_OFF);
+	pango_cairo_context_set_font_options (painter->pango_context, options);
+	cairo_font_options_destroy (options);
+
+	pango_cairo_context_set_resolution (painter->pango_context, 72.0);
+	pango_context_set_font_description (
+		painter->pango_context, font_desc);
+
+	return painter;
+}
+
+/* Makes a printer made by html_printer_new_for_cairo () draw to CR from
+ * now on, with the same page size. */
+void
+html_printer_set_cairo_context (HTMLPrinter *printer,
+                                cairo_t *cr)
+{
+	g_return_if_fail (HTML_IS_PRINTER (printer));
+	g_return_if_fail (printer->context == NULL);
+	g_return_if_fail (cr != NULL);
+
+	cairo_reference (cr);
+	if (printer->cr != NULL)
+		cairo_destroy (printer->cr);
+	printer->cr = cr;
+}
+
+/* Returns the cairo context the printer currently draws to. */
+cairo_t *
+html_printer_get_cairo_context (HTMLPrinter *printer)
+{
+	g_return_val_if_fail (HTML_IS_PRINTER (printer), NULL);
+
+	return printer_get_cairo_context (printer);
+}
+
 
 guint
 html_printer_get_page_width (HTMLPrinter *printer)
@@ -45,6 +45,11 @@ struct _HTMLPrinter {
 
 	GtkPrintContext *context;
 	gdouble scale;
+
+	/* used instead of the print context when it is NULL */
+	cairo_t *cr;
+	gdouble page_width;
+	gdouble page_height;
 };
 
 struct _HTMLPrinterClass {
@@ -54,6 +59,13 @@ struct _HTMLPrinterClass {
 GType      html_printer_get_type                    (void);
 HTMLPainter *html_printer_new                         (GtkWidget         *widget,
 						       GtkPrintContext *context);
+HTMLPainter *html_printer_new_for_cairo               (GtkWidget         *widget,
+						       cairo_t           *cr,
+						       gdouble            page_width,
+						       gdouble            page_height);
+void         html_printer_set_cairo_context           (HTMLPrinter       *printer,
+						       cairo_t           *cr);
+cairo_t     *html_printer_get_cairo_context           (HTMLPrinter       *printer);
 guint        html_printer_get_page_width              (HTMLPrinter       *printer);
 guint        html_printer_get_page_height             (HTMLPrinter       *printer);
 gdouble      html_printer_scale_to_gnome_print        (HTMLPrinter       *printer,
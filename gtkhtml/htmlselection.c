@@ -35,96 +35,19 @@ optimize_selection (HTMLEngine *e,
                     HTMLInterval *i)
 {
 	HTMLInterval *s = e->selection;
-	gboolean optimized = FALSE;
 
 	g_return_val_if_fail (s, FALSE);
 
 	/* printf ("change selection (%3d,%3d) --> (%3d,%3d)\n",
 	 * s->from.offset, s->to.offset,
 	 * i->from.offset, i->to.offset); */
-	if (html_point_eq (&i->from, &s->from)) {
-		HTMLPoint *max;
-
-		max = html_point_max (&i->to, &s->to);
-		if (max) {
-			if (max == &i->to) {
-				HTMLInterval *sel;
-
-				/* printf ("optimize 1\n"); */
-				sel = html_interval_new (s->to.object, i->to.object,
-							 i->from.object == s->to.object
-							 ? i->from.offset : (html_object_is_container (s->to.object) ? s->to.offset : 0), i->to.offset);
-				html_interval_select (sel, e);
-				html_interval_destroy (sel);
-				html_interval_destroy (s);
-				e->selection = i;
-				optimized = TRUE;
-			} else {
-				HTMLInterval *usel;
-
-				/* printf ("optimize 2\n"); */
-				usel = html_interval_new (i->to.object, s->to.object,
-							  html_object_is_container (i->to.object) ? i->to.offset : 0, s->to.offset);
-				html_interval_unselect (usel, e);
-				if (!html_object_is_container (i->to.object) && i->to.offset) {
-					gint from = i->from.object == i->to.object ? i->from.offset : 0;
-					html_object_select_range (i->to.object, e,
-								  from, i->to.offset - from,
-								  !html_engine_frozen (e));
-				}
-				html_interval_destroy (usel);
-				html_interval_destroy (s);
-				e->selection = i;
-				optimized = TRUE;
-			}
-		}
-	} else if (html_point_eq (&i->to, &s->to)) {
-		HTMLPoint *min;
-
-		min = html_point_min (&i->from, &s->from);
-		if (min) {
-			if (min == &i->from) {
-				HTMLInterval *sel;
-
-				/* printf ("optimize 3\n"); */
-				sel = html_interval_new (i->from.object, s->from.object,
-							 i->from.offset,
-							 i->to.object == s->from.object
-							 ? i->to.offset
-							 : (html_object_is_container (s->from.object) ? s->from.offset : html_object_get_length (s->from.object)));
-				html_interval_select (sel, e);
-				html_interval_destroy (sel);
-				html_interval_destroy (s);
-				e->selection = i;
-				optimized = TRUE;
-			} else {
-				HTMLInterval *usel;
-
-				/* printf ("optimize 4\n"); */
-				usel = html_interval_new (s->from.object, i->from.object,
-							  s->from.offset,
-							  html_object_is_container (i->from.object) ? i->from.offset : html_object_get_length (i->from.object));
-				html_interval_unselect (usel, e);
-				if (!html_object_is_container (i->from.object) && i->from.offset != html_object_get_length (i->from.object)) {
-					gint to = i->to.object == i->from.object
-						? s->to.offset
-						: html_object_get_length (i->from.object);
-					html_object_select_range (i->from.object, e,
-								  i->from.offset, to - i->from.offset,
-								  !html_engine_frozen (e));
-				}
-				html_interval_destroy (usel);
-				html_interval_destroy (s);
-				e->selection = i;
-				optimized = TRUE;
-			}
-		}
-	}
+	if (!html_interval_reselect (s, i, e))
+		return FALSE;
 
-	/* if (optimized)
-	 * printf ("Optimized\n"); */
+	html_interval_destroy (s);
+	e->selection = i;
 
-	return optimized;
+	return TRUE;
 }
 
 static void
@@ -361,6 +361,7 @@ remove_cell (HTMLTable *t,
 			t->cells[cell->row + r][cell->col + c] = NULL;
 		}
 	HTML_OBJECT (cell)->parent = NULL;
+	html_object_invalidate_recursive_length (HTML_OBJECT (t));
 }
 
 static HTMLObject *
@@ -1052,6 +1053,7 @@ html_table_set_cell (HTMLTable *table,
 #endif
 		table->cells[r][c] = cell;
 		HTML_OBJECT (cell)->parent = HTML_OBJECT (table);
+		html_object_invalidate_recursive_length (HTML_OBJECT (table));
 	}
 }
 
@@ -2408,6 +2410,31 @@ check_page_split (HTMLObject *self,
 	return min_y;
 }
 
+static void
+add_page_split_ranges (HTMLObject *self,
+                       HTMLPainter *painter,
+                       gint y,
+                       GArray *ranges)
+{
+	HTMLTable *table = HTML_TABLE (self);
+	HTMLTableCell *cell;
+	gint r, c;
+
+	/* a split between rows or cells is fine, inside a cell it has to fit
+	 * the cell, and so all the cells it crosses */
+	for (r = 0; r < table->totalRows; r++) {
+		for (c = 0; c < table->totalCols; c++) {
+			cell = table->cells[r][c];
+			if (cell == NULL || cell->row != r || cell->col != c)
+				continue;
+
+			html_object_add_page_split_ranges (
+				HTML_OBJECT (cell), painter,
+				y + HTML_OBJECT (cell)->y - HTML_OBJECT (cell)->ascent, ranges);
+		}
+	}
+}
+
 static GdkColor *
 get_bg_color (HTMLObject *o,
               HTMLPainter *p)
@@ -2463,6 +2490,7 @@ html_table_class_init (HTMLTableClass *klass,
 	object_class->save = save;
 	object_class->save_plain = save_plain;
 	object_class->check_page_split = check_page_split;
+	object_class->add_page_split_ranges = add_page_split_ranges;
 	object_class->get_bg_color = get_bg_color;
 	object_class->get_recursive_length = get_recursive_length;
 	object_class->remove_child = remove_child;
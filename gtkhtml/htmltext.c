@@ -63,18 +63,23 @@ static const PangoAttrClass html_pango_attr_font_size_klass;
 #define EMPTY_GLYPH 0
 #endif
 
-static SpellError * spell_error_new         (guint off, guint len);
-static void         spell_error_destroy     (SpellError *se);
-static void         move_spell_errors       (GList *spell_errors, guint offset, gint delta);
-static GList *      remove_spell_errors     (GList *spell_errors, guint offset, guint len);
-static GList *      merge_spell_errors      (GList *se1, GList *se2);
+static GArray *     spell_errors_new        (guint reserved);
+static GArray *     spell_errors_copy       (GArray *spell_errors);
+static void         move_spell_errors       (GArray *spell_errors, guint offset, gint delta);
+static GArray *     remove_spell_errors     (GArray *spell_errors, guint offset, guint len);
+static GArray *     merge_spell_errors      (GArray *se1, GArray *se2);
 static void         remove_text_slaves      (HTMLObject *self);
 
+#define SPELL_ERROR(se,i) (&g_array_index ((se), SpellError, (i)))
+#define LINK(links,i) ((Link *) g_ptr_array_index ((links), (i)))
+
 /* void
-debug_spell_errors (GList *se)
+debug_spell_errors (GArray *se)
 {
-	for (; se; se = se->next)
-		printf ("SE: %4d, %4d\n", ((SpellError *) se->data)->off, ((SpellError *) se->data)->len);
+	guint i;
+
+	for (i = 0; se && i < se->len; i++)
+		printf ("SE: %4d, %4d\n", SPELL_ERROR (se, i)->off, SPELL_ERROR (se, i)->len);
 } */
 
 static inline gboolean
@@ -128,16 +133,67 @@ pango_info_destroy (HTMLText *text)
 	}
 }
 
+static GPtrArray *
+links_new (guint reserved)
+{
+	return g_ptr_array_new_full (reserved, (GDestroyNotify) html_link_free);
+}
+
 static void
-free_links (GSList *list)
+free_links (GPtrArray *links)
 {
-	if (list) {
-		GSList *l;
+	if (links)
+		g_ptr_array_unref (links);
+}
 
-		for (l = list; l; l = l->next)
-			html_link_free ((Link *) l->data);
-		g_slist_free (list);
+/* returns index of the last link starting at or before offset, -1 if there is none */
+static gint
+links_bsearch_start (GPtrArray *links,
+                     gint offset)
+{
+	guint lo = 0, hi = links ? links->len : 0;
+
+	while (lo < hi) {
+		guint mid = lo + (hi - lo) / 2;
+
+		if (LINK (links, mid)->start_offset <= offset)
+			lo = mid + 1;
+		else
+			hi = mid;
 	}
+
+	return (gint) lo - 1;
+}
+
+/* returns index of the first link ending at or after offset */
+static guint
+links_bsearch_end (GPtrArray *links,
+                   gint offset)
+{
+	guint lo = 0, hi = links ? links->len : 0;
+
+	while (lo < hi) {
+		guint mid = lo + (hi - lo) / 2;
+
+		if (LINK (links, mid)->end_offset < offset)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo;
+}
+
+static gint
+get_link_index_at_offset (HTMLText *text,
+                          gint offset)
+{
+	gint i = links_bsearch_start (text->links, offset);
+
+	if (i >= 0 && offset <= LINK (text->links, i)->end_offset)
+		return i;
+
+	return -1;
 }
 
 void
@@ -152,18 +208,56 @@ html_text_free_attrs (GSList *attrs)
 	}
 }
 
+/* Copies made by html_object_dup () (clipboard, undo, op_copy) share the
+ * text string with the original until either side replaces it. All the
+ * code below builds a new string instead of writing into text->text, so
+ * sharing only needs to be undone when the string is replaced. */
+
+static void
+text_release (HTMLText *text)
+{
+	if (!text->text_ref || g_atomic_int_dec_and_test (text->text_ref)) {
+		g_free (text->text);
+		g_free (text->text_ref);
+	}
+
+	text->text = NULL;
+	text->text_ref = NULL;
+}
+
+/* takes ownership of str */
+static void
+text_take (HTMLText *text,
+           gchar *str)
+{
+	text_release (text);
+	text->text = str;
+}
+
+static void
+text_share (HTMLText *src,
+            HTMLText *dest)
+{
+	if (!src->text_ref) {
+		src->text_ref = g_new (gint, 1);
+		*src->text_ref = 1;
+	}
+
+	g_atomic_int_inc (src->text_ref);
+	dest->text = src->text;
+	dest->text_ref = src->text_ref;
+}
+
 static void
 copy (HTMLObject *s,
       HTMLObject *d)
 {
 	HTMLText *src  = HTML_TEXT (s);
 	HTMLText *dest = HTML_TEXT (d);
-	GList *cur;
-	GSList *csl;
 
 	(* HTML_OBJECT_CLASS (parent_class)->copy) (s, d);
 
-	dest->text = g_strdup (src->text);
+	text_share (src, dest);
 	dest->text_len      = src->text_len;
 	dest->text_bytes    = src->text_bytes;
 	dest->font_style    = src->font_style;
@@ -176,18 +270,16 @@ copy (HTMLObject *s,
 
 	html_color_ref (dest->color);
 
-	dest->spell_errors = g_list_copy (src->spell_errors);
-	cur = dest->spell_errors;
-	while (cur) {
-		SpellError *se = (SpellError *) cur->data;
-		cur->data = spell_error_new (se->off, se->len);
-		cur = cur->next;
-	}
+	dest->spell_errors = spell_errors_copy (src->spell_errors);
 
-	dest->links = g_slist_copy (src->links);
+	if (src->links && src->links->len) {
+		guint i;
 
-	for (csl = dest->links; csl; csl = csl->next)
-		csl->data = html_link_dup ((Link *) csl->data);
+		dest->links = links_new (src->links->len);
+		for (i = 0; i < src->links->len; i++)
+			g_ptr_array_add (dest->links, html_link_dup (LINK (src->links, i)));
+	} else
+		dest->links = NULL;
 
 	dest->pi = NULL;
 	dest->direction = src->direction;
@@ -295,16 +387,20 @@ cut_links_full (HTMLText *text,
                 gint shift_offset,
                 gint shift_index)
 {
-	GSList *l, *next;
 	Link *link;
+	guint i;
+
+	if (!text->links)
+		return;
 
-	for (l = text->links; l; l = next) {
-		next = l->next;
-		link = (Link *) l->data;
+	/* links ending before start_offset are not affected */
+	i = links_bsearch_end (text->links, start_offset);
+	while (i < text->links->len) {
+		link = LINK (text->links, i);
 
 		if (start_offset <= link->start_offset && link->end_offset <= end_offset) {
-			html_link_free (link);
-			text->links = g_slist_delete_link (text->links, l);
+			g_ptr_array_remove_index (text->links, i);
+			continue;
 		} else if (end_offset <= link->start_offset) {
 			link->start_offset -= shift_offset;
 			link->start_index -= shift_index;
@@ -334,14 +430,15 @@ cut_links_full (HTMLText *text,
 					dup->end_offset = start_offset;
 					dup->end_index = start_index;
 
-					l = g_slist_prepend (l, dup);
-					next = l->next->next;
+					g_ptr_array_insert (text->links, i, dup);
+					i++;
 				}
 			}
 		} else if (start_offset < link->end_offset) {
 			link->end_offset = start_offset;
 			link->end_index = start_index;
 		}
+		i++;
 	}
 }
 
@@ -363,7 +460,7 @@ html_text_op_copy_helper (HTMLText *text,
 {
 	HTMLObject *rv;
 	HTMLText *rvt;
-	gchar *tail, *nt;
+	gchar *tail;
 	gint begin, end, begin_index, end_index;
 
 	begin = (from) ? GPOINTER_TO_INT (from->data) : 0;
@@ -379,9 +476,10 @@ html_text_op_copy_helper (HTMLText *text,
 	rvt = HTML_TEXT (rv);
 	rvt->text_len = end - begin;
 	rvt->text_bytes = end_index - begin_index;
-	nt = g_strndup (rvt->text + begin_index, rvt->text_bytes);
-	g_free (rvt->text);
-	rvt->text = nt;
+
+	/* whole text copies keep sharing the string */
+	if (begin_index > 0 || end_index < text->text_bytes)
+		text_take (rvt, g_strndup (text->text + begin_index, rvt->text_bytes));
 
 	rvt->spell_errors = remove_spell_errors (rvt->spell_errors, 0, begin);
 	rvt->spell_errors = remove_spell_errors (rvt->spell_errors, end, text->text_len - end);
@@ -435,7 +533,6 @@ html_text_op_cut_helper (HTMLText *text,
 		begin_index = html_text_get_index (text, begin);
 		end_index = tail - text->text;
 		text->text_bytes -= tail - (text->text + begin_index);
-		text->text[begin_index] = 0;
 		cut_attr_list (text, begin_index, end_index);
 		if (end_index < rvt->text_bytes)
 			cut_attr_list (rvt, end_index, rvt->text_bytes);
@@ -446,28 +543,27 @@ html_text_op_cut_helper (HTMLText *text,
 			cut_links (rvt, end, rvt->text_len, end_index, rvt->text_bytes);
 		if (begin > 0)
 			cut_links (rvt, 0, begin, 0, begin_index);
-		nt = g_strconcat (text->text, tail, NULL);
-		g_free (text->text);
+		nt = g_malloc (text->text_bytes + 1);
+		memcpy (nt, text->text, begin_index);
+		memcpy (nt + begin_index, tail, text->text_bytes - begin_index + 1);
 
 		rvt->spell_errors = remove_spell_errors (rvt->spell_errors, 0, begin);
 		rvt->spell_errors = remove_spell_errors (rvt->spell_errors, end, text->text_len - end);
 		move_spell_errors (rvt->spell_errors, begin, -begin);
 
-		text->text = nt;
+		text_take (text, nt);
 		text->text_len -= end - begin;
 		*len           += end - begin;
 
-		nt = g_strndup (rvt->text + begin_index, end_index - begin_index);
-		g_free (rvt->text);
-		rvt->text = nt;
+		text_take (rvt, g_strndup (rvt->text + begin_index, end_index - begin_index));
 		rvt->text_len = end - begin;
 		rvt->text_bytes = end_index - begin_index;
 
 		text->spell_errors = remove_spell_errors (text->spell_errors, begin, end - begin);
 		move_spell_errors (text->spell_errors, end, - (end - begin));
 
-		html_text_convert_nbsp (text, TRUE);
-		html_text_convert_nbsp (rvt, TRUE);
+		html_text_convert_nbsp (text);
+		html_text_convert_nbsp (rvt);
 		pango_info_destroy (text);
 	} else {
 		text->spell_errors = remove_spell_errors (text->spell_errors, 0, text->text_len);
@@ -517,11 +613,11 @@ merge_links (HTMLText *t1,
              HTMLText *t2)
 {
 	Link *tail, *head;
-	GSList *l;
+	guint i;
 
-	if (t2->links) {
-		for (l = t2->links; l; l = l->next) {
-			Link *link = (Link *) l->data;
+	if (t2->links && t2->links->len) {
+		for (i = 0; i < t2->links->len; i++) {
+			Link *link = LINK (t2->links, i);
 
 			link->start_offset += t1->text_len;
 			link->start_index += t1->text_bytes;
@@ -529,19 +625,31 @@ merge_links (HTMLText *t1,
 			link->end_index += t1->text_bytes;
 		}
 
-		if (t1->links) {
-			head = (Link *) t1->links->data;
-			tail = (Link *) g_slist_last (t2->links)->data;
+		if (t1->links && t1->links->len) {
+			gboolean joined = FALSE;
 
-			if (tail->start_offset == head->end_offset && html_link_equal (head, tail)) {
-				tail->start_offset = head->start_offset;
-				tail->start_index = head->start_index;
-				html_link_free (head);
-				t1->links = g_slist_delete_link (t1->links, t1->links);
+			tail = LINK (t1->links, t1->links->len - 1);
+			head = LINK (t2->links, 0);
+
+			if (head->start_offset == tail->end_offset && html_link_equal (tail, head)) {
+				tail->end_offset = head->end_offset;
+				tail->end_index = head->end_index;
+				joined = TRUE;
 			}
+
+			for (i = joined ? 1 : 0; i < t2->links->len; i++)
+				g_ptr_array_add (t1->links, LINK (t2->links, i));
+
+			/* links moved to t1 must not be freed with t2's array */
+			g_ptr_array_set_free_func (t2->links, NULL);
+			free_links (t2->links);
+			if (joined)
+				html_link_free (head);
+		} else {
+			free_links (t1->links);
+			t1->links = t2->links;
 		}
 
-		t1->links = g_slist_concat (t2->links, t1->links);
 		t2->links = NULL;
 	}
 }
@@ -555,7 +663,6 @@ object_merge (HTMLObject *self,
               HTMLCursor *cursor)
 {
 	HTMLText *t1, *t2;
-	gchar *to_free;
 
 	t1 = HTML_TEXT (self);
 	t2 = HTML_TEXT (with);
@@ -587,12 +694,10 @@ object_merge (HTMLObject *self,
 	}
 	merge_links (t1, t2);
 
-	to_free       = t1->text;
-	t1->text      = g_strconcat (t1->text, t2->text, NULL);
+	text_take (t1, g_strconcat (t1->text, t2->text, NULL));
 	t1->text_len += t2->text_len;
 	t1->text_bytes += t2->text_bytes;
-	g_free (to_free);
-	html_text_convert_nbsp (t1, TRUE);
+	html_text_convert_nbsp (t1);
 	html_object_change_set (self, HTML_CHANGE_ALL_CALC);
 	pango_info_destroy (t1);
 	pango_info_destroy (t2);
@@ -669,63 +774,46 @@ split_links (HTMLText *t1,
              gint offset,
              gint index)
 {
-	GSList *l, *prev = NULL;
+	guint i, n;
 
-	for (l = t1->links; l; l = l->next) {
-		Link *link = (Link *) l->data;
+	if (t1->links) {
+		/* t1 keeps links starting before offset */
+		n = links_bsearch_start (t1->links, offset - 1) + 1;
+		if (n < t1->links->len)
+			g_ptr_array_remove_range (t1->links, n, t1->links->len - n);
+		if (n > 0) {
+			Link *link = LINK (t1->links, n - 1);
 
-		if (link->start_offset < offset) {
 			if (link->end_offset > offset) {
 				link->end_offset = offset;
 				link->end_index = index;
 			}
-
-			if (prev) {
-				prev->next = NULL;
-				free_links (t1->links);
-			}
-			t1->links = l;
-			break;
-		}
-		prev = l;
-
-		if (!l->next) {
-			free_links (t1->links);
-			t1->links = NULL;
-			break;
 		}
 	}
 
-	prev = NULL;
-	for (l = t2->links; l; l = l->next) {
-		Link *link = (Link *) l->data;
+	if (t2->links) {
+		/* t2 keeps links starting at or after offset and the one crossing it */
+		n = links_bsearch_start (t2->links, offset - 1) + 1;
+		if (n > 0) {
+			Link *link = LINK (t2->links, n - 1);
 
-		if (link->start_offset < offset) {
 			if (link->end_offset > offset) {
 				link->start_offset = offset;
 				link->start_index = index;
-				prev = l;
-				l = l->next;
-			}
-			if (prev) {
-				prev->next = NULL;
-				free_links (l);
-			} else {
-				free_links (t2->links);
-				t2->links = NULL;
+				n--;
 			}
-			break;
+			if (n > 0)
+				g_ptr_array_remove_range (t2->links, 0, n);
 		}
-		prev = l;
-	}
 
-	for (l = t2->links; l; l = l->next) {
-		Link *link = (Link *) l->data;
+		for (i = 0; i < t2->links->len; i++) {
+			Link *link = LINK (t2->links, i);
 
-		link->start_offset -= offset;
-		link->start_index -= index;
-		link->end_offset -= offset;
-		link->end_index -= index;
+			link->start_offset -= offset;
+			link->start_index -= index;
+			link->end_offset -= offset;
+			link->end_index -= index;
+		}
 	}
 }
 
@@ -740,7 +828,6 @@ object_split (HTMLObject *self,
 {
 	HTMLObject *dup, *prev;
 	HTMLText *t1, *t2;
-	gchar *tt;
 	gint split_index;
 
 	g_assert (self->parent);
@@ -749,24 +836,19 @@ object_split (HTMLObject *self,
 
 	t1              = HTML_TEXT (self);
 	dup             = html_object_dup (self);
-	tt              = t1->text;
 	split_index     = html_text_get_index (t1, offset);
-	t1->text        = g_strndup (tt, split_index);
+	text_take (t1, g_strndup (t1->text, split_index));
 	t1->text_len    = offset;
 	t1->text_bytes  = split_index;
-	g_free (tt);
-	html_text_convert_nbsp (t1, TRUE);
+	html_text_convert_nbsp (t1);
 
 	t2              = HTML_TEXT (dup);
-	tt              = t2->text;
-	t2->text        = html_text_get_text (t2, offset);
+	text_take (t2, g_strdup (t2->text + split_index));
 	t2->text_len   -= offset;
 	t2->text_bytes -= split_index;
 	split_attrs (t1, t2, split_index);
 	split_links (t1, t2, offset, split_index);
-	if (!html_text_convert_nbsp (t2, FALSE))
-		t2->text = g_strdup (t2->text);
-	g_free (tt);
+	html_text_convert_nbsp (t2);
 
 	html_clue_append_after (HTML_CLUE (self->parent), dup, self);
 
@@ -1346,12 +1428,12 @@ html_text_prepare_attrs (HTMLText *text,
 
 	if (text->links && e) {
 		HTMLColor *link_color;
-		GSList *l;
+		guint i;
 
-		for (l = text->links; l; l = l->next) {
+		for (i = 0; i < text->links->len; i++) {
 			Link *link;
 
-			link = (Link *) l->data;
+			link = LINK (text->links, i);
 
 			if (link->is_visited == FALSE)
 				link_color = html_colorset_get_color (e->settings->color_set, HTMLLinkColor);
@@ -1901,15 +1983,17 @@ save_text (HTMLText *text,
            HTMLEngineSaveState *state,
            guint start_index,
            guint end_index,
-           GSList **l,
+           guint *li,
            gboolean *link_started)
 {
-	if (*l) {
+	GPtrArray *links = text->links;
+
+	if (links && *li < links->len) {
 		Link *link;
 
-		link = (Link *) (*l)->data;
+		link = LINK (links, *li);
 
-		while (*l && ((!*link_started && start_index <= link->start_index && link->start_index < end_index)
+		while (*li < links->len && ((!*link_started && start_index <= link->start_index && link->start_index < end_index)
 			      || (*link_started && link->end_index <= end_index))) {
 			if (!*link_started && start_index <= link->start_index && link->start_index < end_index) {
 				if (!save_text_part (text, state, start_index, link->start_index))
@@ -1923,10 +2007,10 @@ save_text (HTMLText *text,
 					return FALSE;
 				save_link_close (link, state);
 				*link_started = FALSE;
-				(*l) = (*l)->next;
+				(*li)++;
 				start_index = link->end_index;
-				if (*l)
-					link = (Link *) (*l)->data;
+				if (*li < links->len)
+					link = LINK (links, *li);
 			}
 		}
 
@@ -1946,10 +2030,8 @@ save (HTMLObject *self,
 	PangoAttrIterator *iter = pango_attr_list_get_iterator (text->attr_list);
 
 	if (iter) {
-		GSList *l, *links = g_slist_reverse (g_slist_copy (text->links));
 		gboolean link_started = FALSE;
-
-		l = links;
+		guint li = 0;
 
 		do {
 			GSList *attrs;
@@ -1964,7 +2046,7 @@ save (HTMLObject *self,
 
 			if (attrs)
 				save_open_attrs (state, attrs);
-			save_text (text, state, start_index, end_index, &l, &link_started);
+			save_text (text, state, start_index, end_index, &li, &link_started);
 			if (attrs) {
 				attrs = g_slist_reverse (attrs);
 				save_close_attrs (state, attrs);
@@ -1973,7 +2055,6 @@ save (HTMLObject *self,
 		} while (pango_attr_iterator_next (iter));
 
 		pango_attr_iterator_destroy (iter);
-		g_slist_free (links);
 	}
 
 	return TRUE;
@@ -2226,13 +2307,13 @@ update_attributes (PangoAttrList *attrs,
 }
 
 static void
-update_links (GSList *links,
+update_links (GPtrArray *links,
               GSList *changes)
 {
-	GSList *cl;
+	guint i;
 
-	for (cl = links; cl; cl = cl->next) {
-		Link *link = (Link *) cl->data;
+	for (i = 0; i < links->len; i++) {
+		Link *link = LINK (links, i);
 		update_index_interval (&link->start_index, &link->end_index, changes);
 	}
 }
@@ -2248,21 +2329,18 @@ free_changes (GSList *changes)
 }
 
 gboolean
-html_text_convert_nbsp (HTMLText *text,
-                        gboolean free_text)
+html_text_convert_nbsp (HTMLText *text)
 {
 	GSList *changes = NULL;
 	gint delta;
 
 	if (is_convert_nbsp_needed (text->text, &delta, &changes)) {
-		gchar *to_free;
+		gchar *converted;
 
-		to_free = text->text;
-		text->text = g_malloc (strlen (to_free) + delta + 1);
+		converted = g_malloc (strlen (text->text) + delta + 1);
 		text->text_bytes += delta;
-		convert_nbsp (text->text, to_free);
-		if (free_text)
-			g_free (to_free);
+		convert_nbsp (converted, text->text);
+		text_take (text, converted);
 		if (changes) {
 			if (text->attr_list)
 				update_attributes (text->attr_list, changes);
@@ -2278,47 +2356,76 @@ html_text_convert_nbsp (HTMLText *text,
 	return FALSE;
 }
 
-static void
-move_spell_errors (GList *spell_errors,
-                   guint offset,
-                   gint delta)
+/* returns index of the first spell error ending at or after offset */
+static guint
+spell_errors_bsearch_end (GArray *spell_errors,
+                          guint offset)
 {
-	SpellError *se;
+	guint lo = 0, hi = spell_errors ? spell_errors->len : 0;
 
-	if (!delta)
-		return;
+	while (lo < hi) {
+		guint mid = lo + (hi - lo) / 2;
+		SpellError *se = SPELL_ERROR (spell_errors, mid);
 
-	while (spell_errors) {
-		se = (SpellError *) spell_errors->data;
-		if (se->off >= offset)
-			se->off += delta;
-		spell_errors = spell_errors->next;
+		if (se->off + se->len < offset)
+			lo = mid + 1;
+		else
+			hi = mid;
 	}
+
+	return lo;
 }
 
-static GList *
-remove_one (GList *list,
-            GList *link)
+/* returns index of the first spell error starting at or after offset */
+static guint
+spell_errors_bsearch_off (GArray *spell_errors,
+                          guint offset)
 {
-	spell_error_destroy ((SpellError *) link->data);
-	list = g_list_remove_link (list, link);
-	g_list_free (link);
+	guint lo = 0, hi = spell_errors ? spell_errors->len : 0;
 
-	return list;
+	while (lo < hi) {
+		guint mid = lo + (hi - lo) / 2;
+
+		if (SPELL_ERROR (spell_errors, mid)->off < offset)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo;
 }
 
-static GList *
-remove_spell_errors (GList *spell_errors,
+static void
+move_spell_errors (GArray *spell_errors,
+                   guint offset,
+                   gint delta)
+{
+	guint i;
+
+	if (!delta || !spell_errors)
+		return;
+
+	for (i = spell_errors_bsearch_off (spell_errors, offset); i < spell_errors->len; i++)
+		SPELL_ERROR (spell_errors, i)->off += delta;
+}
+
+static GArray *
+remove_spell_errors (GArray *spell_errors,
                      guint offset,
                      guint len)
 {
 	SpellError *se;
-	GList *cur, *cnext;
+	guint first, i, j;
 
-	cur = spell_errors;
-	while (cur) {
-		cnext = cur->next;
-		se = (SpellError *) cur->data;
+	if (!spell_errors)
+		return NULL;
+
+	/* only errors overlapping the interval are affected, compact them in place */
+	first = spell_errors_bsearch_end (spell_errors, offset + 1);
+	for (i = j = first; i < spell_errors->len; i++) {
+		se = SPELL_ERROR (spell_errors, i);
+		if (se->off >= offset + len)
+			break;
 		if (se->off < offset) {
 			if (se->off + se->len > offset) {
 				if (se->off + se->len <= offset + len)
@@ -2326,68 +2433,89 @@ remove_spell_errors (GList *spell_errors,
 				else
 					se->len -= len;
 				if (se->len < 2)
-					spell_errors = remove_one (spell_errors, cur);
+					continue;
 			}
-		} else if (se->off < offset + len) {
+		} else {
 			if (se->off + se->len <= offset + len)
-				spell_errors = remove_one (spell_errors, cur);
-			else {
-				se->len -= offset + len - se->off;
-				se->off  = offset + len;
-				if (se->len < 2)
-					spell_errors = remove_one (spell_errors, cur);
-			}
+				continue;
+			se->len -= offset + len - se->off;
+			se->off  = offset + len;
+			if (se->len < 2)
+				continue;
 		}
-		cur = cnext;
+		if (i != j)
+			*SPELL_ERROR (spell_errors, j) = *se;
+		j++;
 	}
+
+	if (i > j)
+		g_array_remove_range (spell_errors, j, i - j);
+
 	return spell_errors;
 }
 
-static gint
-se_cmp (SpellError *a,
-        SpellError *b)
+static GArray *
+spell_errors_new (guint reserved)
 {
-	guint o1 = a->off;
-	guint o2 = b->off;
-
-	return (o1 < o2) ? -1 : (o1 == o2) ? 0 : 1;
+	return g_array_sized_new (FALSE, FALSE, sizeof (SpellError), reserved);
 }
 
-static GList *
-merge_spell_errors (GList *se1,
-                    GList *se2)
+static GArray *
+spell_errors_copy (GArray *spell_errors)
 {
-	GList *merged = NULL;
-	GList *link;
+	GArray *copy;
 
-	/* Build the merge list in reverse order. */
-	while (se1 != NULL && se2 != NULL) {
+	if (!spell_errors || !spell_errors->len)
+		return NULL;
 
-		/* Pop the lesser of the two list heads. */
-		if (se_cmp (se1->data, se2->data) < 0) {
-			link = se1;
-			se1 = g_list_remove_link (se1, link);
-		} else {
-			link = se2;
-			se2 = g_list_remove_link (se2, link);
-		}
+	copy = spell_errors_new (spell_errors->len);
+	g_array_append_vals (copy, spell_errors->data, spell_errors->len);
 
-		/* Merge unique items, discard duplicates. */
-		if (merged == NULL || se_cmp (link->data, merged->data) != 0)
-			merged = g_list_concat (link, merged);
-		else {
-			spell_error_destroy (link->data);
-			g_list_free (link);
-		}
+	return copy;
+}
+
+static GArray *
+merge_spell_errors (GArray *se1,
+                    GArray *se2)
+{
+	GArray *merged;
+	guint i = 0, j = 0;
+
+	if (!se2 || !se2->len) {
+		if (se2)
+			g_array_free (se2, TRUE);
+		return se1;
+	}
+	if (!se1 || !se1->len) {
+		if (se1)
+			g_array_free (se1, TRUE);
+		return se2;
 	}
 
-	merged = g_list_reverse (merged);
+	/* both are usually disjoint and ordered, so just append */
+	if (SPELL_ERROR (se1, se1->len - 1)->off < SPELL_ERROR (se2, 0)->off) {
+		g_array_append_vals (se1, se2->data, se2->len);
+		g_array_free (se2, TRUE);
+		return se1;
+	}
+
+	merged = spell_errors_new (se1->len + se2->len);
+	while (i < se1->len || j < se2->len) {
+		SpellError *se;
+
+		/* pop the lesser of the two heads, se2 wins on equal offsets */
+		if (j >= se2->len || (i < se1->len && SPELL_ERROR (se1, i)->off < SPELL_ERROR (se2, j)->off))
+			se = SPELL_ERROR (se1, i++);
+		else
+			se = SPELL_ERROR (se2, j++);
 
-	/* At this point at least one of the two input lists are empty,
-	 * so just append them both to the end of the merge list. */
+		/* merge unique items, discard duplicates */
+		if (merged->len == 0 || SPELL_ERROR (merged, merged->len - 1)->off != se->off)
+			g_array_append_vals (merged, se, 1);
+	}
 
-	merged = g_list_concat (merged, se1);
-	merged = g_list_concat (merged, se2);
+	g_array_free (se1, TRUE);
+	g_array_free (se2, TRUE);
 
 	return merged;
 }
@@ -2474,7 +2602,7 @@ destroy (HTMLObject *obj)
 	HTMLText *text = HTML_TEXT (obj);
 	html_color_unref (text->color);
 	html_text_spell_errors_clear (text);
-	g_free (text->text);
+	text_release (text);
 	g_free (text->face);
 	pango_info_destroy (text);
 	pango_attr_list_unref (text->attr_list);
@@ -2669,16 +2797,22 @@ Link *
 html_text_get_link_at_offset (HTMLText *text,
                               gint offset)
 {
-	GSList *l;
+	gint i = get_link_index_at_offset (text, offset);
 
-	for (l = text->links; l; l = l->next) {
-		Link *link = (Link *) l->data;
+	return i >= 0 ? LINK (text->links, i) : NULL;
+}
 
-		if (link->start_offset <= offset && offset <= link->end_offset)
-			return link;
-	}
+guint
+html_text_get_n_links (HTMLText *text)
+{
+	return text->links ? text->links->len : 0;
+}
 
-	return NULL;
+Link *
+html_text_get_nth_link (HTMLText *text,
+                        guint n)
+{
+	return text->links && n < text->links->len ? LINK (text->links, n) : NULL;
 }
 
 static const gchar *
@@ -3174,6 +3308,7 @@ html_text_init (HTMLText *text,
 
 	html_object_init (HTML_OBJECT (text), HTML_OBJECT_CLASS (klass));
 
+	text->text_ref = NULL;
 	text->text_bytes = html_text_sanitize (str, &text->text, &len);
 	text->text_len = len;
 
@@ -3258,69 +3393,51 @@ void
 html_text_set_text (HTMLText *text,
                     const gchar *new_text)
 {
-	g_free (text->text);
-	text->text = NULL;
+	text_release (text);
 	text->text_len = -1;
 	text->text_bytes = html_text_sanitize (new_text, &text->text,
 					       (gint *) &text->text_len);
 	html_object_change_set (HTML_OBJECT (text), HTML_CHANGE_ALL);
 }
 
-/* spell checking */
-
-#include "htmlinterval.h"
-
-static SpellError *
-spell_error_new (guint off,
-                 guint len)
+gboolean
+html_text_is_shared (HTMLText *text)
 {
-	SpellError *se = g_new (SpellError, 1);
-
-	se->off = off;
-	se->len = len;
-
-	return se;
+	return text->text_ref && g_atomic_int_get (text->text_ref) > 1;
 }
 
-static void
-spell_error_destroy (SpellError *se)
-{
-	g_free (se);
-}
+/* spell checking */
+
+#include "htmlinterval.h"
 
 void
 html_text_spell_errors_clear (HTMLText *text)
 {
-	g_list_free_full (g_steal_pointer (&text->spell_errors), g_free);
-	g_list_free    (text->spell_errors);
-	text->spell_errors = NULL;
+	if (text->spell_errors) {
+		g_array_free (text->spell_errors, TRUE);
+		text->spell_errors = NULL;
+	}
 }
 
 void
 html_text_spell_errors_clear_interval (HTMLText *text,
                                        HTMLInterval *i)
 {
-	GList *cur, *cnext;
-	SpellError *se;
-	guint offset, len;
+	guint offset, len, first, last;
+
+	if (!text->spell_errors)
+		return;
 
 	offset = html_interval_get_start  (i, HTML_OBJECT (text));
 	len    = html_interval_get_length (i, HTML_OBJECT (text));
-	cur    = text->spell_errors;
 
 	/* printf ("html_text_spell_errors_clear_interval %s %d %d\n", text->text, offset, len); */
 
-	while (cur) {
-		cnext = cur->next;
-		se    = (SpellError *) cur->data;
-		/* test overlap */
-		if (MAX (offset, se->off) <= MIN (se->off + se->len, offset + len)) {
-			text->spell_errors = g_list_remove_link (text->spell_errors, cur);
-			spell_error_destroy (se);
-			g_list_free (cur);
-		}
-		cur = cnext;
-	}
+	/* overlapping errors (touching included) form a continuous range */
+	first = spell_errors_bsearch_end (text->spell_errors, offset);
+	last  = spell_errors_bsearch_off (text->spell_errors, offset + len + 1);
+	if (first < last)
+		g_array_remove_range (text->spell_errors, first, last - first);
 }
 
 void
@@ -3328,9 +3445,29 @@ html_text_spell_errors_add (HTMLText *text,
                             guint off,
                             guint len)
 {
-	text->spell_errors = merge_spell_errors (
-		text->spell_errors, g_list_prepend (
-		NULL, spell_error_new (off, len)));
+	SpellError se;
+	guint i;
+
+	se.off = off;
+	se.len = len;
+
+	if (!text->spell_errors)
+		text->spell_errors = spell_errors_new (1);
+
+	i = spell_errors_bsearch_off (text->spell_errors, off);
+	if (i < text->spell_errors->len && SPELL_ERROR (text->spell_errors, i)->off == off)
+		*SPELL_ERROR (text->spell_errors, i) = se;
+	else
+		g_array_insert_val (text->spell_errors, i, se);
+}
+
+/* returns index of the first spell error ending at or after offset,
+ * the number of spell errors if there is none */
+guint
+html_text_spell_errors_find (HTMLText *text,
+                             guint offset)
+{
+	return spell_errors_bsearch_end (text->spell_errors, offset);
 }
 
 guint
@@ -3373,7 +3510,7 @@ html_text_get_char (HTMLText *text,
 struct _HTMLMagicInsertMatch
 {
 	const gchar *regex;
-	regex_t *preg;
+	gint group;
 	const gchar *prefix;
 };
 
@@ -3381,28 +3518,80 @@ typedef struct _HTMLMagicInsertMatch HTMLMagicInsertMatch;
 
 static HTMLMagicInsertMatch mim[] = {
 	/* prefixed expressions */
-	{ "(news|telnet|nntp|file|http|ftp|sftp|https|webcal)://([-a-z0-9]+(:[-a-z0-9]+)?@)?[-a-z0-9.]+[-a-z0-9](:[0-9]*)?(([.])?/[-a-z0-9_$.+!*(),;:@%&=?/~#']*[^]'.}>\\) ,?!;:\"]?)?", NULL, NULL },
-	{ "(sip|h323|callto):([-_a-z0-9.'\\+]+(:[0-9]{1,5})?(/[-_a-z0-9.']+)?)(@([-_a-z0-9.%=?]+|([0-9]{1,3}.){3}[0-9]{1,3})?)?(:[0-9]{1,5})?", NULL, NULL },
-	{ "mailto:[-_a-z0-9.'\\+]+@[-_a-z0-9.%=?]+", NULL, NULL },
+	{ "(news|telnet|nntp|file|http|ftp|sftp|https|webcal)://([-a-z0-9]+(:[-a-z0-9]+)?@)?[-a-z0-9.]+[-a-z0-9](:[0-9]*)?(([.])?/[-a-z0-9_$.+!*(),;:@%&=?/~#']*[^]'.}>\\) ,?!;:\"]?)?", 0, NULL },
+	{ "(sip|h323|callto):([-_a-z0-9.'\\+]+(:[0-9]{1,5})?(/[-_a-z0-9.']+)?)(@([-_a-z0-9.%=?]+|([0-9]{1,3}.){3}[0-9]{1,3})?)?(:[0-9]{1,5})?", 0, NULL },
+	{ "mailto:[-_a-z0-9.'\\+]+@[-_a-z0-9.%=?]+", 0, NULL },
 	/* not prefixed expression */
-	{ "www\\.[-a-z0-9.]+[-a-z0-9](:[0-9]*)?(([.])?/[-A-Za-z0-9_$.+!*(),;:@%&=?/~#]*[^]'.}>\\) ,?!;:\"]?)?", NULL, "http://" },
-	{ "ftp\\.[-a-z0-9.]+[-a-z0-9](:[0-9]*)?(([.])?/[-A-Za-z0-9_$.+!*(),;:@%&=?/~#]*[^]'.}>\\) ,?!;:\"]?)?", NULL, "ftp://" },
-	{ "[-_a-z0-9.'\\+]+@[-_a-z0-9.%=?]+", NULL, "mailto:" }
+	{ "www\\.[-a-z0-9.]+[-a-z0-9](:[0-9]*)?(([.])?/[-A-Za-z0-9_$.+!*(),;:@%&=?/~#]*[^]'.}>\\) ,?!;:\"]?)?", 0, "http://" },
+	{ "ftp\\.[-a-z0-9.]+[-a-z0-9](:[0-9]*)?(([.])?/[-A-Za-z0-9_$.+!*(),;:@%&=?/~#]*[^]'.}>\\) ,?!;:\"]?)?", 0, "ftp://" },
+	{ "[-_a-z0-9.'\\+]+@[-_a-z0-9.%=?]+", 0, "mailto:" }
 };
 
+/* All the expressions above joined into one alternation, each in its own
+ * group, so that a word is matched against all of them by one regexec ()
+ * and the group tells which expression matched. */
+static regex_t *magic_links_preg = NULL;
+static gsize magic_links_nmatch = 0;
+
+static gint
+count_groups (const gchar *regex)
+{
+	gint n = 0;
+
+	for (; *regex; regex++) {
+		if (*regex == '\\') {
+			if (regex[1])
+				regex++;
+		} else if (*regex == '[') {
+			/* bracket expression, leading ']' is a literal */
+			regex++;
+			if (*regex == '^')
+				regex++;
+			if (*regex == ']')
+				regex++;
+			while (*regex && *regex != ']')
+				regex++;
+			if (!*regex)
+				break;
+		} else if (*regex == '(')
+			n++;
+	}
+
+	return n;
+}
+
 void
 html_engine_init_magic_links (void)
 {
-	gint i;
+	GString *regex;
+	gint i, group = 1;
+
+	if (magic_links_preg)
+		return;
 
+	regex = g_string_new (NULL);
 	for (i = 0; i < G_N_ELEMENTS (mim); i++) {
-		mim[i].preg = g_new0 (regex_t, 1);
-		if (regcomp (mim[i].preg, mim[i].regex, REG_EXTENDED | REG_ICASE)) {
-			/* error */
-			g_free (mim[i].preg);
-			mim[i].preg = 0;
-		}
+		if (i)
+			g_string_append_c (regex, '|');
+		g_string_append_printf (regex, "(%s)", mim[i].regex);
+		mim[i].group = group;
+		group += 1 + count_groups (mim[i].regex);
 	}
+
+	magic_links_preg = g_new0 (regex_t, 1);
+	if (regcomp (magic_links_preg, regex->str, REG_EXTENDED | REG_ICASE)) {
+		/* error */
+		g_free (magic_links_preg);
+		magic_links_preg = NULL;
+	} else if (magic_links_preg->re_nsub + 1 != group) {
+		g_warning ("magic links: unexpected number of subexpressions");
+		regfree (magic_links_preg);
+		g_free (magic_links_preg);
+		magic_links_preg = NULL;
+	} else
+		magic_links_nmatch = magic_links_preg->re_nsub + 1;
+
+	g_string_free (regex, TRUE);
 }
 
 static void
@@ -3410,30 +3599,121 @@ paste_link (HTMLEngine *engine,
             HTMLText *text,
             gint so,
             gint eo,
+            gint so_index,
+            gint eo_index,
             const gchar *prefix)
 {
 	gchar *href;
 	gchar *base;
 
-	base = g_strndup (html_text_get_text (text, so), html_text_get_index (text, eo) - html_text_get_index (text, so));
+	base = g_strndup (text->text + so_index, eo_index - so_index);
 	href = (prefix) ? g_strconcat (prefix, base, NULL) : g_strdup (base);
 	g_free (base);
 
-	html_text_add_link (text, engine, href, NULL, so, eo);
+	html_text_add_link_full (text, engine, href, NULL, so_index, eo_index, so, eo);
 	g_free (href);
 }
 
+/* Every expression contains ':' or '@', or starts with "www." or
+ * "ftp.", so words without them are never passed to regexec (). */
+static gboolean
+magic_link_candidate (const gchar *word,
+                      gint len)
+{
+	gint i;
+
+	for (i = 0; i < len; i++) {
+		if (word[i] == ':' || word[i] == '@')
+			return TRUE;
+		if (i + 4 <= len && (!g_ascii_strncasecmp (word + i, "www.", 4) || !g_ascii_strncasecmp (word + i, "ftp.", 4)))
+			return TRUE;
+	}
+
+	return FALSE;
+}
+
+static gboolean
+magic_links_in_word (HTMLText *text,
+                     HTMLEngine *engine,
+                     gint index,
+                     gint offset,
+                     gint len,
+                     regmatch_t *pmatch)
+{
+	gboolean rv = FALSE;
+	gchar *str;
+	gint pos = 0, i;
+
+	str = g_strndup (text->text + index, len);
+	while (pos < len && !regexec (magic_links_preg, str + pos, magic_links_nmatch, pmatch, 0)) {
+		for (i = 0; i < G_N_ELEMENTS (mim) - 1 && pmatch[mim[i].group].rm_so == -1; i++)
+			;
+		/* words are ascii only, so offsets and indexes advance together */
+		paste_link (engine, text,
+			    offset + pos + pmatch[0].rm_so, offset + pos + pmatch[0].rm_eo,
+			    index + pos + pmatch[0].rm_so, index + pos + pmatch[0].rm_eo, mim[i].prefix);
+		rv = TRUE;
+		pos += pmatch[0].rm_eo + 1;
+	}
+	g_free (str);
+
+	return rv;
+}
+
+/* Links can't contain spaces, so the text is walked once word by word
+ * from INDEX (character OFFSET) on and only the words which may contain
+ * a link are matched. Words with characters >= 0x80 are skipped, that
+ * could be removed once we have utf8 regex. */
+static gboolean
+magic_links_scan (HTMLText *text,
+                  HTMLEngine *engine,
+                  gint index,
+                  gint offset)
+{
+	regmatch_t *pmatch;
+	gboolean rv = FALSE;
+	const gchar *p, *word;
+	gint word_offset;
+	gboolean ascii;
+
+	if (!magic_links_preg)
+		return FALSE;
+
+	pmatch = g_new (regmatch_t, magic_links_nmatch);
+	p = text->text + index;
+	while (*p) {
+		while (*p == ' ' || g_utf8_get_char (p) == ENTITY_NBSP) {
+			p = g_utf8_next_char (p);
+			offset++;
+		}
+
+		word = p;
+		word_offset = offset;
+		ascii = TRUE;
+		while (*p && *p != ' ' && g_utf8_get_char (p) != ENTITY_NBSP) {
+			if ((guchar) *p >= 0x80)
+				ascii = FALSE;
+			p = g_utf8_next_char (p);
+			offset++;
+		}
+
+		if (ascii && p > word && magic_link_candidate (word, p - word))
+			rv = magic_links_in_word (text, engine, word - text->text, word_offset, p - word, pmatch) || rv;
+	}
+	g_free (pmatch);
+
+	return rv;
+}
+
 gboolean
 html_text_magic_link (HTMLText *text,
                       HTMLEngine *engine,
                       guint offset)
 {
-	regmatch_t pmatch[2];
-	gint i;
-	gboolean rv = FALSE, exec = TRUE;
+	gboolean rv;
 	gint saved_position;
 	gunichar uc;
-	gchar *str, *cur;
+	gchar *str;
 
 	if (!offset)
 		return FALSE;
@@ -3444,62 +3724,35 @@ html_text_magic_link (HTMLText *text,
 	html_undo_level_begin (engine->undo, "Magic link", "Remove magic link");
 	saved_position = engine->cursor->position;
 
-	cur = str = html_text_get_text (text, offset);
-
-	/* check forward to ensure chars are < 0x80, could be removed once we have utf8 regex */
-	while (cur && *cur) {
-		cur = g_utf8_next_char (cur);
-		if (!*cur)
-			break;
-		uc = g_utf8_get_char (cur);
-		if (uc >= 0x80) {
-			exec = FALSE;
-			break;
-		} else if (uc == ' ' || uc == ENTITY_NBSP) {
-			break;
-		}
-	}
-
+	/* scan from the beginning of the word before offset */
+	str = html_text_get_text (text, offset);
 	uc = g_utf8_get_char (str);
-	if (uc >= 0x80)
-		exec = FALSE;
-	while (exec && uc != ' ' && uc != ENTITY_NBSP && offset) {
+	while (uc != ' ' && uc != ENTITY_NBSP && offset) {
 		str = g_utf8_prev_char (str);
 		uc = g_utf8_get_char (str);
-		if (uc >= 0x80)
-			exec = FALSE;
 		offset--;
 	}
 
-	if (uc == ' ' || uc == ENTITY_NBSP)
+	if (uc == ' ' || uc == ENTITY_NBSP) {
 		str = g_utf8_next_char (str);
-
-	if (exec) {
-		gboolean done = FALSE;
-		guint32 str_offset = 0, str_length = strlen (str);
-
-		while (!done) {
-			done = TRUE;
-			for (i = 0; i < G_N_ELEMENTS (mim); i++) {
-				if (mim[i].preg && !regexec (mim[i].preg, str + str_offset, 2, pmatch, 0)) {
-					paste_link (engine, text,
-						    g_utf8_pointer_to_offset (text->text, str + str_offset + pmatch[0].rm_so),
-						    g_utf8_pointer_to_offset (text->text, str + str_offset + pmatch[0].rm_eo), mim[i].prefix);
-						rv = TRUE;
-						str_offset += pmatch[0].rm_eo + 1;
-						done = str_offset >= str_length;
-						break;
-				}
-			}
-		}
+		offset++;
 	}
 
+	rv = magic_links_scan (text, engine, str - text->text, offset);
+
 	html_undo_level_end (engine->undo, engine);
 	html_cursor_jump_to_position_no_spell (engine->cursor, engine, saved_position);
 
 	return rv;
 }
 
+gboolean
+html_text_magic_links (HTMLText *text,
+                       HTMLEngine *engine)
+{
+	return magic_links_scan (text, engine, 0, 0);
+}
+
 /*
  * magic links end
  */
@@ -3517,20 +3770,19 @@ html_text_append (HTMLText *text,
                   const gchar *pstr,
                   gint len)
 {
-	gchar *to_delete, *str = NULL;
+	gchar *nt, *str = NULL;
 	guint bytes;
 
-	to_delete       = text->text;
 	bytes = html_text_sanitize (pstr, &str, &len);
 	text->text_len += len;
-	text->text      = g_malloc (text->text_bytes + bytes + 1);
+	nt = g_malloc (text->text_bytes + bytes + 1);
 
-	memcpy (text->text, to_delete, text->text_bytes);
-	memcpy (text->text + text->text_bytes, str, bytes);
+	memcpy (nt, text->text, text->text_bytes);
+	memcpy (nt + text->text_bytes, str, bytes);
 	text->text_bytes += bytes;
-	text->text[text->text_bytes] = '\0';
+	nt[text->text_bytes] = '\0';
 
-	g_free (to_delete);
+	text_take (text, nt);
 	g_free (str);
 
 	html_object_change_set (HTML_OBJECT (text), HTML_CHANGE_ALL);
@@ -3545,7 +3797,16 @@ html_text_append_link_full (HTMLText *text,
                             gint start_offset,
                             gint end_offset)
 {
-	text->links = g_slist_prepend (text->links, html_link_new (url, target, start_index, end_index, start_offset, end_offset, FALSE));
+	Link *link = html_link_new (url, target, start_index, end_index, start_offset, end_offset, FALSE);
+
+	if (!text->links)
+		text->links = links_new (1);
+
+	/* links are usually appended in order by the parser */
+	if (text->links->len == 0 || LINK (text->links, text->links->len - 1)->start_offset <= start_offset)
+		g_ptr_array_add (text->links, link);
+	else
+		g_ptr_array_insert (text->links, links_bsearch_start (text->links, start_offset) + 1, link);
 }
 
 static void
@@ -3582,48 +3843,37 @@ html_text_add_link_full (HTMLText *text,
                          gint start_offset,
                          gint end_offset)
 {
-	GSList *l, *prev = NULL;
 	Link *link;
+	gint i;
 
 	cut_links_full (text, start_offset, end_offset, start_index, end_index, 0, 0);
 
-	if (text->links == NULL)
-		html_text_append_link_full (text, url, target, start_index, end_index, start_offset, end_offset);
-	else {
-		Link *plink = NULL, *new_link = html_link_new (url, target, start_index, end_index, start_offset, end_offset, FALSE);
-
-		for (l = text->links; new_link && l; l = l->next) {
-			link = (Link *) l->data;
-			if (new_link->start_offset >= link->end_offset) {
-				if (new_link->start_offset == link->end_offset && html_link_equal (link, new_link)) {
-					link->end_offset = end_offset;
-					link->end_index = end_index;
-					html_link_free (new_link);
-					new_link = NULL;
-				} else {
-					text->links = g_slist_insert_before (text->links, l, new_link);
-					link = new_link;
-					new_link = NULL;
-				}
-				if (plink && html_link_equal (plink, link) && plink->start_offset == link->end_offset) {
-					plink->start_offset = link->start_offset;
-					plink->start_index = link->start_index;
-					text->links = g_slist_remove (text->links, link);
-					html_link_free (link);
-					link = plink;
-				}
-				plink = link;
-				prev = l;
-			}
-		}
+	if (!text->links)
+		text->links = links_new (1);
 
-		if (new_link && prev) {
-			if (prev->next)
-				text->links = g_slist_insert_before (text->links, prev->next, new_link);
-			else
-				text->links = g_slist_append (text->links, new_link);
-		} else if (new_link)
-			text->links = g_slist_prepend (text->links, new_link);
+	link = html_link_new (url, target, start_index, end_index, start_offset, end_offset, FALSE);
+	i = links_bsearch_start (text->links, start_offset);
+
+	/* join with the preceding link */
+	if (i >= 0 && LINK (text->links, i)->end_offset == start_offset && html_link_equal (LINK (text->links, i), link)) {
+		html_link_free (link);
+		link = LINK (text->links, i);
+		link->end_offset = end_offset;
+		link->end_index = end_index;
+	} else {
+		i++;
+		g_ptr_array_insert (text->links, i, link);
+	}
+
+	/* join with the following link */
+	if ((guint) i + 1 < text->links->len) {
+		Link *next = LINK (text->links, i + 1);
+
+		if (next->start_offset == link->end_offset && html_link_equal (link, next)) {
+			link->end_offset = next->end_offset;
+			link->end_index = next->end_index;
+			g_ptr_array_remove_index (text->links, i + 1);
+		}
 	}
 
 	HTML_OBJECT (text)->change |= HTML_CHANGE_RECALC_PI;
@@ -3733,18 +3983,11 @@ gboolean
 html_text_prev_link_offset (HTMLText *text,
                             gint *offset)
 {
-	GSList *l;
+	gint i = get_link_index_at_offset (text, *offset);
 
-	for (l = text->links; l; l = l->next) {
-		Link *link = (Link *) l->data;
-
-		if (link->start_offset <= *offset && *offset <= link->end_offset) {
-			if (l->next) {
-				*offset = ((Link *) l->next->data)->end_offset - 1;
-				return TRUE;
-			}
-			break;
-		}
+	if (i > 0) {
+		*offset = LINK (text->links, i - 1)->end_offset - 1;
+		return TRUE;
 	}
 
 	return FALSE;
@@ -3754,19 +3997,11 @@ gboolean
 html_text_next_link_offset (HTMLText *text,
                             gint *offset)
 {
-	GSList *l, *prev = NULL;
+	gint i = get_link_index_at_offset (text, *offset);
 
-	for (l = text->links; l; l = l->next) {
-		Link *link = (Link *) l->data;
-
-		if (link->start_offset <= *offset && *offset <= link->end_offset) {
-			if (prev) {
-				*offset = ((Link *) prev->data)->start_offset + 1;
-				return TRUE;
-			}
-			break;
-		}
-		prev = l;
+	if (i >= 0 && (guint) i + 1 < text->links->len) {
+		*offset = LINK (text->links, i + 1)->start_offset + 1;
+		return TRUE;
 	}
 
 	return FALSE;
@@ -3776,20 +4011,20 @@ gboolean
 html_text_first_link_offset (HTMLText *text,
                              gint *offset)
 {
-	if (text->links)
-		*offset = ((Link *) g_slist_last (text->links)->data)->start_offset + 1;
+	if (html_text_get_n_links (text))
+		*offset = LINK (text->links, 0)->start_offset + 1;
 
-	return text->links != NULL;
+	return html_text_get_n_links (text) != 0;
 }
 
 gboolean
 html_text_last_link_offset (HTMLText *text,
                             gint *offset)
 {
-	if (text->links)
-		*offset = ((Link *) text->links->data)->end_offset - 1;
+	if (html_text_get_n_links (text))
+		*offset = LINK (text->links, text->links->len - 1)->end_offset - 1;
 
-	return text->links != NULL;
+	return html_text_get_n_links (text) != 0;
 }
 
 gchar *
@@ -67,9 +67,12 @@ struct _HTMLPangoAttrFontSize {
 struct _HTMLText {
 	HTMLObject object;
 
-	/* utf-8 encoded text */
+	/* utf-8 encoded text, read-only while shared with copies */
 	gchar   *text;
 
+	/* reference count of text shared between copies, NULL if not shared */
+	gint    *text_ref;
+
 	/* text length in charactes */
 	guint    text_len;
 
@@ -85,11 +88,13 @@ struct _HTMLText {
 	guint select_start;
 	guint select_length;
 
-	GList *spell_errors;
+	/* SpellError array sorted by offset, NULL if there are none */
+	GArray *spell_errors;
 
 	HTMLTextPangoInfo *pi;
 
-	GSList *links;
+	/* Link pointer array sorted by offset, NULL if there are none */
+	GPtrArray *links;
 	gint focused_link_offset;
 	PangoDirection direction;
 };
@@ -138,6 +143,7 @@ void              html_text_append                       (HTMLText           *te
 							  gint                len);
 void              html_text_set_text                     (HTMLText           *text,
 							  const gchar        *new_text);
+gboolean          html_text_is_shared                    (HTMLText           *text);
 void              html_text_set_font_face                (HTMLText           *text,
 							  HTMLFontFace       *face);
 gint              html_text_get_nb_width                 (HTMLText           *text,
@@ -158,13 +164,16 @@ void              html_text_spell_errors_clear_interval  (HTMLText           *te
 void              html_text_spell_errors_add             (HTMLText           *text,
 							  guint               off,
 							  guint               len);
+guint             html_text_spell_errors_find            (HTMLText           *text,
+							  guint               offset);
 gboolean          html_text_magic_link                   (HTMLText           *text,
 							  HTMLEngine         *engine,
 							  guint               offset);
+gboolean          html_text_magic_links                  (HTMLText           *text,
+							  HTMLEngine         *engine);
 gint              html_text_trail_space_width            (HTMLText           *text,
 							  HTMLPainter        *painter);
-gboolean          html_text_convert_nbsp                 (HTMLText           *text,
-							  gboolean            free_text);
+gboolean          html_text_convert_nbsp                 (HTMLText           *text);
 gint              html_text_get_line_offset              (HTMLText           *text,
 							  HTMLPainter        *painter,
 							  gint                offset);
@@ -238,6 +247,9 @@ gboolean          html_text_get_link_rectangle           (HTMLText           *te
 							  gint               *y2);
 Link             *html_text_get_link_at_offset           (HTMLText           *text,
 							  gint                offset);
+guint             html_text_get_n_links                  (HTMLText           *text);
+Link             *html_text_get_nth_link                 (HTMLText           *text,
+							  guint               n);
 HTMLTextSlave    *html_text_get_slave_at_offset          (HTMLText           *text,
 							  HTMLTextSlave      *start,
 							  gint                 offset);
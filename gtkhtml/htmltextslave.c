@@ -95,6 +95,7 @@ copy (HTMLObject *self,
 	HTML_TEXT_SLAVE (dest)->posStart = HTML_TEXT_SLAVE (self)->posStart;
 	HTML_TEXT_SLAVE (dest)->posLen = HTML_TEXT_SLAVE (self)->posLen;
 	HTML_TEXT_SLAVE (dest)->glyph_items = NULL;
+	HTML_TEXT_SLAVE (dest)->glyph_runs_valid = FALSE;
 }
 
 static inline gint
@@ -424,6 +425,9 @@ hts_fit_line (HTMLObject *o,
 	if (slave->posLen == 0)
 		return HTML_FIT_COMPLETE;
 
+	/* tab widths are stored in the glyph strings below */
+	slave->glyph_runs_valid = FALSE;
+
 	widthLeft = html_painter_engine_to_pango (painter, widthLeft);
 
 	lbw = lwl = w = 0;
@@ -787,6 +791,33 @@ calc_glyph_range_size (HTMLText *text,
 	return FALSE;
 }
 
+static GSList *
+get_glyph_runs (HTMLTextSlave *slave,
+                HTMLPainter *painter)
+{
+	GSList *cur, *glyph_items;
+	gint x = 0;
+
+	/* rebuilding the glyph items resets glyph_runs_valid, fetch them first */
+	glyph_items = html_text_slave_get_glyph_items (slave, painter);
+	if (slave->glyph_runs_valid)
+		return glyph_items;
+
+	for (cur = glyph_items; cur; cur = cur->next) {
+		HTMLTextSlaveGlyphItem *gi = (HTMLTextSlaveGlyphItem *) cur->data;
+		gint i;
+
+		gi->x = x;
+		gi->width = 0;
+		for (i = 0; i < gi->glyph_item.glyphs->num_glyphs; i++)
+			gi->width += gi->glyph_item.glyphs->glyphs[i].geometry.width;
+		x += gi->width;
+	}
+	slave->glyph_runs_valid = TRUE;
+
+	return glyph_items;
+}
+
 static void
 draw_text (HTMLTextSlave *self,
            HTMLPainter *p,
@@ -800,11 +831,12 @@ draw_text (HTMLTextSlave *self,
 {
 	HTMLObject *obj;
 	HTMLText *text = self->owner;
-	GSList *cur;
-	gint run_width;
+	GSList *cur, *runs;
 	gint selection_start_index = 0;
 	gint selection_end_index = 0;
 	gint isect_start, isect_end;
+	gint run_x, run_y, slack;
+	guint se_first;
 	gboolean selection;
 	GdkColor selection_fg, selection_bg;
 	HTMLEngine *e = NULL;
@@ -840,50 +872,73 @@ draw_text (HTMLTextSlave *self,
 
 	/* printf ("draw_text %d %d %d\n", selection_bg.red, selection_bg.green, selection_bg.blue); */
 
-	run_width = 0;
-	for (cur = html_text_slave_get_glyph_items (self, p); cur; cur = cur->next) {
+	runs = get_glyph_runs (self, p);
+	run_x = obj->x + tx;
+	run_y = obj->y + ty + get_ys (text, p);
+
+	/* glyphs may overhang their logical extents (italics, combining marks) */
+	slack = obj->ascent + obj->descent;
+
+	/* the text pass; the pen is the same for all runs, items with their
+	 * own color attribute set it inside html_painter_draw_glyphs () */
+	if (e)
+		html_painter_set_pen (p, &html_colorset_get_color_allocated (e->settings->color_set,
+									     e->painter, HTMLTextColor)->color);
+	for (cur = runs; cur; cur = cur->next) {
 		HTMLTextSlaveGlyphItem *gi = (HTMLTextSlaveGlyphItem *) cur->data;
-		GList *cur_se;
-		gint cur_width;
+		gint gx = run_x + html_painter_pango_to_engine (p, gi->x);
+
+		if (gx + html_painter_pango_to_engine (p, gi->width) + slack < x + tx
+		    || gx - slack > x + tx + width)
+			continue;
 
-		if (e)
-			html_painter_set_pen (p, &html_colorset_get_color_allocated (e->settings->color_set,
-										     e->painter, HTMLTextColor)->color);
-		cur_width = html_painter_draw_glyphs (p, obj->x + tx + html_painter_pango_to_engine (p, run_width),
-						      obj->y + ty + get_ys (text, p), gi->glyph_item.item, gi->glyph_item.glyphs, NULL, NULL);
+		html_painter_draw_glyphs (p, gx, run_y, gi->glyph_item.item, gi->glyph_item.glyphs, NULL, NULL);
+	}
 
-		if (selection) {
+	if (selection) {
+		for (cur = runs; cur; cur = cur->next) {
+			HTMLTextSlaveGlyphItem *gi = (HTMLTextSlaveGlyphItem *) cur->data;
 			gint start_x, width, asc, height;
 			gint cx, cy, cw, ch;
 
 			if (calc_glyph_range_size (text, &gi->glyph_item, selection_start_index, selection_end_index, &start_x, &width, &asc, &height) && width > 0) {
 				html_painter_get_clip_rectangle (p, &cx, &cy, &cw, &ch);
-/*				printf ("run_width; %d start_x %d index %d\n", run_width, start_x, selection_start_index); */
 				html_painter_set_clip_rectangle (p,
-							obj->x + tx + html_painter_pango_to_engine (p, run_width + start_x),
-							obj->y + ty + get_ys (text, p) - html_painter_pango_to_engine (p, asc),
+							run_x + html_painter_pango_to_engine (p, gi->x + start_x),
+							run_y - html_painter_pango_to_engine (p, asc),
 							html_painter_pango_to_engine (p, width),
 							html_painter_pango_to_engine (p, height));
-
-				/* printf ("draw selection %d %d %d at %d, %d\n", selection_bg.red, selection_bg.green, selection_bg.blue,
-				 * obj->x + tx + run_width, obj->y + ty + get_ys (text, p)); */
-				html_painter_draw_glyphs (p, obj->x + tx + html_painter_pango_to_engine (p, run_width),
-							  obj->y + ty + get_ys (text, p), gi->glyph_item.item, gi->glyph_item.glyphs,
+				html_painter_draw_glyphs (p, run_x + html_painter_pango_to_engine (p, gi->x),
+							  run_y, gi->glyph_item.item, gi->glyph_item.glyphs,
 							  &selection_fg, &selection_bg);
 				html_painter_set_clip_rectangle (p, cx, cy, cw, ch);
 			}
 		}
+	}
 
-		for (cur_se = text->spell_errors; e && cur_se; cur_se = cur_se->next) {
+	if (!e || !text->spell_errors)
+		return;
+
+	se_first = html_text_spell_errors_find (text, self->posStart + 1);
+	if (se_first >= text->spell_errors->len)
+		return;
+
+	html_painter_set_pen (p, &html_colorset_get_color_allocated (e->settings->color_set,
+								     p, HTMLSpellErrorColor)->color);
+	for (cur = runs; cur; cur = cur->next) {
+		HTMLTextSlaveGlyphItem *gi = (HTMLTextSlaveGlyphItem *) cur->data;
+		guint i_se;
+
+		for (i_se = se_first; i_se < text->spell_errors->len; i_se++) {
 			SpellError *se;
 			guint ma, mi;
 
-			se = (SpellError *) cur_se->data;
+			se = &g_array_index (text->spell_errors, SpellError, i_se);
 			ma = MAX (se->off, self->posStart);
 			mi = MIN (se->off + se->len, self->posStart + self->posLen);
 
 			if (ma < mi) {
-				gint width, height, asc, start_x;
+				gint width, start_x;
 
 				gchar *end;
 				gchar *start;
@@ -895,20 +950,16 @@ draw_text (HTMLTextSlave *self,
 				se_start_index = start - text->text;
 				se_end_index = end - text->text;
 
-				if (calc_glyph_range_size (text, &gi->glyph_item, se_start_index, se_end_index, &start_x, &width, &asc, &height)) {
-					html_painter_set_pen (p, &html_colorset_get_color_allocated (e->settings->color_set,
-												     p, HTMLSpellErrorColor)->color);
+				if (calc_glyph_range_size (text, &gi->glyph_item, se_start_index, se_end_index, &start_x, &width, NULL, NULL)) {
 					/* printf ("spell error: %s\n", html_text_get_text (slave->owner, off)); */
 
-					html_painter_draw_spell_error (p, obj->x + tx + html_painter_pango_to_engine (p, run_width + start_x),
-								       obj->y + ty + get_ys (self->owner, p), html_painter_pango_to_engine (p, width));
+					html_painter_draw_spell_error (p, run_x + html_painter_pango_to_engine (p, gi->x + start_x),
+								       run_y, html_painter_pango_to_engine (p, width));
 				}
 			}
 			if (se->off > self->posStart + self->posLen)
 				break;
 		}
-
-		run_width += cur_width;
 	}
 }
 
@@ -1138,6 +1189,7 @@ clear_glyph_items (HTMLTextSlave *slave)
 		glyph_items_destroy (slave->glyph_items);
 		slave->glyph_items = NULL;
 	}
+	slave->glyph_runs_valid = FALSE;
 }
 
 static void
@@ -1204,6 +1256,7 @@ html_text_slave_init (HTMLTextSlave *slave,
 	slave->charStart  = NULL;
 	slave->pi         = NULL;
 	slave->glyph_items = NULL;
+	slave->glyph_runs_valid = FALSE;
 
 	/* text slaves have always min_width 0 */
 	object->min_width = 0;
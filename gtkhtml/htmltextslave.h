@@ -38,6 +38,7 @@ struct _HTMLTextSlave {
 
 	HTMLTextPangoInfo *pi;
 	GSList *glyph_items;
+	gboolean glyph_runs_valid;
 };
 
 struct _HTMLTextSlaveClass {
@@ -48,6 +49,10 @@ struct _HTMLTextSlaveGlyphItem {
 	PangoGlyphItem glyph_item;
 	PangoGlyphUnit *widths;
 
+	/* run position and width in pango units, see draw_text () */
+	gint x;
+	gint width;
+
 	HTMLTextSlaveGlyphItemType type;
 };
 
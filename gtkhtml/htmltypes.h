@@ -41,6 +41,7 @@ typedef struct _HTMLButtonClass HTMLButtonClass;
 typedef struct _HTMLCheckBox HTMLCheckBox;
 typedef struct _HTMLCheckBoxClass HTMLCheckBoxClass;
 typedef struct _HTMLClue HTMLClue;
+typedef struct _HTMLCluePositionIndex HTMLCluePositionIndex;
 typedef struct _HTMLClueAligned HTMLClueAligned;
 typedef struct _HTMLClueAlignedClass HTMLClueAlignedClass;
 typedef struct _HTMLClueClass HTMLClueClass;
@@ -55,7 +56,6 @@ typedef struct _HTMLColorSet HTMLColorSet;
 typedef struct _HTMLCursor HTMLCursor;
 typedef struct _HTMLCursorRectagle HTMLCursorRectangle;
 typedef struct _HTMLDrawQueue HTMLDrawQueue;
-typedef struct _HTMLDrawQueueClearElement HTMLDrawQueueClearElement;
 typedef struct _HTMLEmbedded HTMLEmbedded;
 typedef struct _HTMLEmbeddedClass HTMLEmbeddedClass;
 typedef struct _HTMLEngine HTMLEngine;
@@ -82,6 +82,7 @@ typedef struct _HTMLIFrameClass HTMLIFrameClass;
 typedef struct _HTMLImage HTMLImage;
 typedef struct _HTMLImageAnimation HTMLImageAnimation;
 typedef struct _HTMLImageClass HTMLImageClass;
+typedef struct _HTMLImageDecoder HTMLImageDecoder;
 typedef struct _HTMLImageFactory HTMLImageFactory;
 typedef struct _HTMLImageInput HTMLImageInput;
 typedef struct _HTMLImageInputClass HTMLImageInputClass;
@@ -94,11 +95,13 @@ typedef struct _HTMLMapClass HTMLMapClass;
 typedef struct _HTMLObject HTMLObject;
 typedef struct _HTMLObjectClass HTMLObjectClass;
 typedef struct _HTMLObjectClearRectangle HTMLObjectClearRectangle;
+typedef struct _HTMLPageSplitRange HTMLPageSplitRange;
 typedef struct _HTMLPainter HTMLPainter;
 typedef struct _HTMLPainterClass HTMLPainterClass;
 typedef struct _HTMLPangoAttrFontSize HTMLPangoAttrFontSize;
 typedef struct _HTMLPangoProperties HTMLPangoProperties;
 typedef struct _HTMLPoint HTMLPoint;
+typedef struct _HTMLPrintPreview HTMLPrintPreview;
 typedef struct _HTMLPrinter HTMLPrinter;
 typedef struct _HTMLPrinterClass HTMLPrinterClass;
 typedef struct _HTMLRadio HTMLRadio;
@@ -150,6 +153,9 @@ typedef void     (* HTMLUndoFunc)               (HTMLEngine        *engine,
 						 HTMLUndoDirection  dir,
 						 guint              position_after);
 typedef void     (* HTMLUndoDataDestroyFunc)    (HTMLUndoData      *data);
+typedef gboolean (* HTMLUndoDataMergeFunc)      (HTMLUndoData      *data,
+						 HTMLUndoData      *next);
+typedef gsize    (* HTMLUndoDataSizeFunc)       (HTMLUndoData      *data);
 
 /* FIXME */
 typedef GtkHTMLSaveReceiverFn HTMLEngineSaveReceiverFn;
@@ -20,6 +20,7 @@
 */
 
 #include <config.h>
+#include <string.h>
 #include "htmlundo-action.h"
 #include "htmlundo.h"
 
@@ -43,6 +44,7 @@ html_undo_action_new (const gchar *description,
 	action->data           = data;
 	action->position       = position;
 	action->position_after = position_after;
+	action->size           = 0;
 #ifdef UNDO_DEBUG
 	action->is_level       = FALSE;
 #endif
@@ -59,3 +61,12 @@ html_undo_action_destroy (HTMLUndoAction *action)
 	g_free (action->description);
 	g_free (action);
 }
+
+gsize
+html_undo_action_get_size (HTMLUndoAction *action)
+{
+	g_return_val_if_fail (action != NULL, 0);
+
+	return sizeof (HTMLUndoAction) + strlen (action->description) + 1
+		+ (action->data ? html_undo_data_get_size (action->data) : 0);
+}
@@ -34,6 +34,7 @@ struct _HTMLUndoAction {
 	HTMLUndoData *data;             /* Data to pass to the action function when it's called.  */
 	guint position;                 /* Cursor position, to be set when the action is executed.  */
 	guint position_after;           /* cursor position to go after undo action executed */
+	gsize size;                     /* accounted size, valid while on the top level undo stack */
 
 #ifdef UNDO_DEBUG
 	gboolean is_level;
@@ -46,5 +47,6 @@ HTMLUndoAction *html_undo_action_new      (const gchar            *description,
 					   guint                   position,
 					   guint                   position_after);
 void            html_undo_action_destroy  (HTMLUndoAction         *action);
+gsize           html_undo_action_get_size (HTMLUndoAction         *action);
 
 #endif /* _HTML_UNDO_ACTION_H */
@@ -20,6 +20,7 @@
 */
 
 #include <config.h>
+#include <string.h>
 #include "htmlcursor.h"
 #include "htmlengine.h"
 #include "htmlundo.h"
@@ -44,6 +45,12 @@ struct _HTMLUndo {
 	gint      step_counter;
 
 	gint      freeze_count; /* Freeze counter for im context */
+
+	/* memory accounting of the top level undo stack */
+	gsize     bytes;
+	gsize     max_bytes;    /* 0 means no byte budget */
+	guint     evicted_count;
+	guint     coalesced_count;
 };
 
 #ifdef UNDO_DEBUG
@@ -55,6 +62,7 @@ static void html_undo_debug (HTMLUndo *undo);
 
 static void add_used_and_redo_to_undo (HTMLUndo *undo, HTMLEngine *engine);
 static void level_destroy (HTMLUndoData *data);
+static gboolean action_merge (HTMLUndoAction *action, HTMLUndoAction *next);
 
 inline static void
 stack_copy (HTMLUndoStack *src,
@@ -169,6 +177,7 @@ action_do_and_destroy_undo (HTMLEngine *engine,
 
 	undo->undo.stack = g_list_remove (first, first->data);
 	if (undo->level == 0) {
+		undo->bytes -= action->size;
 		undo->undo_used.stack = g_list_prepend (undo->undo_used.stack, action);
 		undo->step_counter--;
 
@@ -257,6 +266,25 @@ html_undo_discard_redo (HTMLUndo *undo)
 	undo->redo.size = 0;
 }
 
+static void
+remove_oldest_undo_action (HTMLUndo *undo)
+{
+	HTMLUndoAction *last_action;
+	GList *last;
+
+	last = g_list_last (undo->undo.stack);
+	last_action = (HTMLUndoAction *) last->data;
+
+	undo->undo.stack = g_list_remove_link (undo->undo.stack, last);
+	g_list_free (last);
+
+	undo->bytes -= last_action->size;
+	html_undo_action_destroy (last_action);
+
+	undo->undo.size--;
+	undo->evicted_count++;
+}
+
 void
 html_undo_add_undo_action (HTMLUndo *undo,
                             HTMLEngine *engine,
@@ -269,32 +297,45 @@ html_undo_add_undo_action (HTMLUndo *undo,
 		return;
 
 	if (undo->level == 0) {
+		/* coalesce adjacent steps (typing) unless undo/redo history is being rearranged
+		 * or the top step is the one the document was saved at */
+		if (undo->in_redo == 0 && undo->redo.size == 0 && undo->undo_used.stack == NULL
+		    && undo->undo.stack && html_undo_get_step_count (undo) != engine->saved_step_count
+		    && action_merge (HTML_UNDO_ACTION (undo->undo.stack->data), action)) {
+			HTMLUndoAction *top = HTML_UNDO_ACTION (undo->undo.stack->data);
+
+			html_undo_action_destroy (action);
+			undo->bytes -= top->size;
+			top->size = html_undo_action_get_size (top);
+			undo->bytes += top->size;
+			undo->coalesced_count++;
+
+			html_engine_emit_undo_changed (engine);
+			return;
+		}
+
 		if (undo->in_redo == 0 && undo->redo.size > 0)
 			add_used_and_redo_to_undo (undo, engine);
 
-		if (undo->undo.size >= HTML_UNDO_LIMIT) {
-			HTMLUndoAction *last_action;
-			GList *last;
-
-			last = g_list_last (undo->undo.stack);
-			last_action = (HTMLUndoAction *) last->data;
-
-			undo->undo.stack = g_list_remove_link (undo->undo.stack, last);
-			g_list_free (last);
-
-			html_undo_action_destroy (last_action);
-
-			undo->undo.size--;
-		}
+		if (undo->undo.size >= HTML_UNDO_LIMIT)
+			remove_oldest_undo_action (undo);
 
 		undo->step_counter++;
 
 		html_engine_emit_undo_changed (engine);
+
+		action->size = html_undo_action_get_size (action);
+		undo->bytes += action->size;
 	}
 
 	undo->undo.stack = g_list_prepend (undo->undo.stack, action);
 	undo->undo.size++;
 
+	/* keep at least the newest step, even if it alone exceeds the budget */
+	if (undo->level == 0)
+		while (undo->max_bytes && undo->bytes > undo->max_bytes && undo->undo.size > 1)
+			remove_oldest_undo_action (undo);
+
 #ifdef UNDO_DEBUG
 	if (!undo->level) {
 		printf ("ADD UNDO\n");
@@ -344,6 +385,71 @@ html_undo_thaw (HTMLUndo *undo)
 	undo->freeze_count--;
 }
 
+/**
+ * html_undo_set_max_bytes:
+ * @undo: an #HTMLUndo
+ * @max_bytes: byte budget of the undo history, 0 for unlimited
+ *
+ * Limits memory held by the undo history. When the budget is exceeded
+ * the oldest undo steps are dropped, the newest step is always kept.
+ **/
+void
+html_undo_set_max_bytes (HTMLUndo *undo,
+                         gsize max_bytes)
+{
+	g_return_if_fail (undo != NULL);
+
+	undo->max_bytes = max_bytes;
+
+	if (undo->level == 0)
+		while (undo->max_bytes && undo->bytes > undo->max_bytes && undo->undo.size > 1)
+			remove_oldest_undo_action (undo);
+}
+
+gsize
+html_undo_get_max_bytes (HTMLUndo *undo)
+{
+	return undo->max_bytes;
+}
+
+gsize
+html_undo_get_bytes (HTMLUndo *undo)
+{
+	return undo->bytes;
+}
+
+guint
+html_undo_get_evicted_count (HTMLUndo *undo)
+{
+	return undo->evicted_count;
+}
+
+guint
+html_undo_get_coalesced_count (HTMLUndo *undo)
+{
+	return undo->coalesced_count;
+}
+
+/* merges next into action if both are adjacent steps of the same kind */
+static gboolean
+action_merge (HTMLUndoAction *action,
+              HTMLUndoAction *next)
+{
+	if (action->function != next->function
+	    || !action->data || !next->data
+	    || !action->data->merge || action->data->ref_count != 1
+	    || action->position != next->position_after
+	    || strcmp (action->description, next->description))
+		return FALSE;
+
+	if (!(*action->data->merge) (action->data, next->data))
+		return FALSE;
+
+	action->position = next->position;
+
+	return TRUE;
+}
+
 /*
  * undo levels
  *
@@ -373,6 +479,7 @@ struct _HTMLUndoLevel {
 typedef struct _HTMLUndoLevel HTMLUndoLevel;
 
 static void undo_step_action (HTMLEngine *e, HTMLUndoData *data, HTMLUndoDirection dir, guint position_after);
+static gboolean level_merge  (HTMLUndoData *data, HTMLUndoData *next);
 static void redo_level_begin (HTMLUndo *undo, const gchar *redo_desription, const gchar *undo_desription);
 static void redo_level_end   (HTMLUndo *undo);
 
@@ -392,6 +499,37 @@ level_destroy (HTMLUndoData *data)
 	g_free (level->description[HTML_UNDO_REDO]);
 }
 
+static void
+level_update_size (HTMLUndoLevel *level)
+{
+	GList *l;
+
+	level->data.size = sizeof (HTMLUndoLevel);
+	for (l = level->stack.stack; l; l = l->next)
+		level->data.size += html_undo_action_get_size (HTML_UNDO_ACTION (l->data));
+}
+
+/* single action levels (typed text) are merged when their actions merge */
+static gboolean
+level_merge (HTMLUndoData *data,
+             HTMLUndoData *next)
+{
+	HTMLUndoLevel *level = HTML_UNDO_LEVEL (data);
+	HTMLUndoLevel *next_level = HTML_UNDO_LEVEL (next);
+
+	if (level->stack.size != 1 || next_level->stack.size != 1
+	    || g_strcmp0 (level->description[HTML_UNDO_UNDO], next_level->description[HTML_UNDO_UNDO])
+	    || g_strcmp0 (level->description[HTML_UNDO_REDO], next_level->description[HTML_UNDO_REDO]))
+		return FALSE;
+
+	if (!action_merge (HTML_UNDO_ACTION (level->stack.stack->data), HTML_UNDO_ACTION (next_level->stack.stack->data)))
+		return FALSE;
+
+	level_update_size (level);
+
+	return TRUE;
+}
+
 static HTMLUndoLevel *
 level_new (HTMLUndo *undo,
            HTMLUndoStack *stack,
@@ -405,6 +543,7 @@ level_new (HTMLUndo *undo,
 	stack_copy (stack, &nl->stack);
 
 	nl->data.destroy                 = level_destroy;
+	nl->data.merge                   = level_merge;
 	nl->parent_undo                  = undo;
 	nl->description[HTML_UNDO_UNDO] = g_strdup (undo_description);
 	nl->description[HTML_UNDO_REDO] = g_strdup (redo_description);
@@ -463,6 +602,8 @@ redo_level_end (HTMLUndo *undo)
 	if (save_redo.size) {
 		HTMLUndoAction *action;
 
+		level_update_size (level);
+
 		/* we use position from last redo action on the stack */
 		action = (HTMLUndoAction *) save_redo.stack->data;
 		action = html_undo_action_new (
@@ -510,6 +651,8 @@ html_undo_level_end (HTMLUndo *undo,
 	if (save_undo.size) {
 		HTMLUndoAction *action;
 
+		level_update_size (level);
+
 		/* we use position from last undo action on the stack */
 		action = html_undo_action_new (level->description[HTML_UNDO_UNDO],
 					       undo_step_action,
@@ -579,6 +722,20 @@ html_undo_data_init (HTMLUndoData *data)
 {
 	data->ref_count = 1;
 	data->destroy   = NULL;
+	data->merge     = NULL;
+	data->get_size  = NULL;
+	data->size      = 0;
+}
+
+gsize
+html_undo_data_get_size (HTMLUndoData *data)
+{
+	g_assert (data);
+
+	if (data->get_size)
+		return (* data->get_size) (data);
+
+	return data->size ? data->size : sizeof (HTMLUndoData);
 }
 
 void
@@ -693,6 +850,7 @@ html_undo_reset (HTMLUndo *undo)
 	undo->redo.size  = 0;
 
 	undo->step_counter = 0;
+	undo->bytes = 0;
 }
 
 gboolean
@@ -24,13 +24,19 @@
 
 #define HTML_UNDO_LIMIT 1024
 
+/* maximal number of typed characters coalesced into one undo step */
+#define HTML_UNDO_COALESCE_LIMIT 128
+
 #include "htmlundo-action.h"
 #include "htmlenums.h"
 
 #define HTML_UNDO_DATA(x) ((HTMLUndoData *) x)
 struct _HTMLUndoData {
 	HTMLUndoDataDestroyFunc destroy;
+	HTMLUndoDataMergeFunc   merge;  /* optional, absorbs data of a following adjacent action */
 	gint ref_count;
+	gsize size;                     /* bytes held by the data, used for the undo byte budget */
+	HTMLUndoDataSizeFunc    get_size; /* optional, computes size for data owning other memory */
 };
 
 HTMLUndo *html_undo_new              (void);
@@ -59,12 +65,19 @@ void      html_undo_level_end        (HTMLUndo          *undo,
 gint      html_undo_get_step_count   (HTMLUndo          *undo);
 void      html_undo_freeze           (HTMLUndo          *undo);
 void      html_undo_thaw             (HTMLUndo          *undo);
+void      html_undo_set_max_bytes    (HTMLUndo          *undo,
+				      gsize              max_bytes);
+gsize     html_undo_get_max_bytes    (HTMLUndo          *undo);
+gsize     html_undo_get_bytes        (HTMLUndo          *undo);
+guint     html_undo_get_evicted_count   (HTMLUndo       *undo);
+guint     html_undo_get_coalesced_count (HTMLUndo       *undo);
 /*
  *  Undo Data
  */
 void               html_undo_data_init          (HTMLUndoData      *data);
 void               html_undo_data_ref           (HTMLUndoData      *data);
 void               html_undo_data_unref         (HTMLUndoData      *data);
+gsize              html_undo_data_get_size      (HTMLUndoData      *data);
 /*
  * Undo Direction
  */
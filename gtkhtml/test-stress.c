@@ -1,6 +1,7 @@
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <glib/gstdio.h>
 #include <gtk/gtk.h>
 #include "gtkhtml.h"
 #include "htmlclue.h"
@@ -26,10 +27,19 @@ typedef struct {
 } Test;
 
 static gint test_level_1 (GtkHTML *html);
+static gint test_plain_export_speed (GtkHTML *html);
+static gint test_font_face_layout_speed (GtkHTML *html);
+static gint test_paste_text_speed (GtkHTML *html);
+static gint test_render_pdf_speed (GtkHTML *html);
 
 static Test tests[] = {
 	{ "cursor movement", NULL },
 	{ "level 1 - cut/copy/paste", test_level_1 },
+	{ "performance", NULL },
+	{ "plain text export, serial and parallel", test_plain_export_speed },
+	{ "layout with many font face changes", test_font_face_layout_speed },
+	{ "paste of large plain text", test_paste_text_speed },
+	{ "headless PDF rendering, serial and batched", test_render_pdf_speed },
 	{ NULL, NULL }
 };
 
@@ -225,6 +235,231 @@ static gint test_level_1 (GtkHTML *html)
 	return TRUE;
 }
 
+static gboolean
+string_save_receiver (const HTMLEngine *engine,
+                      const gchar *data,
+                      gsize len,
+                      gpointer user_data)
+{
+	g_string_append_len ((GString *) user_data, data, len);
+
+	return TRUE;
+}
+
+static gint test_plain_export_speed (GtkHTML *html)
+{
+	GString *doc, *serial, *parallel;
+	GTimer *timer;
+	gdouble serial_time, parallel_time;
+	gint i, ret;
+
+	set_format (html, TRUE);
+
+	doc = g_string_new (NULL);
+	for (i = 0; i < 5000; i++)
+		g_string_append_printf (doc,
+					"<p>Paragraph %d of a long message, with enough words in it to be wrapped "
+					"several times when it is exported as plain text for the indexer.</p>%s",
+					i, i % 10 == 0 ? "<ul><li>item</li><li>another item</li></ul>" : "");
+
+	gtk_html_set_editable (html, FALSE);
+	gtk_html_load_from_string (html, doc->str, doc->len);
+	g_string_free (doc, TRUE);
+
+	serial = g_string_new (NULL);
+	parallel = g_string_new (NULL);
+	timer = g_timer_new ();
+
+	html_engine_save_plain (html->engine, string_save_receiver, serial);
+	serial_time = g_timer_elapsed (timer, NULL);
+
+	g_timer_start (timer);
+	html_engine_save_plain_parallel (html->engine, string_save_receiver, parallel, 0);
+	parallel_time = g_timer_elapsed (timer, NULL);
+
+	printf ("serial: %.3fs parallel: %.3fs (%u threads) %.1f MB\n", serial_time, parallel_time,
+		g_get_num_processors (), serial->len / (1024.0 * 1024.0));
+
+	ret = strcmp (serial->str, parallel->str);
+	g_timer_destroy (timer);
+	g_string_free (serial, TRUE);
+	g_string_free (parallel, TRUE);
+	gtk_html_set_editable (html, TRUE);
+
+	return (ret == 0) ? TRUE : FALSE;
+}
+
+static gdouble
+time_layout (GtkHTML *html,
+             gdouble magnification)
+{
+	GTimer *timer;
+	gdouble elapsed;
+
+	timer = g_timer_new ();
+	gtk_html_set_magnification (html, magnification);
+	html_engine_calc_size (html->engine, NULL);
+	elapsed = g_timer_elapsed (timer, NULL);
+	g_timer_destroy (timer);
+
+	return elapsed;
+}
+
+static gint test_font_face_layout_speed (GtkHTML *html)
+{
+	static const gchar *faces[] = {
+		"Sans", "Serif", "Monospace", "DejaVu Sans", "DejaVu Serif",
+		"Liberation Sans", "Liberation Serif", "Cantarell", "Nonexistent Face", "Serif, Sans"
+	};
+	GString *doc;
+	gdouble first, zoomed, back;
+	gint i;
+
+	set_format (html, TRUE);
+
+	doc = g_string_new (NULL);
+	for (i = 0; i < 3000; i++)
+		g_string_append_printf (doc,
+					"<font face=\"%s\" size=%d>%sword %d%s</font> ",
+					faces[i % G_N_ELEMENTS (faces)], 1 + i % 7,
+					i % 3 == 0 ? "<b>" : i % 3 == 1 ? "<i>" : "",
+					i,
+					i % 3 == 0 ? "</b>" : i % 3 == 1 ? "</i>" : "");
+
+	gtk_html_set_editable (html, FALSE);
+	gtk_html_load_from_string (html, doc->str, doc->len);
+	g_string_free (doc, TRUE);
+
+	first = time_layout (html, 1.0);
+	zoomed = time_layout (html, 1.5);
+	back = time_layout (html, 1.0);
+
+	printf ("layout: %.3fs zoomed: %.3fs back to 100%%: %.3fs\n", first, zoomed, back);
+
+	gtk_html_set_editable (html, TRUE);
+
+	return html->engine->clue != NULL;
+}
+
+static GString *
+log_text (gsize size)
+{
+	GString *text;
+	gint i;
+
+	text = g_string_new (NULL);
+	for (i = 0; text->len < size; i++)
+		g_string_append_printf (text, "%08d [worker-%d] request handled in %d ms, status %d%s\n",
+					i, i % 16, (i * 7) % 1000, i % 50 ? 200 : 500, i % 100 ? "" : "\n");
+
+	return text;
+}
+
+static gdouble
+paste_throughput (GtkHTML *html,
+                  GString *text,
+                  gboolean per_line)
+{
+	GTimer *timer;
+	gdouble elapsed;
+
+	gtk_html_load_empty (html);
+	timer = g_timer_new ();
+	if (per_line) {
+		const gchar *line, *nl;
+
+		for (line = text->str; (nl = strchr (line, '\n')); line = nl + 1) {
+			html_engine_paste_text (html->engine, line, g_utf8_pointer_to_offset (line, nl));
+			html_engine_insert_empty_paragraph (html->engine);
+		}
+	} else
+		html_engine_paste_text (html->engine, text->str, g_utf8_strlen (text->str, text->len));
+	html_engine_calc_size (html->engine, NULL);
+	elapsed = g_timer_elapsed (timer, NULL);
+	g_timer_destroy (timer);
+
+	return text->len / (1024.0 * 1024.0) / elapsed;
+}
+
+static gint test_paste_text_speed (GtkHTML *html)
+{
+	GString *text;
+	gdouble per_line, bulk;
+
+	set_format (html, FALSE);
+
+	/* both paths paste the same text, so that their rates compare */
+	text = log_text (1024 * 1024);
+
+	per_line = paste_throughput (html, text, TRUE);
+	bulk = paste_throughput (html, text, FALSE);
+
+	printf ("per line: %.2f MB/s bulk: %.2f MB/s (%.1f MB)\n", per_line, bulk, text->len / (1024.0 * 1024.0));
+
+	g_string_free (text, TRUE);
+
+	return html_object_get_recursive_length (html->engine->clue) > 0;
+}
+
+#define RENDER_PDF_DOCUMENTS 32
+
+static gint test_render_pdf_speed (GtkHTML *html)
+{
+	GString *doc;
+	const gchar *srcs[RENDER_PDF_DOCUMENTS];
+	gchar *filenames[RENDER_PDF_DOCUMENTS];
+	gint n_pages[RENDER_PDF_DOCUMENTS];
+	gchar *dir;
+	GTimer *timer;
+	gdouble serial_time, batch_time;
+	gint i, serial_pages = 0, batch_pages = 0;
+	gboolean ret;
+
+	doc = g_string_new (NULL);
+	for (i = 0; i < 400; i++)
+		g_string_append_printf (doc,
+					"<p>Paragraph %d of a <b>report</b> rendered to PDF in a batch job, with "
+					"enough <i>words</i> in it to be wrapped several times on the page.</p>%s",
+					i, i % 20 == 0 ? "<table border=1><tr><td>cell</td><td>another cell</td></tr></table>" : "");
+
+	dir = g_dir_make_tmp ("gtkhtml-pdf-XXXXXX", NULL);
+	if (dir == NULL)
+		return FALSE;
+
+	for (i = 0; i < RENDER_PDF_DOCUMENTS; i++) {
+		gchar *name = g_strdup_printf ("%d.pdf", i);
+
+		srcs[i] = doc->str;
+		filenames[i] = g_build_filename (dir, name, NULL);
+		g_free (name);
+	}
+
+	timer = g_timer_new ();
+	for (i = 0; i < RENDER_PDF_DOCUMENTS; i++)
+		serial_pages += gtk_html_render_pdf (srcs[i], -1, filenames[i], 595, 842);
+	serial_time = g_timer_elapsed (timer, NULL);
+
+	g_timer_start (timer);
+	ret = gtk_html_render_pdf_batch (srcs, (const gchar * const *) filenames, RENDER_PDF_DOCUMENTS, 595, 842, n_pages);
+	batch_time = g_timer_elapsed (timer, NULL);
+	for (i = 0; i < RENDER_PDF_DOCUMENTS; i++)
+		batch_pages += n_pages[i];
+
+	printf ("serial: %.1f pages/s batch: %.1f pages/s (%u threads) %d pages\n",
+		serial_pages / serial_time, batch_pages / batch_time, g_get_num_processors (), batch_pages);
+
+	for (i = 0; i < RENDER_PDF_DOCUMENTS; i++) {
+		g_unlink (filenames[i]);
+		g_free (filenames[i]);
+	}
+	g_rmdir (dir);
+	g_free (dir);
+	g_timer_destroy (timer);
+	g_string_free (doc, TRUE);
+
+	return ret && serial_pages == batch_pages;
+}
+
 gint main (gint argc, gchar *argv[])
 {
 	GtkWidget *win, *html_widget, *sw;
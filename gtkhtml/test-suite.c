@@ -1,21 +1,29 @@
 #include <string.h>
 #include <stdio.h>
+#include <unistd.h>
+#include <glib/gstdio.h>
 #include <gtk/gtk.h>
 #include "gtkhtml.h"
+#include "gtkhtmldebug.h"
 #include "htmlclue.h"
+#include "htmlcolor.h"
 #include "htmlclueflow.h"
 #include "htmlcluev.h"
 #include "htmlcursor.h"
+#include "htmldrawqueue.h"
 #include "htmlengine.h"
 #include "htmlengine-edit.h"
 #include "htmlengine-edit-cut-and-paste.h"
 #include "htmlengine-edit-movement.h"
 #include "htmlengine-edit-text.h"
 #include "htmlengine-save.h"
+#include "htmlimage.h"
+#include "htmlinterval.h"
 #include "htmlselection.h"
 #include "htmltable.h"
 #include "htmltablecell.h"
 #include "htmltext.h"
+#include "htmlundo.h"
 
 typedef struct {
 	const gchar *name;
@@ -41,6 +49,25 @@ static gint test_indentation_plain_text (GtkHTML *html);
 static gint test_indentation_plain_text_rtl (GtkHTML *html);
 static gint test_table_cell_parsing (GtkHTML *html);
 static gint test_delete_around_table (GtkHTML *html);
+static gint test_text_links_and_spell_errors (GtkHTML *html);
+static gint test_undo_typing_coalescing (GtkHTML *html);
+static gint test_undo_coalescing_after_save (GtkHTML *html);
+static gint test_cut_paste_shared_text (GtkHTML *html);
+static gint test_buffered_save (GtkHTML *html);
+static gint test_parallel_plain_save (GtkHTML *html);
+static gint test_shared_image_cache (GtkHTML *html);
+static gint test_lazy_image_loading (GtkHTML *html);
+static gint test_draw_queue_coalescing (GtkHTML *html);
+static gint test_cursor_position_index (GtkHTML *html);
+static gint test_cached_recursive_lengths (GtkHTML *html);
+static gint test_batch_edit (GtkHTML *html);
+static gint test_paste_multiline_text (GtkHTML *html);
+static gint test_magic_links_scan (GtkHTML *html);
+static gint test_print_snapshot (GtkHTML *html);
+static gint test_render_pdf_batch (GtkHTML *html);
+static gint test_page_split_index (GtkHTML *html);
+static gint test_page_images (GtkHTML *html);
+static gint test_differential_selection (GtkHTML *html);
 
 static Test tests[] = {
 	{ "cursor movement", NULL },
@@ -63,6 +90,25 @@ static Test tests[] = {
 	{ "indentation in plain text (RTL)", test_indentation_plain_text_rtl },
 	{ "table cell parsing", test_table_cell_parsing },
 	{ "delete around table", test_delete_around_table },
+	{ "text links and spell errors lookup", test_text_links_and_spell_errors },
+	{ "undo of coalesced typing", test_undo_typing_coalescing },
+	{ "typing after save is not coalesced", test_undo_coalescing_after_save },
+	{ "cut, paste and undo with shared text", test_cut_paste_shared_text },
+	{ "buffered save", test_buffered_save },
+	{ "parallel plain text save", test_parallel_plain_save },
+	{ "image cache shared between widgets", test_shared_image_cache },
+	{ "lazy image loading", test_lazy_image_loading },
+	{ "draw queue coalescing", test_draw_queue_coalescing },
+	{ "cursor position index", test_cursor_position_index },
+	{ "cached recursive lengths", test_cached_recursive_lengths },
+	{ "batched text insertion", test_batch_edit },
+	{ "paste of multi-line text", test_paste_multiline_text },
+	{ "magic links in one scan", test_magic_links_scan },
+	{ "printing leaves the view layout alone", test_print_snapshot },
+	{ "headless PDF rendering, single and batched", test_render_pdf_batch },
+	{ "page splits from the break index", test_page_split_index },
+	{ "print preview page images", test_page_images },
+	{ "differential selection update", test_differential_selection },
 	{ NULL, NULL }
 };
 
@@ -720,6 +766,863 @@ test_table_cell_parsing (GtkHTML *html)
 	return TRUE;
 }
 
+static gint test_text_links_and_spell_errors (GtkHTML *html)
+{
+	HTMLColor *color;
+	HTMLText *text;
+	gint offset;
+	gboolean ret = TRUE;
+
+	color = html_color_new ();
+	text = HTML_TEXT (html_text_new ("abc def ghi jkl", GTK_HTML_FONT_STYLE_DEFAULT, color));
+	html_color_unref (color);
+
+	/* added out of order, adjacent equal links are joined */
+	html_text_add_link (text, html->engine, (gchar *) "http://c/", NULL, 12, 15);
+	html_text_add_link (text, html->engine, (gchar *) "http://a/", NULL, 0, 3);
+	html_text_add_link (text, html->engine, (gchar *) "http://b/", NULL, 4, 7);
+	html_text_add_link (text, html->engine, (gchar *) "http://b/", NULL, 7, 8);
+
+	if (html_text_get_n_links (text) != 3
+	    || html_text_get_nth_link (text, 1)->start_offset != 4
+	    || html_text_get_nth_link (text, 1)->end_offset != 8
+	    || html_text_get_link_at_offset (text, 10) != NULL
+	    || g_strcmp0 (html_text_get_link_at_offset (text, 13)->url, "http://c/"))
+		ret = FALSE;
+
+	offset = 5;
+	if (!html_text_next_link_offset (text, &offset) || offset != 13
+	    || !html_text_prev_link_offset (text, &offset) || offset != 7
+	    || !html_text_prev_link_offset (text, &offset) || offset != 2
+	    || html_text_prev_link_offset (text, &offset))
+		ret = FALSE;
+
+	html_text_spell_errors_add (text, 8, 3);
+	html_text_spell_errors_add (text, 0, 3);
+	if (html_text_spell_errors_find (text, 2) != 0
+	    || html_text_spell_errors_find (text, 5) != 1
+	    || html_text_spell_errors_find (text, 12) != 2)
+		ret = FALSE;
+
+	html_object_destroy (HTML_OBJECT (text));
+
+	return ret;
+}
+
+static gint test_undo_typing_coalescing (GtkHTML *html)
+{
+	gchar *before, *after;
+	guint coalesced;
+	gint ret;
+
+	load_editable (html, "text");
+	html_engine_end_of_document (html->engine);
+	before = get_plain (html);
+	coalesced = html_undo_get_coalesced_count (html->engine->undo);
+
+	html_engine_insert_text (html->engine, "a", 1);
+	html_engine_insert_text (html->engine, "b", 1);
+	html_engine_insert_text (html->engine, "c", 1);
+
+	if (html_undo_get_coalesced_count (html->engine->undo) != coalesced + 2
+	    || html_undo_get_bytes (html->engine->undo) == 0) {
+		g_free (before);
+		return FALSE;
+	}
+
+	html_engine_undo (html->engine);
+	after = get_plain (html);
+	ret = g_strcmp0 (before, after);
+	g_free (before);
+	g_free (after);
+
+	return (ret == 0) ? TRUE : FALSE;
+}
+
+static gint test_undo_coalescing_after_save (GtkHTML *html)
+{
+	load_editable (html, "text");
+	html_engine_end_of_document (html->engine);
+
+	html_engine_insert_text (html->engine, "a", 1);
+	html_engine_saved (html->engine);
+	if (!html_engine_is_saved (html->engine))
+		return FALSE;
+
+	/* typing right after save must open a new step, not extend the saved one */
+	html_engine_insert_text (html->engine, "b", 1);
+	if (html_engine_is_saved (html->engine))
+		return FALSE;
+
+	html_engine_undo (html->engine);
+
+	return html_engine_is_saved (html->engine);
+}
+
+static gint test_cut_paste_shared_text (GtkHTML *html)
+{
+	HTMLObject *leaf;
+	gchar *before, *after;
+	gint ret;
+
+	load_editable (html, "hello world");
+	before = get_plain (html);
+
+	html_cursor_jump_to_position (html->engine->cursor, html->engine, 0);
+	html_engine_set_mark (html->engine);
+	html_cursor_jump_to_position (html->engine->cursor, html->engine, 5);
+	html_engine_cut (html->engine);
+
+	/* clipboard and undo share the text of the cut buffer */
+	leaf = html->engine->clipboard ? html_object_get_head_leaf (html->engine->clipboard) : NULL;
+	if (!leaf || !html_object_is_text (leaf) || !html_text_is_shared (HTML_TEXT (leaf))) {
+		g_free (before);
+		return FALSE;
+	}
+
+	html_engine_paste (html->engine);
+	after = get_plain (html);
+	ret = g_strcmp0 (before, after);
+	g_free (after);
+
+	if (ret != 0 || strcmp (HTML_TEXT (leaf)->text, "hello")) {
+		g_free (before);
+		return FALSE;
+	}
+
+	html_engine_undo (html->engine);
+	html_engine_undo (html->engine);
+	after = get_plain (html);
+	ret = g_strcmp0 (before, after);
+	g_free (before);
+	g_free (after);
+
+	return (ret == 0) ? TRUE : FALSE;
+}
+
+static gint test_buffered_save (GtkHTML *html)
+{
+	GString *direct, *buffered;
+	gchar *encoded;
+	gint ret;
+
+	encoded = html_encode_entities ("a<b>&\"c\" \xc2\xa0\xc3\xa9\x01", 100, NULL);
+	ret = strcmp (encoded, "a&lt;b&gt;&amp;&quot;c&quot; &nbsp;&#233;&#1;");
+	g_free (encoded);
+	if (ret)
+		return FALSE;
+
+	load_editable (html, "<p>one &lt;two&gt; &amp; three</p><table><tr><td>\xc3\xa9t\xc3\xa9</td></tr></table><pre>a\tb</pre>");
+
+	direct = g_string_new (NULL);
+	buffered = g_string_new (NULL);
+	html_engine_save (html->engine, plain_save_receiver, direct);
+	/* small block size forces a lot of flushes */
+	html_engine_save_buffered (html->engine, plain_save_receiver, buffered, 16);
+
+	ret = strcmp (direct->str, buffered->str);
+	g_string_free (direct, TRUE);
+	g_string_free (buffered, TRUE);
+
+	return (ret == 0) ? TRUE : FALSE;
+}
+
+static gint test_parallel_plain_save (GtkHTML *html)
+{
+	GString *serial, *parallel;
+	gint ret;
+
+	load_editable (html,
+		       "<h1>Title</h1><p>The first paragraph is long enough to be wrapped at the usual width of plain text export.</p>"
+		       "<ol><li>one</li><li>two</li></ol><blockquote type=cite>quoted text</blockquote>"
+		       "<pre>pre\tformatted</pre><table><tr><td>cell</td><td>another cell</td></tr></table>"
+		       "<p align=right>right</p><p align=center>center</p>");
+
+	serial = g_string_new (NULL);
+	parallel = g_string_new (NULL);
+	html_engine_save_plain (html->engine, plain_save_receiver, serial);
+	/* one paragraph per job */
+	html_engine_save_plain_parallel (html->engine, plain_save_receiver, parallel, 1);
+
+	ret = strcmp (serial->str, parallel->str);
+	g_string_free (serial, TRUE);
+	g_string_free (parallel, TRUE);
+
+	return (ret == 0) ? TRUE : FALSE;
+}
+
+static void
+image_url_requested (GtkHTML *html,
+                     const gchar *url,
+                     GtkHTMLStream *stream,
+                     gint *n_requests)
+{
+	GdkPixbuf *pixbuf;
+	gchar *buffer;
+	gsize size;
+
+	pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, FALSE, 8, 16, 16);
+	gdk_pixbuf_fill (pixbuf, 0xff0000ff);
+	gdk_pixbuf_save_to_buffer (pixbuf, &buffer, &size, "png", NULL, NULL);
+	gtk_html_stream_write (stream, buffer, size);
+	gtk_html_stream_close (stream, GTK_HTML_STREAM_OK);
+	g_free (buffer);
+	g_object_unref (pixbuf);
+
+	(*n_requests)++;
+}
+
+static gint test_shared_image_cache (GtkHTML *html)
+{
+	GtkHTML *other;
+	HTMLImageCacheStats stats;
+	gint n_requests = 0, i;
+	gulong id;
+	gboolean ret;
+
+	html_image_cache_clear ();
+	html_image_cache_set_max_size (1024 * 1024);
+
+	gtk_html_set_shared_images (html, TRUE);
+	id = g_signal_connect (html, "url_requested", G_CALLBACK (image_url_requested), &n_requests);
+	load_editable (html, "<img src=\"file:///shared.png\"><img src=\"file:///copy.png\">");
+
+	/* wait for the decoders */
+	for (i = 0; i < 1000; i++) {
+		html_image_cache_get_stats (&stats);
+		if (stats.n_images == 1 && stats.shared == 1)
+			break;
+		g_main_context_iteration (NULL, TRUE);
+	}
+
+	other = GTK_HTML (gtk_html_new ());
+	g_object_ref_sink (other);
+	g_signal_connect (other, "url_requested", G_CALLBACK (image_url_requested), &n_requests);
+
+	/* a widget which did not opt in still requests the image */
+	gtk_html_load_from_string (other, "<img src=\"file:///shared.png\">", -1);
+	html_image_cache_get_stats (&stats);
+	ret = n_requests == 3 && stats.hits == 0;
+
+	gtk_html_set_shared_images (other, TRUE);
+	gtk_html_load_from_string (other, "<img src=\"file:///shared.png\">", -1);
+
+	html_image_cache_get_stats (&stats);
+	ret = ret && n_requests == 3 && stats.hits == 1 && stats.n_images == 1 && stats.shared == 1
+		&& stats.size >= 16 * 16 * 3;
+
+	html_image_cache_set_max_size (0);
+	html_image_cache_get_stats (&stats);
+	ret = ret && stats.n_images == 0 && stats.evictions == 1;
+
+	g_object_unref (other);
+	g_signal_handler_disconnect (html, id);
+	gtk_html_set_shared_images (html, FALSE);
+	gtk_html_load_empty (html);
+
+	return ret;
+}
+
+static void
+lazy_url_requested (GtkHTML *html,
+                    const gchar *url,
+                    GtkHTMLStream *stream,
+                    GSList **streams)
+{
+	*streams = g_slist_prepend (*streams, stream);
+}
+
+static gint test_lazy_image_loading (GtkHTML *html)
+{
+	GSList *streams = NULL, *kept, *l;
+	gint i, n_done = 0, n_max = 0;
+	gulong id;
+	gboolean ret;
+
+	gtk_html_set_lazy_image_loading (html, TRUE, 1);
+	id = g_signal_connect (html, "url_requested", G_CALLBACK (lazy_url_requested), &streams);
+	load_editable (html, "<img src=\"file:///lazy1.png\"><img src=\"file:///lazy2.png\"><img src=\"file:///lazy3.png\">");
+
+	/* nothing is requested while parsing */
+	ret = streams == NULL;
+
+	for (i = 0; i < 1000 && n_done < 3; i++) {
+		g_main_context_iteration (NULL, TRUE);
+
+		n_max = MAX (n_max, g_slist_length (streams));
+		for (l = streams; l; l = l->next)
+			gtk_html_stream_close (l->data, GTK_HTML_STREAM_ERROR);
+		n_done += g_slist_length (streams);
+		g_slist_free (streams);
+		streams = NULL;
+	}
+
+	/* a stream left open by a replaced document doesn't block the next one */
+	load_editable (html, "<img src=\"file:///lazy4.png\">");
+	for (i = 0; i < 1000 && !streams; i++)
+		g_main_context_iteration (NULL, FALSE);
+	kept = streams;
+	streams = NULL;
+	load_editable (html, "<img src=\"file:///lazy5.png\">");
+	for (i = 0; i < 1000 && !streams; i++)
+		g_main_context_iteration (NULL, FALSE);
+	ret = ret && kept && streams;
+
+	for (l = kept; l; l = l->next)
+		gtk_html_stream_close (l->data, GTK_HTML_STREAM_ERROR);
+	for (l = streams; l; l = l->next)
+		gtk_html_stream_close (l->data, GTK_HTML_STREAM_ERROR);
+	g_slist_free (kept);
+	g_slist_free (streams);
+
+	g_signal_handler_disconnect (html, id);
+	gtk_html_set_lazy_image_loading (html, FALSE, 0);
+	gtk_html_load_empty (html);
+
+	return ret && n_done == 3 && n_max == 1;
+}
+
+static gint test_draw_queue_coalescing (GtkHTML *html)
+{
+	HTMLDrawQueue *queue;
+	HTMLObject *leaf;
+	GdkColor color = { 0, 0, 0, 0 };
+	cairo_rectangle_int_t all = { 0, 0, 20, 20 };
+	gboolean ret;
+
+	load_editable (html, "<p>text</p>");
+	leaf = html_object_get_head_leaf (html->engine->clue);
+	queue = html_draw_queue_new (html->engine);
+
+	html_draw_queue_add (queue, leaf);
+	html_draw_queue_add (queue, leaf);
+	html_draw_queue_add_clear (queue, 0, 0, 10, 20, &color);
+	html_draw_queue_add_clear (queue, 10, 0, 10, 20, &color);
+	html_draw_queue_add_clear (queue, 5, 5, 10, 10, &color);
+
+	ret = g_list_length (queue->elems) == 1 && leaf->redraw_pending && queue->n_clears == 3
+		&& cairo_region_num_rectangles (queue->clear_region) == 1
+		&& cairo_region_contains_rectangle (queue->clear_region, &all) == CAIRO_REGION_OVERLAP_IN;
+
+	html_draw_queue_clear (queue);
+	ret = ret && queue->elems == NULL && queue->clear_region == NULL && queue->n_clears == 0 && !leaf->redraw_pending;
+
+	html_draw_queue_destroy (queue);
+
+	return ret;
+}
+
+static gint test_cursor_position_index (GtkHTML *html)
+{
+	GString *doc;
+	GArray *steps;
+	HTMLCursor cursor;
+	gboolean ret = TRUE;
+	guint i;
+
+	doc = g_string_new (NULL);
+	for (i = 0; i < 60; i++) {
+		g_string_append_printf (doc, "<p>paragraph %d with <b>bold</b> and <i>italic</i> words</p>", i);
+		if (i % 20 == 5)
+			g_string_append (doc, "<ul><li>first item</li><li>second item</li></ul>");
+		if (i % 20 == 10)
+			g_string_append (doc, "<div>division text</div><hr>");
+		if (i % 20 == 15)
+			g_string_append (doc, "<table><tr><td>cell</td><td>another cell</td></tr></table>");
+	}
+	load_editable (html, doc->str);
+	g_string_free (doc, TRUE);
+
+	/* remember every place the step by step movement visits */
+	steps = g_array_new (FALSE, FALSE, sizeof (HTMLCursor));
+	html_cursor_home (html->engine->cursor, html->engine);
+	html_cursor_copy (&cursor, html->engine->cursor);
+	do {
+		html_cursor_normalize (&cursor);
+		g_array_append_val (steps, cursor);
+	} while (html_cursor_forward (&cursor, html->engine));
+
+	for (i = 0; i < steps->len && ret; i += 7) {
+		HTMLCursor *step = &g_array_index (steps, HTMLCursor, i);
+
+		html_cursor_home (html->engine->cursor, html->engine);
+		html_cursor_jump_to_position (html->engine->cursor, html->engine, step->position);
+		html_cursor_normalize (html->engine->cursor);
+		ret = html->engine->cursor->object == step->object && html->engine->cursor->offset == step->offset;
+
+		html_cursor_home (html->engine->cursor, html->engine);
+		ret = ret && html_cursor_jump_to (html->engine->cursor, html->engine, step->object, step->offset)
+			&& html->engine->cursor->position == step->position;
+	}
+
+	/* the index follows edits before the target */
+	if (ret) {
+		HTMLCursor *last = &g_array_index (steps, HTMLCursor, steps->len - 1);
+
+		html_cursor_home (html->engine->cursor, html->engine);
+		html_engine_insert_text (html->engine, "x", 1);
+		html_cursor_home (html->engine->cursor, html->engine);
+		ret = html_cursor_jump_to (html->engine->cursor, html->engine, last->object, last->offset)
+			&& html->engine->cursor->position == last->position + 1;
+	}
+
+	g_array_free (steps, TRUE);
+
+	return ret;
+}
+
+static gboolean
+recursive_lengths_consistent (GtkHTML *html)
+{
+	/* fill the caches, then compare them with the tree */
+	html_object_get_recursive_length (html->engine->clue);
+
+	return gtk_html_debug_check_recursive_lengths (html->engine->clue);
+}
+
+static gint test_cached_recursive_lengths (GtkHTML *html)
+{
+	gboolean ret;
+	gint end;
+
+	load_editable (html, "<p>first paragraph</p><p>second paragraph</p>"
+		       "<table><tr><td>cell</td><td>another cell</td></tr></table>"
+		       "<p>last paragraph</p>");
+	ret = recursive_lengths_consistent (html);
+
+	html_cursor_end_of_document (html->engine->cursor, html->engine);
+	end = html->engine->cursor->position;
+	html_engine_insert_text (html->engine, " grows", 6);
+	ret = ret && recursive_lengths_consistent (html);
+
+	html_engine_insert_empty_paragraph (html->engine);
+	html_engine_insert_text (html->engine, "new", 3);
+	ret = ret && recursive_lengths_consistent (html);
+
+	html_cursor_jump_to_position (html->engine->cursor, html->engine, 3);
+	html_engine_set_mark (html->engine);
+	html_cursor_jump_to_position (html->engine->cursor, html->engine, end);
+	html_engine_cut (html->engine);
+	ret = ret && recursive_lengths_consistent (html);
+
+	html_engine_undo (html->engine);
+	ret = ret && recursive_lengths_consistent (html);
+
+	html_engine_paste (html->engine);
+	ret = ret && recursive_lengths_consistent (html);
+
+	return ret;
+}
+
+static void
+build_document (GtkHTML *html)
+{
+	gint i;
+
+	for (i = 0; i < 3; i++) {
+		html_engine_insert_empty_paragraph (html->engine);
+		html_engine_insert_text (html->engine, "paragraph", 9);
+		html_engine_insert_text (html->engine, " ", 1);
+		html_engine_insert_text (html->engine, "with some words", 15);
+	}
+}
+
+static gint test_batch_edit (GtkHTML *html)
+{
+	gchar *before, *direct, *batched, *undone;
+	guint freeze_count;
+	gint ret;
+
+	load_editable (html, "text");
+	html_engine_end_of_document (html->engine);
+	build_document (html);
+	direct = get_plain (html);
+
+	load_editable (html, "text");
+	html_engine_end_of_document (html->engine);
+	before = get_plain (html);
+	freeze_count = html->engine->freeze_count;
+
+	gtk_html_begin_batch_edit (html);
+	gtk_html_begin_batch_edit (html);
+	build_document (html);
+	gtk_html_commit_batch_edit (html);
+	ret = html->engine->freeze_count > freeze_count;
+	gtk_html_commit_batch_edit (html);
+	batched = get_plain (html);
+
+	/* the whole batch is reverted by a single undo */
+	html_engine_undo (html->engine);
+	undone = get_plain (html);
+
+	ret = ret && html->engine->batch_level == 0
+		&& !g_strcmp0 (direct, batched)
+		&& !g_strcmp0 (before, undone);
+
+	g_free (before);
+	g_free (direct);
+	g_free (batched);
+	g_free (undone);
+
+	return ret;
+}
+
+static gint test_paste_multiline_text (GtkHTML *html)
+{
+	static const gchar *lines[] = { " first line", "", "third line with some words", "last" };
+	gchar *before, *per_line, *bulk, *undone;
+	gboolean magic_links;
+	gint i, ret;
+
+	/* insert line by line, the way typing does */
+	load_editable (html, "hello world");
+	html_cursor_jump_to_position (html->engine->cursor, html->engine, 5);
+	for (i = 0; i < G_N_ELEMENTS (lines); i++) {
+		if (i)
+			html_engine_insert_empty_paragraph (html->engine);
+		if (*lines[i])
+			html_engine_insert_text (html->engine, lines[i], -1);
+	}
+	per_line = get_plain (html);
+
+	load_editable (html, "hello world");
+	html_cursor_jump_to_position (html->engine->cursor, html->engine, 5);
+	before = get_plain (html);
+	html_engine_paste_text (html->engine, " first line\n\nthird line with some words\nlast", -1);
+	bulk = get_plain (html);
+
+	ret = !g_strcmp0 (per_line, bulk)
+		&& html->engine->cursor->position == 5 + 44
+		&& recursive_lengths_consistent (html);
+
+	html_engine_undo (html->engine);
+	undone = get_plain (html);
+	ret = ret && !g_strcmp0 (before, undone);
+
+	/* URLs ending a line are linked, like after typing the newline */
+	magic_links = gtk_html_get_magic_links (html);
+	gtk_html_set_magic_links (html, TRUE);
+	load_editable (html, "");
+	html_engine_paste_text (html->engine, "see www.gnome.org\nand www.gnu.org", -1);
+	ret = ret && html_text_get_n_links (HTML_TEXT (html_object_get_head_leaf (html->engine->clue))) == 1
+		&& html_text_get_n_links (HTML_TEXT (html_object_get_tail_leaf (html->engine->clue))) == 0;
+	gtk_html_set_magic_links (html, magic_links);
+
+	g_free (before);
+	g_free (per_line);
+	g_free (bulk);
+	g_free (undone);
+
+	return ret;
+}
+
+static gint test_magic_links_scan (GtkHTML *html)
+{
+	static const struct {
+		gint start, end;
+		const gchar *url;
+	} expected[] = {
+		{ 4, 17, "http://www.gnome.org" },
+		{ 24, 38, "mailto:me@example.com" },
+		{ 42, 58, "http://x.org/a.b" },
+		{ 75, 93, "ftp://ftp.gnu.org:21/pub" }
+	};
+	HTMLColor *color;
+	HTMLText *text;
+	Link *link;
+	gboolean ret;
+	gint i;
+
+	color = html_color_new ();
+	text = HTML_TEXT (html_text_new ("see www.gnome.org, mail me@example.com or http://x.org/a.b then caf\xc3\xa9@x.com ftp.gnu.org:21/pub",
+					 GTK_HTML_FONT_STYLE_DEFAULT, color));
+	html_color_unref (color);
+
+	ret = html_text_magic_links (text, html->engine)
+		&& html_text_get_n_links (text) == G_N_ELEMENTS (expected);
+
+	for (i = 0; ret && i < G_N_ELEMENTS (expected); i++) {
+		link = html_text_get_nth_link (text, i);
+		ret = link->start_offset == expected[i].start
+			&& link->end_offset == expected[i].end
+			&& !g_strcmp0 (link->url, expected[i].url);
+	}
+
+	html_object_destroy (HTML_OBJECT (text));
+
+	return ret;
+}
+
+static gint test_print_snapshot (GtkHTML *html)
+{
+	GtkPrintOperation *operation;
+	GtkPrintOperationResult result;
+	HTMLPainter *painter;
+	HTMLObject *text, *slave;
+	gchar *filename;
+	gint fd;
+	gboolean ret;
+
+	load_editable (html, "<p>a paragraph long enough to be split into several lines when printed</p><p>and another one</p>");
+	html_engine_calc_size (html->engine, NULL);
+	painter = html->engine->painter;
+	text = html_object_get_head_leaf (html->engine->clue);
+	slave = text->next;
+
+	fd = g_file_open_tmp ("gtkhtml-print-XXXXXX.pdf", &filename, NULL);
+	if (fd == -1)
+		return FALSE;
+	close (fd);
+
+	operation = gtk_print_operation_new ();
+	gtk_print_operation_set_export_filename (operation, filename);
+	result = gtk_html_print_operation_run (html, operation, GTK_PRINT_OPERATION_ACTION_EXPORT,
+					       NULL, NULL, NULL, NULL, NULL, NULL, NULL);
+	g_object_unref (operation);
+	g_unlink (filename);
+	g_free (filename);
+
+	/* the snapshot is laid out instead of the live tree */
+	ret = result == GTK_PRINT_OPERATION_RESULT_APPLY
+		&& html->engine->painter == painter
+		&& html_object_get_head_leaf (html->engine->clue) == text
+		&& text->next == slave;
+
+	return ret;
+}
+
+static gchar *
+tmp_pdf_filename (void)
+{
+	gchar *filename;
+	gint fd;
+
+	fd = g_file_open_tmp ("gtkhtml-render-XXXXXX.pdf", &filename, NULL);
+	if (fd == -1)
+		return NULL;
+	close (fd);
+
+	return filename;
+}
+
+static gint test_render_pdf_batch (GtkHTML *html)
+{
+	GString *doc;
+	const gchar *srcs[3];
+	gchar *filenames[3];
+	gchar *contents = NULL;
+	gint n_pages[3], single, i;
+	gboolean ret;
+
+	doc = g_string_new (NULL);
+	for (i = 0; i < 200; i++)
+		g_string_append_printf (doc, "<p>paragraph %d of a document long enough for several pages</p>", i);
+
+	srcs[0] = doc->str;
+	srcs[1] = "<h1>one page</h1>";
+	srcs[2] = doc->str;
+	for (i = 0; i < 3; i++)
+		filenames[i] = tmp_pdf_filename ();
+
+	single = gtk_html_render_pdf (doc->str, doc->len, filenames[0], 595, 842);
+	ret = single > 1
+		&& g_file_get_contents (filenames[0], &contents, NULL, NULL)
+		&& g_str_has_prefix (contents, "%PDF");
+	g_free (contents);
+
+	/* the batch gives every document its own page count */
+	ret = ret && gtk_html_render_pdf_batch (srcs, (const gchar * const *) filenames, 3, 595, 842, n_pages)
+		&& n_pages[0] == single && n_pages[1] == 1 && n_pages[2] == single;
+
+	for (i = 0; i < 3; i++) {
+		g_unlink (filenames[i]);
+		g_free (filenames[i]);
+	}
+	g_string_free (doc, TRUE);
+
+	return ret;
+}
+
+static gboolean
+page_split_index_matches_walk (GtkHTML *html,
+                               const gchar *doc)
+{
+	GArray *index;
+	HTMLObject *clue;
+	HTMLPainter *painter;
+	gint y, height;
+	gboolean ret = TRUE;
+
+	load_editable (html, doc);
+	html_engine_calc_size (html->engine, NULL);
+
+	clue = html->engine->clue;
+	painter = html->engine->painter;
+	height = clue->ascent + clue->descent;
+	index = html_object_get_page_split_index (clue, painter);
+
+	/* the index gives every split the tree walk gives */
+	for (y = 0; ret && y < height + 10; y++)
+		ret = html_object_check_page_split_index (index, y) == html_object_check_page_split (clue, painter, y);
+
+	g_array_free (index, TRUE);
+
+	return ret;
+}
+
+static gint test_page_split_index (GtkHTML *html)
+{
+	GString *doc;
+	gint i;
+	gboolean ret;
+
+	doc = g_string_new (NULL);
+	for (i = 0; i < 50; i++)
+		g_string_append_printf (doc, "<p>paragraph %d, long enough to be wrapped to a few lines in the test window</p>", i);
+	ret = page_split_index_matches_walk (html, doc->str);
+
+	/* tables, nested clues and iframes add their own ranges */
+	g_string_assign (doc, "<p>before</p><table border=1><tr><td>short</td><td>");
+	for (i = 0; i < 10; i++)
+		g_string_append_printf (doc, "line %d of a tall cell<br>", i);
+	g_string_append (doc, "</td></tr><tr><td colspan=2>second row</td></tr></table><p>after</p>");
+	ret = ret && page_split_index_matches_walk (html, doc->str);
+
+	g_string_truncate (doc, 0);
+	for (i = 0; i < 10; i++)
+		g_string_append_printf (doc, "<div><blockquote><p>nested paragraph %d, long enough to be wrapped to a few lines</p></blockquote></div>", i);
+	ret = ret && page_split_index_matches_walk (html, doc->str);
+
+	ret = ret && page_split_index_matches_walk (html, "<p>before</p><iframe src=\"\" width=200 height=150></iframe><p>after</p>");
+
+	g_string_free (doc, TRUE);
+
+	return ret;
+}
+
+typedef struct {
+	gint n_images;
+	gint n_pages;
+	gboolean in_order;
+	gboolean done;
+} PageImages;
+
+static void
+page_image_received (GtkHTML *html,
+                     gint page_nr,
+                     cairo_surface_t *image,
+                     gpointer user_data)
+{
+	PageImages *pi = user_data;
+
+	if (image == NULL) {
+		pi->n_pages = page_nr;
+		pi->done = TRUE;
+		return;
+	}
+
+	pi->in_order = pi->in_order && page_nr == pi->n_images
+		&& cairo_image_surface_get_width (image) == 149
+		&& cairo_image_surface_get_height (image) == 211;
+	pi->n_images++;
+}
+
+static gint test_page_images (GtkHTML *html)
+{
+	GString *doc;
+	PageImages pi = { 0, -1, TRUE, FALSE };
+	GTimer *timer;
+	gint i;
+
+	doc = g_string_new (NULL);
+	for (i = 0; i < 200; i++)
+		g_string_append_printf (doc, "<p>paragraph %d of a document long enough for several pages</p>", i);
+
+	load_editable (html, doc->str);
+	g_string_free (doc, TRUE);
+
+	gtk_html_render_page_images (html, 595, 842, 0.25, page_image_received, &pi);
+
+	timer = g_timer_new ();
+	while (!pi.done && g_timer_elapsed (timer, NULL) < 30)
+		g_main_context_iteration (NULL, TRUE);
+	g_timer_destroy (timer);
+
+	return pi.done && pi.in_order && pi.n_pages > 1 && pi.n_images == pi.n_pages;
+}
+
+static GString *
+selection_state (GPtrArray *leaves)
+{
+	GString *state = g_string_new (NULL);
+	guint i;
+
+	for (i = 0; i < leaves->len; i++) {
+		HTMLObject *o = g_ptr_array_index (leaves, i);
+
+		g_string_append_printf (state, "%d", o->selected);
+		if (HTML_IS_TEXT (o) && o->selected)
+			g_string_append_printf (state, "(%d,%d)", HTML_TEXT (o)->select_start, HTML_TEXT (o)->select_length);
+	}
+
+	return state;
+}
+
+static gint test_differential_selection (GtkHTML *html)
+{
+	/* anchor, end: leaf index and offset */
+	static const gint moves[][4] = {
+		{ 10, 3, 14, 2 }, { 10, 3, 20, 4 }, { 10, 3, 12, 0 }, { 10, 3, 10, 4 },
+		{ 10, 3, 10, 1 }, { 10, 3, 4, 2 }, { 10, 3, 1, 0 }, { 10, 3, 18, 3 },
+		{ 6, 2, 18, 3 }, { 16, 1, 22, 2 }, { 2, 0, 8, 4 }, { 2, 0, 24, 1 }
+	};
+	GString *doc;
+	GPtrArray *leaves;
+	HTMLObject *o;
+	gboolean ret;
+	guint i;
+
+	doc = g_string_new (NULL);
+	for (i = 0; i < 10; i++)
+		g_string_append_printf (doc, "<p>alpha %d <b>beta</b> gamma</p>", i);
+	load_editable (html, doc->str);
+	g_string_free (doc, TRUE);
+
+	leaves = g_ptr_array_new ();
+	for (o = html_object_get_head_leaf (html->engine->clue); o; o = html_object_next_leaf (o))
+		if (HTML_IS_TEXT (o))
+			g_ptr_array_add (leaves, o);
+
+	ret = leaves->len >= 25;
+	html_engine_unselect_all (html->engine);
+	for (i = 0; i < G_N_ELEMENTS (moves) && ret; i++) {
+		HTMLInterval *sel;
+		GString *updated, *fresh;
+
+		sel = html_interval_new (g_ptr_array_index (leaves, moves[i][0]), g_ptr_array_index (leaves, moves[i][2]),
+					 moves[i][1], moves[i][3]);
+		html_interval_validate (sel);
+
+		/* the update from the previous selection has to match a selection made from scratch */
+		html_engine_select_interval (html->engine, html_interval_new_from_points (&sel->from, &sel->to));
+		updated = selection_state (leaves);
+		html_engine_unselect_all (html->engine);
+		html_engine_select_interval (html->engine, html_interval_new_from_points (&sel->from, &sel->to));
+		fresh = selection_state (leaves);
+
+		ret = !strcmp (updated->str, fresh->str);
+
+		g_string_free (updated, TRUE);
+		g_string_free (fresh, TRUE);
+		html_interval_destroy (sel);
+	}
+
+	html_engine_unselect_all (html->engine);
+	g_ptr_array_free (leaves, TRUE);
+
+	return ret;
+}
+
 gint main (gint argc, gchar *argv[])
 {
 	GtkWidget *win, *sw, *html_widget;